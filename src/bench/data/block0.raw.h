@@ -0,0 +1,40 @@
+static unsigned const char block0_raw[] = {
+0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+0x00, 0x00, 0x00, 0x00, 0xd8, 0xad, 0x35, 0x6f, 
+0xdb, 0xa8, 0x73, 0x52, 0x43, 0xa7, 0xd8, 0xbe, 
+0x5e, 0xfc, 0x92, 0x48, 0x9c, 0xb3, 0x9f, 0xff, 
+0xdd, 0x43, 0x8e, 0x07, 0x8e, 0x8f, 0xed, 0x85, 
+0x86, 0xc0, 0xb6, 0x9a, 0x00, 0x08, 0xbd, 0x67, 
+0xff, 0xff, 0x0a, 0x1f, 0x00, 0x00, 0x00, 0x00, 
+0x52, 0x0b, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+0x1d, 0xe8, 0x35, 0x7b, 0xc6, 0xf4, 0x0e, 0x4f, 
+0x05, 0xa7, 0x71, 0x14, 0x66, 0x26, 0x31, 0xa2, 
+0x7d, 0x85, 0xfd, 0x22, 0xef, 0xf0, 0x2d, 0x68, 
+0x1e, 0xa2, 0x75, 0x74, 0x8d, 0x6b, 0x23, 0xf2, 
+0x01, 0x01, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 
+0xff, 0xff, 0x61, 0x00, 0x04, 0xff, 0xff, 0x0a, 
+0x1f, 0x01, 0x04, 0x4c, 0x57, 0x54, 0x68, 0x65, 
+0x20, 0x54, 0x69, 0x6d, 0x65, 0x73, 0x20, 0x2d, 
+0x20, 0x32, 0x35, 0x2f, 0x46, 0x65, 0x62, 0x2f, 
+0x32, 0x30, 0x32, 0x34, 0x20, 0x2d, 0x20, 0x54, 
+0x72, 0x75, 0x6d, 0x70, 0x20, 0x74, 0x6f, 0x75, 
+0x74, 0x73, 0x20, 0x70, 0x65, 0x61, 0x63, 0x65, 
+0x20, 0x69, 0x6e, 0x20, 0x55, 0x6b, 0x72, 0x61, 
+0x69, 0x6e, 0x65, 0x20, 0x77, 0x69, 0x74, 0x68, 
+0x69, 0x6e, 0x20, 0x77, 0x65, 0x65, 0x6b, 0x73, 
+0x20, 0x61, 0x73, 0x20, 0x68, 0x65, 0x20, 0x6d, 
+0x65, 0x65, 0x74, 0x73, 0x20, 0x4d, 0x61, 0x63, 
+0x72, 0x6f, 0x6e, 0x2e, 0xff, 0xff, 0xff, 0xff, 
+0x01, 0x00, 0x88, 0x52, 0x6a, 0x74, 0x00, 0x00, 
+0x00, 0x19, 0x76, 0xa9, 0x14, 0x01, 0x60, 0xd4, 
+0x00, 0x54, 0x5e, 0x14, 0xa1, 0xde, 0x78, 0xe2, 
+0x55, 0xc4, 0xf3, 0xdb, 0xe9, 0x0d, 0xa6, 0x49, 
+0xbf, 0x88, 0xac, 0x00, 0x00, 0x00, 0x00, 
+};
@@ -0,0 +1,226 @@
+// Copyright (c) 2024 The Griffion Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <chainparams.h>
+#include <consensus/validation.h>
+#include <crypto/ethash/include/ethash/ethash.hpp>
+#include <crypto/ethash/include/ethash/keccak.h>
+#include <crypto/ethash/include/ethash/progpow.hpp>
+#include <crypto/ethash/lib/ethash/ethash-internal.hpp>
+#include <hash.h>
+#include <pow.h>
+#include <primitives/block.h>
+#include <random.h>
+#include <uint256.h>
+#include <util/chaintype.h>
+#include <validation.h>
+
+#include <cassert>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <vector>
+
+// Proof-of-work checks of headers with the easiest target, as on regtest.
+static constexpr unsigned int EASY_BITS{0x207fffff};
+
+static ethash::hash256 RandomHash256(FastRandomContext& rng)
+{
+    const uint256 random{rng.rand256()};
+    ethash::hash256 hash;
+    std::memcpy(hash.bytes, random.begin(), sizeof(hash.bytes));
+    return hash;
+}
+
+static ethash::hash256 MaxBoundary()
+{
+    ethash::hash256 boundary;
+    std::memset(boundary.bytes, 0xff, sizeof(boundary.bytes));
+    return boundary;
+}
+
+/** Mines a header at the given height against the easy target. */
+static CBlockHeader MineHeader(int height, const uint256& prev_hash, const Consensus::Params& params)
+{
+    CBlockHeader header;
+    header.nVersion = 4;
+    header.hashPrevBlock = prev_hash;
+    header.nTime = 1700000000 + height * 60;
+    header.nBits = EASY_BITS;
+    header.nHeight = height;
+    for (header.nNonce = 0;; ++header.nNonce) {
+        uint256 mix;
+        const uint256 hash{header.GetHash(mix)};
+        if (CheckProofOfWork(hash, header.nBits, params)) {
+            header.hashMix = mix;
+            return header;
+        }
+    }
+}
+
+/** Mines a chain of headers spanning the boundary between epochs 0 and 1. */
+static std::vector<CBlockHeader> MineEpochBoundaryChain(const Consensus::Params& params)
+{
+    std::vector<CBlockHeader> headers;
+    uint256 prev_hash;
+    for (int height = ethash::epoch_length - 8; height < ethash::epoch_length + 8; ++height) {
+        headers.push_back(MineHeader(height, prev_hash, params));
+        prev_hash = headers.back().GetHash();
+    }
+    return headers;
+}
+
+static void ProgPowHashLight(benchmark::Bench& bench)
+{
+    FastRandomContext rng(/*fDeterministic=*/true);
+    const auto& context = ethash::get_global_epoch_context(0);
+    const ethash::hash256 header_hash{RandomHash256(rng)};
+    uint64_t nonce{0};
+    bench.unit("hash").run([&] {
+        const auto result = progpow::hash(context, 0, header_hash, nonce++);
+        ankerl::nanobench::doNotOptimizeAway(result);
+    });
+}
+
+static void ProgPowHashFull(benchmark::Bench& bench)
+{
+    // The dataset items are generated on first use and reused afterwards,
+    // so the warmup leaves the hashes mostly reading the dataset.
+    FastRandomContext rng(/*fDeterministic=*/true);
+    const auto& context = ethash::get_global_epoch_context_full(0);
+    const ethash::hash256 header_hash{RandomHash256(rng)};
+    uint64_t nonce{0};
+    bench.unit("hash").warmup(1000).run([&] {
+        const auto result = progpow::hash(context, 0, header_hash, nonce++ % 1000);
+        ankerl::nanobench::doNotOptimizeAway(result);
+    });
+}
+
+static void ProgPowVerify(benchmark::Bench& bench)
+{
+    FastRandomContext rng(/*fDeterministic=*/true);
+    const auto& context = ethash::get_global_epoch_context(0);
+    const ethash::hash256 header_hash{RandomHash256(rng)};
+    const ethash::hash256 boundary{MaxBoundary()};
+    const auto result = progpow::hash(context, 0, header_hash, 0);
+    bench.unit("header").run([&] {
+        const bool valid{progpow::verify(context, 0, header_hash, result.hashMix, 0, boundary)};
+        assert(valid);
+    });
+}
+
+static void ProgPowHashNoVerify(benchmark::Bench& bench)
+{
+    FastRandomContext rng(/*fDeterministic=*/true);
+    const ethash::hash256 header_hash{RandomHash256(rng)};
+    const ethash::hash256 mix{RandomHash256(rng)};
+    uint64_t nonce{0};
+    bench.unit("hash").run([&] {
+        const auto hash = progpow::hash_no_verify(0, header_hash, mix, nonce++);
+        ankerl::nanobench::doNotOptimizeAway(hash);
+    });
+}
+
+static void ProgPowHashNoVerify8Way(benchmark::Bench& bench)
+{
+    FastRandomContext rng(/*fDeterministic=*/true);
+    ethash::hash256 header_hashes[8], mixes[8], hashes[8];
+    uint64_t nonces[8];
+    for (int i = 0; i < 8; ++i) {
+        header_hashes[i] = RandomHash256(rng);
+        mixes[i] = RandomHash256(rng);
+        nonces[i] = rng.rand64();
+    }
+    bench.batch(8).unit("hash").run([&] {
+        progpow::hash_no_verify_8way(header_hashes, mixes, nonces, hashes);
+        ++nonces[0];
+        ankerl::nanobench::doNotOptimizeAway(hashes);
+    });
+}
+
+static void EthashCreateEpochContext(benchmark::Bench& bench)
+{
+    bench.unit("epoch").epochs(1).epochIterations(3).run([&] {
+        const auto context = ethash::create_epoch_context(0);
+        assert(context);
+    });
+}
+
+static void EthashBuildLightCache(benchmark::Bench& bench)
+{
+    const int num_items{ethash::calculate_light_cache_num_items(0)};
+    const ethash::hash256 seed{ethash::calculate_epoch_seed(0)};
+    std::vector<ethash::hash512> cache(num_items);
+    bench.unit("epoch").epochs(1).epochIterations(3).run([&] {
+        ethash::build_light_cache(cache.data(), num_items, seed);
+    });
+}
+
+static void KeccakF800(benchmark::Bench& bench)
+{
+    uint32_t state[25]{};
+    bench.unit("permutation").run([&] {
+        ethash_keccakf800(state);
+    });
+}
+
+static void KeccakF800_8Way(benchmark::Bench& bench)
+{
+    uint32_t states[8][25]{};
+    bench.batch(8).unit("permutation").run([&] {
+        ethash_keccakf800_8way(states);
+    });
+}
+
+static void CheckBlockHeaderPow(benchmark::Bench& bench)
+{
+    const auto chain_params = CreateChainParams(ChainType::REGTEST);
+    const Consensus::Params& params{chain_params->GetConsensus()};
+    const CBlockHeader header{MineHeader(1, uint256{}, params)};
+    std::optional<BlockValidationState> state;
+    bench.unit("header").run([&] {
+        const bool valid{CPowCheck{header, params, state}()};
+        assert(valid);
+    });
+}
+
+static void CheckHeaderChainPow(benchmark::Bench& bench)
+{
+    // The headers use the light caches of two epochs, as a node syncing
+    // across the boundary does.
+    const auto chain_params = CreateChainParams(ChainType::REGTEST);
+    const Consensus::Params& params{chain_params->GetConsensus()};
+    const std::vector<CBlockHeader> headers{MineEpochBoundaryChain(params)};
+    std::optional<BlockValidationState> state;
+    bench.batch(headers.size()).unit("header").run([&] {
+        for (const CBlockHeader& header : headers) {
+            const bool valid{CPowCheck{header, params, state}()};
+            assert(valid);
+        }
+    });
+}
+
+static void HashHeaderChain(benchmark::Bench& bench)
+{
+    const auto chain_params = CreateChainParams(ChainType::REGTEST);
+    const std::vector<CBlockHeader> headers{MineEpochBoundaryChain(chain_params->GetConsensus())};
+    bench.batch(headers.size()).unit("header").run([&] {
+        const std::vector<uint256> hashes{ETHash(headers)};
+        ankerl::nanobench::doNotOptimizeAway(hashes);
+    });
+}
+
+BENCHMARK(ProgPowHashLight, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ProgPowHashFull, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ProgPowVerify, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ProgPowHashNoVerify, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ProgPowHashNoVerify8Way, benchmark::PriorityLevel::HIGH);
+BENCHMARK(EthashCreateEpochContext, benchmark::PriorityLevel::HIGH);
+BENCHMARK(EthashBuildLightCache, benchmark::PriorityLevel::HIGH);
+BENCHMARK(KeccakF800, benchmark::PriorityLevel::HIGH);
+BENCHMARK(KeccakF800_8Way, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CheckBlockHeaderPow, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CheckHeaderChainPow, benchmark::PriorityLevel::HIGH);
+BENCHMARK(HashHeaderChain, benchmark::PriorityLevel::HIGH);
@@ -9,6 +9,8 @@
 
 #include <bench/bench.h>
 #include <key.h>
+#include <pubkey.h>
+#include <random.h>
 #if defined(HAVE_CONSENSUS_LIB)
 #include <script/griffionconsensus.h>
 #endif
@@ -18,6 +20,7 @@
 #include <test/util/transaction_utils.h>
 
 #include <array>
+#include <vector>
 
 // Microbenchmark for verification of a basic P2WPKH script. Can be easily
 // modified to measure performance of other types of scripts.
@@ -100,5 +103,55 @@ static void VerifyNestedIfScript(benchmark::Bench& bench)
     });
 }
 
+/** Signs 500 random messages with different keys, as the key path spends of a block would. */
+static void SignSchnorrBatch(std::vector<XOnlyPubKey>& pubkeys, std::vector<uint256>& msgs, std::vector<std::array<unsigned char, 64>>& sigs)
+{
+    FastRandomContext rng{/*fDeterministic=*/true};
+    for (int i = 0; i < 500; ++i) {
+        CKey key;
+        key.MakeNewKey(true);
+        pubkeys.emplace_back(key.GetPubKey());
+        msgs.push_back(rng.rand256());
+        bool ok = key.SignSchnorr(msgs.back(), sigs.emplace_back(), nullptr, rng.rand256());
+        assert(ok);
+    }
+}
+
+static void VerifySchnorrIndividually(benchmark::Bench& bench)
+{
+    ECC_Start();
+    std::vector<XOnlyPubKey> pubkeys;
+    std::vector<uint256> msgs;
+    std::vector<std::array<unsigned char, 64>> sigs;
+    SignSchnorrBatch(pubkeys, msgs, sigs);
+    bench.batch(sigs.size()).unit("signature").run([&] {
+        for (size_t i = 0; i < sigs.size(); ++i) {
+            bool ok = pubkeys[i].VerifySchnorr(msgs[i], sigs[i]);
+            assert(ok);
+        }
+    });
+    ECC_Stop();
+}
+
+static void VerifySchnorrBatch(benchmark::Bench& bench)
+{
+    ECC_Start();
+    std::vector<XOnlyPubKey> pubkeys;
+    std::vector<uint256> msgs;
+    std::vector<std::array<unsigned char, 64>> sigs;
+    SignSchnorrBatch(pubkeys, msgs, sigs);
+    SchnorrSignatureBatch batch;
+    bench.batch(sigs.size()).unit("signature").run([&] {
+        for (size_t i = 0; i < sigs.size(); ++i) {
+            batch.Add(pubkeys[i], msgs[i], sigs[i]);
+        }
+        bool ok = batch.Verify();
+        assert(ok);
+    });
+    ECC_Stop();
+}
+
 BENCHMARK(VerifyScriptBench, benchmark::PriorityLevel::HIGH);
 BENCHMARK(VerifyNestedIfScript, benchmark::PriorityLevel::HIGH);
+BENCHMARK(VerifySchnorrIndividually, benchmark::PriorityLevel::HIGH);
+BENCHMARK(VerifySchnorrBatch, benchmark::PriorityLevel::HIGH);
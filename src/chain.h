@@ -140,6 +140,13 @@ enum BlockStatus : uint32_t {
      * should not be used elsewhere.
      */
     BLOCK_ASSUMED_VALID      =   256,
+
+    //! The ProgPoW mix of the header was fully verified, so it does not have to
+    //! be recomputed when the block is connected or the index is loaded.
+    BLOCK_POW_VERIFIED       =   512,
+
+    //! The undo data in rev*.dat is stored in the compact encoding of CompactBlockUndo.
+    BLOCK_UNDO_COMPACT       =   1024,
 };
 
 /** The block chain is a tree shaped structure starting with the
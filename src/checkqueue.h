@@ -11,23 +11,85 @@
 #include <util/threadnames.h>
 
 #include <algorithm>
-#include <iterator>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
+/**
+ * A check that can leave part of its verification to a batch of type T::Batch,
+ * which is verified at once by Verify() after a thread ran several checks.
+ */
+template <typename T>
+concept BatchableCheck = std::default_initializable<typename T::Batch> && requires(T check, typename T::Batch& batch) {
+    { check(batch) } -> std::convertible_to<bool>;
+    { batch.Verify() } -> std::convertible_to<bool>;
+};
+
+/** The batch used by the checks of type T, or one that defers nothing. */
+template <typename T>
+struct CheckBatch {
+    struct type {
+        bool Verify() { return true; }
+    };
+};
+
+template <BatchableCheck T>
+struct CheckBatch<T> {
+    using type = typename T::Batch;
+};
+
 /**
  * Queue for verifications that have to be performed.
   * The verifications are represented by a type T, which must provide an
-  * operator(), returning a bool.
+  * operator(), returning a bool. If T is a BatchableCheck, each thread runs
+  * the checks it claims against its own batch instead, and only reports
+  * them as completed once the batch verified.
   *
   * One thread (the master) is assumed to push batches of verifications
   * onto the queue, where they are processed by N-1 worker threads. When
   * the master is done adding work, it temporarily joins the worker pool
   * as an N'th worker, until all jobs are done.
+  *
+  * Each added batch is appended to a list, and threads claim runs of
+  * checks from the oldest batch that has unclaimed ones by advancing its
+  * atomic cursor, so handing out work takes no lock. The length of the
+  * runs adapts to the observed cost of a check. The mutex is only taken
+  * to put idle threads to sleep and to wake them up.
+  *
+  * Checks of other types can be run by the same threads with AddTasks(),
+  * so that each kind of check does not need a thread pool of its own.
   */
 template <typename T>
 class CCheckQueue
 {
 private:
+    //! How long a run of checks claimed at once should take to verify.
+    static constexpr std::chrono::nanoseconds TARGET_RUN_TIME{std::chrono::microseconds{100}};
+
+    /** A batch of checks passed to Add() or AddTasks(). */
+    struct Batch {
+        std::vector<T> m_checks;
+        //! Verifies the i-th check instead, for batches passed to AddTasks().
+        std::function<bool(size_t)> m_task;
+        //! The number of checks.
+        const size_t m_size;
+        //! Index of the first check no thread has claimed yet. Can exceed the number of checks.
+        alignas(64) std::atomic<size_t> m_claimed{0};
+        //! The batch added after this one.
+        std::atomic<Batch*> m_next{nullptr};
+
+        explicit Batch(std::vector<T>&& checks) : m_checks{std::move(checks)}, m_size{m_checks.size()} {}
+        Batch(size_t count, std::function<bool(size_t)>&& task) : m_task{std::move(task)}, m_size{count} {}
+    };
+
     //! Mutex to protect the inner state
     Mutex m_mutex;
 
@@ -37,90 +99,185 @@ private:
     //! Master thread blocks on this when out of work
     std::condition_variable m_master_cv;
 
-    //! The queue of elements to be processed.
-    //! As the order of booleans doesn't matter, it is used as a LIFO (stack)
-    std::vector<T> queue GUARDED_BY(m_mutex);
+    //! The batches added since the last Wait(), only accessed by the master.
+    std::vector<std::unique_ptr<Batch>> m_batches;
 
-    //! The number of workers (including the master) that are idle.
-    int nIdle GUARDED_BY(m_mutex){0};
+    //! The oldest batch that may still have unclaimed checks.
+    std::atomic<Batch*> m_head{nullptr};
 
-    //! The total number of workers (including the master).
-    int nTotal GUARDED_BY(m_mutex){0};
+    //! Number of threads currently claiming checks from m_head and its successors.
+    std::atomic<int> m_active{0};
+
+    //! Incremented by every Add(), for idle workers to notice new work.
+    std::atomic<uint64_t> m_generation{0};
+
+    //! The number of workers that are idle.
+    std::atomic<int> m_idle{0};
 
     //! The temporary evaluation result.
-    bool fAllOk GUARDED_BY(m_mutex){true};
+    std::atomic<bool> m_all_ok{true};
 
     /**
      * Number of verifications that haven't completed yet.
-     * This includes elements that are no longer queued, but still in the
-     * worker's own batches.
+     * This includes checks that have been claimed, but are still being verified.
      */
-    unsigned int nTodo GUARDED_BY(m_mutex){0};
+    std::atomic<size_t> m_todo{0};
+
+    //! Recent average time to verify one check in nanoseconds, zero until measured.
+    std::atomic<uint64_t> m_check_ns{0};
+
+    //! The maximum number of elements to be processed in one run
+    const size_t nBatchSize;
 
-    //! The maximum number of elements to be processed in one batch
-    const unsigned int nBatchSize;
+    //! The total number of threads verifying checks (including the master).
+    const size_t m_total_threads;
 
     std::vector<std::thread> m_worker_threads;
     bool m_request_stop GUARDED_BY(m_mutex){false};
 
-    /** Internal function that does bulk of the verification work. */
-    bool Loop(bool fMaster) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    /**
+     * Decide how many checks to claim at once.
+     * * Aim for runs that take about TARGET_RUN_TIME, so that cheap checks are
+     *   claimed in bulk and expensive ones one by one.
+     * * Aim for increasingly smaller runs as the batch runs out, so all
+     *   threads finish approximately simultaneously.
+     * * Don't do runs smaller than 1 (duh), or larger than nBatchSize.
+     * * Claim the checks of AddTasks() one by one, as their cost is not
+     *   measured.
+     */
+    size_t RunSize(const Batch& batch) const
     {
-        std::condition_variable& cond = fMaster ? m_master_cv : m_worker_cv;
-        std::vector<T> vChecks;
-        vChecks.reserve(nBatchSize);
-        unsigned int nNow = 0;
-        bool fOk = true;
-        do {
-            {
-                WAIT_LOCK(m_mutex, lock);
-                // first do the clean-up of the previous loop run (allowing us to do it in the same critsect)
-                if (nNow) {
-                    fAllOk &= fOk;
-                    nTodo -= nNow;
-                    if (nTodo == 0 && !fMaster)
-                        // We processed the last element; inform the master it can exit and return the result
-                        m_master_cv.notify_one();
-                } else {
-                    // first iteration
-                    nTotal++;
-                }
-                // logically, the do loop starts here
-                while (queue.empty() && !m_request_stop) {
-                    if (fMaster && nTodo == 0) {
-                        nTotal--;
-                        bool fRet = fAllOk;
-                        // reset the status for new work later
-                        fAllOk = true;
-                        // return the current status
-                        return fRet;
+        if (batch.m_task) return 1;
+        const size_t claimed{std::min(batch.m_claimed.load(std::memory_order_relaxed), batch.m_size)};
+        const size_t share{(batch.m_size - claimed) / m_total_threads};
+        size_t run_size{std::min(nBatchSize, share)};
+        if (const uint64_t check_ns{m_check_ns.load(std::memory_order_relaxed)}) {
+            run_size = std::min<uint64_t>(run_size, TARGET_RUN_TIME.count() / check_ns);
+        }
+        return std::max<size_t>(run_size, 1);
+    }
+
+    /**
+     * Verify checks claimed from the batches until none are left unclaimed.
+     *
+     * @returns whether any checks were claimed.
+     */
+    bool RunChecks() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        bool claimed_any{false};
+        typename CheckBatch<T>::type deferred;
+        //! Number of checks run against deferred that were not reported as completed yet.
+        size_t unreported{0};
+        // Batches are only freed by Wait() once no thread is active.
+        m_active.fetch_add(1);
+        Batch* batch{m_head.load()};
+        while (batch) {
+            const size_t run_size{RunSize(*batch)};
+            const size_t begin{batch->m_claimed.fetch_add(run_size)};
+            if (begin >= batch->m_size) {
+                Batch* next{batch->m_next.load()};
+                if (!next) break;
+                // Let the other threads skip the exhausted batch as well.
+                m_head.compare_exchange_strong(batch, next);
+                batch = next;
+                continue;
+            }
+            claimed_any = true;
+            const size_t end{std::min(begin + run_size, batch->m_size)};
+            if (batch->m_task) {
+                if (m_all_ok.load(std::memory_order_relaxed)) {
+                    bool ok{true};
+                    for (size_t i = begin; i < end && ok; ++i) {
+                        ok = batch->m_task(i);
                     }
-                    nIdle++;
-                    cond.wait(lock); // wait
-                    nIdle--;
+                    if (!ok) m_all_ok.store(false, std::memory_order_relaxed);
                 }
-                if (m_request_stop) {
-                    return false;
+                Complete(end - begin);
+                continue;
+            }
+            // Check whether we need to do work at all
+            if (m_all_ok.load(std::memory_order_relaxed)) {
+                const auto start{std::chrono::steady_clock::now()};
+                bool ok{true};
+                for (size_t i = begin; i < end && ok; ++i) {
+                    // Move the check out, so that its resources are freed
+                    // before it is reported as completed.
+                    T check{std::move(batch->m_checks[i])};
+                    if constexpr (BatchableCheck<T>) {
+                        ok = check(deferred);
+                    } else {
+                        ok = check();
+                    }
                 }
-
-                // Decide how many work units to process now.
-                // * Do not try to do everything at once, but aim for increasingly smaller batches so
-                //   all workers finish approximately simultaneously.
-                // * Try to account for idle jobs which will instantly start helping.
-                // * Don't do batches smaller than 1 (duh), or larger than nBatchSize.
-                nNow = std::max(1U, std::min(nBatchSize, (unsigned int)queue.size() / (nTotal + nIdle + 1)));
-                auto start_it = queue.end() - nNow;
-                vChecks.assign(std::make_move_iterator(start_it), std::make_move_iterator(queue.end()));
-                queue.erase(start_it, queue.end());
-                // Check whether we need to do work at all
-                fOk = fAllOk;
+                if (!ok) m_all_ok.store(false, std::memory_order_relaxed);
+                const auto elapsed{std::chrono::nanoseconds{std::chrono::steady_clock::now() - start}};
+                const uint64_t check_ns{std::max<uint64_t>(1, elapsed.count() / (end - begin))};
+                const uint64_t average_ns{m_check_ns.load(std::memory_order_relaxed)};
+                m_check_ns.store(average_ns ? (average_ns * 7 + check_ns) / 8 : check_ns, std::memory_order_relaxed);
+            }
+            if constexpr (BatchableCheck<T>) {
+                unreported += end - begin;
+            } else {
+                Complete(end - begin);
             }
-            // execute work
-            for (T& check : vChecks)
-                if (fOk)
-                    fOk = check();
-            vChecks.clear();
-        } while (true);
+        }
+        if (unreported > 0) {
+            if (m_all_ok.load(std::memory_order_relaxed) && !deferred.Verify()) {
+                m_all_ok.store(false, std::memory_order_relaxed);
+            }
+            Complete(unreported);
+        }
+        m_active.fetch_sub(1);
+        return claimed_any;
+    }
+
+    /** Report count checks as completed, waking up the master if they were the last ones. */
+    void Complete(size_t count) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        if (m_todo.fetch_sub(count) == count) {
+            // We processed the last element; inform the master it can exit and return the result
+            WITH_LOCK(m_mutex, m_master_cv.notify_one());
+        }
+    }
+
+    /** Append a batch to the list and wake up idle workers. */
+    void Enqueue(std::unique_ptr<Batch>&& new_batch) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        const size_t count{new_batch->m_size};
+        m_todo.fetch_add(count);
+        Batch* batch{m_batches.emplace_back(std::move(new_batch)).get()};
+        if (m_batches.size() == 1) {
+            m_head.store(batch);
+        } else {
+            m_batches[m_batches.size() - 2]->m_next.store(batch);
+        }
+        m_generation.fetch_add(1);
+
+        if (m_idle.load() == 0) return;
+        // Taking the mutex makes sure a worker that is about to sleep either
+        // sees the new generation or gets notified.
+        { LOCK(m_mutex); }
+        if (count == 1) {
+            m_worker_cv.notify_one();
+        } else {
+            m_worker_cv.notify_all();
+        }
+    }
+
+    /** Internal function that does bulk of the verification work. */
+    void Loop() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        while (true) {
+            const uint64_t generation{m_generation.load()};
+            if (RunChecks()) continue;
+            WAIT_LOCK(m_mutex, lock);
+            m_idle.fetch_add(1);
+            m_worker_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+                return m_request_stop || m_generation.load() != generation;
+            });
+            m_idle.fetch_sub(1);
+            if (m_request_stop) return;
+        }
     }
 
 public:
@@ -128,14 +285,15 @@ public:
     Mutex m_control_mutex;
 
     //! Create a new check queue
-    explicit CCheckQueue(unsigned int batch_size, int worker_threads_num)
-        : nBatchSize(batch_size)
+    explicit CCheckQueue(unsigned int batch_size, int worker_threads_num, const std::string& thread_name = "scriptch")
+        : nBatchSize(std::max(batch_size, 1U)),
+          m_total_threads(std::max(worker_threads_num, 0) + 1)
     {
         m_worker_threads.reserve(worker_threads_num);
         for (int n = 0; n < worker_threads_num; ++n) {
-            m_worker_threads.emplace_back([this, n]() {
-                util::ThreadRename(strprintf("scriptch.%i", n));
-                Loop(false /* worker thread */);
+            m_worker_threads.emplace_back([this, n, thread_name]() {
+                util::ThreadRename(strprintf("%s.%i", thread_name, n));
+                Loop();
             });
         }
     }
@@ -150,7 +308,19 @@ public:
     //! Wait until execution finishes, and return whether all evaluations were successful.
     bool Wait() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
     {
-        return Loop(true /* master thread */);
+        RunChecks();
+        {
+            WAIT_LOCK(m_mutex, lock);
+            m_master_cv.wait(lock, [&] { return m_todo.load() == 0; });
+        }
+        // Wait for threads that are still looking for work before freeing the batches.
+        m_head.store(nullptr);
+        while (m_active.load() != 0) {
+            std::this_thread::yield();
+        }
+        m_batches.clear();
+        // reset the status for new work later
+        return m_all_ok.exchange(true);
     }
 
     //! Add a batch of checks to the queue
@@ -159,18 +329,21 @@ public:
         if (vChecks.empty()) {
             return;
         }
+        Enqueue(std::make_unique<Batch>(std::move(vChecks)));
+    }
 
-        {
-            LOCK(m_mutex);
-            queue.insert(queue.end(), std::make_move_iterator(vChecks.begin()), std::make_move_iterator(vChecks.end()));
-            nTodo += vChecks.size();
-        }
-
-        if (vChecks.size() == 1) {
-            m_worker_cv.notify_one();
-        } else {
-            m_worker_cv.notify_all();
+    /**
+     * Add count checks of another type, to be verified by the threads of
+     * this queue like the ones passed to Add(). task(i) verifies the i-th
+     * check and returns whether it succeeded. It must stay valid until
+     * Wait() returns.
+     */
+    void AddTasks(size_t count, std::function<bool(size_t)> task) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        if (count == 0) {
+            return;
         }
+        Enqueue(std::make_unique<Batch>(count, std::move(task)));
     }
 
     ~CCheckQueue()
@@ -224,6 +397,13 @@ public:
         }
     }
 
+    void AddTasks(size_t count, std::function<bool(size_t)> task)
+    {
+        if (pqueue != nullptr) {
+            pqueue->AddTasks(count, std::move(task));
+        }
+    }
+
     ~CCheckQueueControl()
     {
         if (!fDone)
@@ -14,6 +14,7 @@ bool CCoinsView::GetCoin(const COutPoint &outpoint, Coin &coin) const { return f
 uint256 CCoinsView::GetBestBlock() const { return uint256(); }
 std::vector<uint256> CCoinsView::GetHeadBlocks() const { return std::vector<uint256>(); }
 bool CCoinsView::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, bool erase) { return false; }
+bool CCoinsView::BatchWritePartial(CCoinsMap& mapCoins, const uint256& hashBlock) { return false; }
 std::unique_ptr<CCoinsViewCursor> CCoinsView::Cursor() const { return nullptr; }
 
 bool CCoinsView::HaveCoin(const COutPoint &outpoint) const
@@ -29,26 +30,71 @@ uint256 CCoinsViewBacked::GetBestBlock() const { return base->GetBestBlock(); }
 std::vector<uint256> CCoinsViewBacked::GetHeadBlocks() const { return base->GetHeadBlocks(); }
 void CCoinsViewBacked::SetBackend(CCoinsView &viewIn) { base = &viewIn; }
 bool CCoinsViewBacked::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, bool erase) { return base->BatchWrite(mapCoins, hashBlock, erase); }
+bool CCoinsViewBacked::BatchWritePartial(CCoinsMap& mapCoins, const uint256& hashBlock) { return base->BatchWritePartial(mapCoins, hashBlock); }
 std::unique_ptr<CCoinsViewCursor> CCoinsViewBacked::Cursor() const { return base->Cursor(); }
 size_t CCoinsViewBacked::EstimateSize() const { return base->EstimateSize(); }
 
 CCoinsViewCache::CCoinsViewCache(CCoinsView* baseIn, bool deterministic) :
     CCoinsViewBacked(baseIn), m_deterministic(deterministic),
-    cacheCoins(0, SaltedOutpointHasher(/*deterministic=*/deterministic), CCoinsMap::key_equal{}, &m_cache_coins_memory_resource)
+    cacheCoins(0, SaltedOutpointHasher(/*deterministic=*/deterministic), CCoinsMap::key_equal{}, m_cache_coins_memory_resource.get())
 {}
 
 size_t CCoinsViewCache::DynamicMemoryUsage() const {
     return memusage::DynamicUsage(cacheCoins) + cachedCoinsUsage;
 }
 
+void CCoinsViewCache::LinkNewest(CCoinsMap::value_type& entry) const {
+    if (!m_track_use_order) return;
+    entry.second.m_prev = m_newest;
+    entry.second.m_next = nullptr;
+    if (m_newest) {
+        m_newest->second.m_next = &entry;
+    } else {
+        m_oldest = &entry;
+    }
+    m_newest = &entry;
+}
+
+void CCoinsViewCache::Unlink(CCoinsMap::value_type& entry) const {
+    CCoinsCacheEntry& links = entry.second;
+    if (links.m_prev) {
+        links.m_prev->second.m_next = links.m_next;
+    } else if (m_oldest == &entry) {
+        m_oldest = links.m_next;
+    } else {
+        // Not in the list.
+        return;
+    }
+    if (links.m_next) {
+        links.m_next->second.m_prev = links.m_prev;
+    } else {
+        m_newest = links.m_prev;
+    }
+    links.m_prev = links.m_next = nullptr;
+}
+
+void CCoinsViewCache::Touch(CCoinsMap::value_type& entry) const {
+    if (!m_track_use_order || m_newest == &entry) return;
+    Unlink(entry);
+    LinkNewest(entry);
+}
+
+CCoinsMap::iterator CCoinsViewCache::EraseCoin(CCoinsMap::iterator it) {
+    Unlink(*it);
+    return cacheCoins.erase(it);
+}
+
 CCoinsMap::iterator CCoinsViewCache::FetchCoin(const COutPoint &outpoint) const {
     CCoinsMap::iterator it = cacheCoins.find(outpoint);
-    if (it != cacheCoins.end())
+    if (it != cacheCoins.end()) {
+        Touch(*it);
         return it;
+    }
     Coin tmp;
     if (!base->GetCoin(outpoint, tmp))
         return cacheCoins.end();
-    CCoinsMap::iterator ret = cacheCoins.emplace(std::piecewise_construct, std::forward_as_tuple(outpoint), std::forward_as_tuple(std::move(tmp))).first;
+    CCoinsMap::iterator ret = cacheCoins.try_emplace(outpoint, std::move(tmp)).first;
+    LinkNewest(*ret);
     if (ret->second.coin.IsSpent()) {
         // The parent only has an empty entry for this outpoint; we can consider our
         // version as fresh.
@@ -72,10 +118,13 @@ void CCoinsViewCache::AddCoin(const COutPoint &outpoint, Coin&& coin, bool possi
     if (coin.out.scriptPubKey.IsUnspendable()) return;
     CCoinsMap::iterator it;
     bool inserted;
-    std::tie(it, inserted) = cacheCoins.emplace(std::piecewise_construct, std::forward_as_tuple(outpoint), std::tuple<>());
+    std::tie(it, inserted) = cacheCoins.try_emplace(outpoint);
     bool fresh = false;
     if (!inserted) {
         cachedCoinsUsage -= it->second.coin.DynamicMemoryUsage();
+        Touch(*it);
+    } else {
+        LinkNewest(*it);
     }
     if (!possible_overwrite) {
         if (!it->second.coin.IsSpent()) {
@@ -109,10 +158,19 @@ void CCoinsViewCache::AddCoin(const COutPoint &outpoint, Coin&& coin, bool possi
 
 void CCoinsViewCache::EmplaceCoinInternalDANGER(COutPoint&& outpoint, Coin&& coin) {
     cachedCoinsUsage += coin.DynamicMemoryUsage();
-    cacheCoins.emplace(
-        std::piecewise_construct,
-        std::forward_as_tuple(std::move(outpoint)),
-        std::forward_as_tuple(std::move(coin), CCoinsCacheEntry::DIRTY));
+    auto [it, inserted] = cacheCoins.try_emplace(std::move(outpoint), std::move(coin), CCoinsCacheEntry::DIRTY);
+    if (inserted) LinkNewest(*it);
+}
+
+void CCoinsViewCache::CacheCoin(const COutPoint& outpoint, Coin&& coin) {
+    auto [it, inserted] = cacheCoins.try_emplace(outpoint, std::move(coin));
+    if (!inserted) return;
+    LinkNewest(*it);
+    if (it->second.coin.IsSpent()) {
+        // Like in FetchCoin(), the parent has no unspent version of this coin.
+        it->second.flags = CCoinsCacheEntry::FRESH;
+    }
+    cachedCoinsUsage += it->second.coin.DynamicMemoryUsage();
 }
 
 void AddCoins(CCoinsViewCache& cache, const CTransaction &tx, int nHeight, bool check_for_overwrite) {
@@ -140,10 +198,11 @@ bool CCoinsViewCache::SpendCoin(const COutPoint &outpoint, Coin* moveout) {
         *moveout = std::move(it->second.coin);
     }
     if (it->second.flags & CCoinsCacheEntry::FRESH) {
-        cacheCoins.erase(it);
+        EraseCoin(it);
     } else {
         it->second.flags |= CCoinsCacheEntry::DIRTY;
         it->second.coin.Clear();
+        Touch(*it);
     }
     return true;
 }
@@ -194,7 +253,9 @@ bool CCoinsViewCache::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlockIn
             if (!(it->second.flags & CCoinsCacheEntry::FRESH && it->second.coin.IsSpent())) {
                 // Create the coin in the parent cache, move the data up
                 // and mark it as dirty.
-                CCoinsCacheEntry& entry = cacheCoins[it->first];
+                auto& new_entry = *cacheCoins.try_emplace(it->first).first;
+                LinkNewest(new_entry);
+                CCoinsCacheEntry& entry = new_entry.second;
                 if (erase) {
                     // The `move` call here is purely an optimization; we rely on the
                     // `mapCoins.erase` call in the `for` expression to actually remove
@@ -226,7 +287,7 @@ bool CCoinsViewCache::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlockIn
                 // The grandparent cache does not have an entry, and the coin
                 // has been spent. We can just delete it from the parent cache.
                 cachedCoinsUsage -= itUs->second.coin.DynamicMemoryUsage();
-                cacheCoins.erase(itUs);
+                EraseCoin(itUs);
             } else {
                 // A normal modification.
                 cachedCoinsUsage -= itUs->second.coin.DynamicMemoryUsage();
@@ -240,6 +301,7 @@ bool CCoinsViewCache::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlockIn
                 }
                 cachedCoinsUsage += itUs->second.coin.DynamicMemoryUsage();
                 itUs->second.flags |= CCoinsCacheEntry::DIRTY;
+                Touch(*itUs);
                 // NOTE: It isn't safe to mark the coin as FRESH in the parent
                 // cache. If it already existed and was spent in the parent
                 // cache then marking it FRESH would prevent that spentness
@@ -251,6 +313,14 @@ bool CCoinsViewCache::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlockIn
     return true;
 }
 
+bool CCoinsViewCache::BatchWritePartial(CCoinsMap& mapCoins, const uint256& hashBlockIn) {
+    // A cache has no head blocks, it just keeps its own best block.
+    const uint256 best_block{GetBestBlock()};
+    const bool fOk{BatchWrite(mapCoins, hashBlockIn, /*erase=*/true)};
+    hashBlock = best_block;
+    return fOk;
+}
+
 bool CCoinsViewCache::Flush() {
     bool fOk = base->BatchWrite(cacheCoins, hashBlock, /*erase=*/true);
     if (fOk) {
@@ -261,6 +331,7 @@ bool CCoinsViewCache::Flush() {
         ReallocateCache();
     }
     cachedCoinsUsage = 0;
+    m_oldest = m_newest = nullptr;
     return fOk;
 }
 
@@ -272,7 +343,7 @@ bool CCoinsViewCache::Sync()
     for (auto it = cacheCoins.begin(); it != cacheCoins.end(); ) {
         if (it->second.coin.IsSpent()) {
             cachedCoinsUsage -= it->second.coin.DynamicMemoryUsage();
-            it = cacheCoins.erase(it);
+            it = EraseCoin(it);
         } else {
             it->second.flags = 0;
             ++it;
@@ -281,6 +352,49 @@ bool CCoinsViewCache::Sync()
     return fOk;
 }
 
+CCoinsBatch CCoinsViewCache::TakeCoins()
+{
+    CCoinsBatch batch;
+    batch.best_block = GetBestBlock();
+    batch.memory_usage = DynamicMemoryUsage();
+    batch.coins = std::make_unique<CCoinsMap>(std::move(cacheCoins));
+    batch.resource = std::move(m_cache_coins_memory_resource);
+    cachedCoinsUsage = 0;
+    ReallocateCache();
+    return batch;
+}
+
+void CCoinsViewCache::Reset()
+{
+    cacheCoins.clear();
+    cachedCoinsUsage = 0;
+    m_oldest = m_newest = nullptr;
+    hashBlock.SetNull();
+}
+
+void CCoinsViewCache::TrackUseOrder()
+{
+    assert(cacheCoins.empty());
+    m_track_use_order = true;
+}
+
+bool CCoinsViewCache::FlushOldest(size_t target_size, size_t max_dirty)
+{
+    CCoinsMapMemoryResource resource;
+    CCoinsMap written{0, SaltedOutpointHasher{/*deterministic=*/m_deterministic}, CCoinsMap::key_equal{}, &resource};
+    while (m_oldest && cacheCoins.size() > target_size) {
+        CCoinsCacheEntry& entry{m_oldest->second};
+        if ((entry.flags & CCoinsCacheEntry::DIRTY) && written.size() == max_dirty) break;
+        cachedCoinsUsage -= entry.coin.DynamicMemoryUsage();
+        if (entry.flags & CCoinsCacheEntry::DIRTY) {
+            written.try_emplace(m_oldest->first, std::move(entry.coin), entry.flags);
+        }
+        EraseCoin(cacheCoins.find(m_oldest->first));
+    }
+    if (written.empty()) return true;
+    return base->BatchWritePartial(written, GetBestBlock());
+}
+
 void CCoinsViewCache::Uncache(const COutPoint& hash)
 {
     CCoinsMap::iterator it = cacheCoins.find(hash);
@@ -292,7 +406,7 @@ void CCoinsViewCache::Uncache(const COutPoint& hash)
                (uint32_t)it->second.coin.nHeight,
                (int64_t)it->second.coin.out.nValue,
                (bool)it->second.coin.IsCoinBase());
-        cacheCoins.erase(it);
+        EraseCoin(it);
     }
 }
 
@@ -317,9 +431,10 @@ void CCoinsViewCache::ReallocateCache()
     // Cache should be empty when we're calling this.
     assert(cacheCoins.size() == 0);
     cacheCoins.~CCoinsMap();
-    m_cache_coins_memory_resource.~CCoinsMapMemoryResource();
-    ::new (&m_cache_coins_memory_resource) CCoinsMapMemoryResource{};
-    ::new (&cacheCoins) CCoinsMap{0, SaltedOutpointHasher{/*deterministic=*/m_deterministic}, CCoinsMap::key_equal{}, &m_cache_coins_memory_resource};
+    m_cache_coins_memory_resource.reset();
+    m_cache_coins_memory_resource = std::make_unique<CCoinsMapMemoryResource>();
+    ::new (&cacheCoins) CCoinsMap{0, SaltedOutpointHasher{/*deterministic=*/m_deterministic}, CCoinsMap::key_equal{}, m_cache_coins_memory_resource.get()};
+    m_oldest = m_newest = nullptr;
 }
 
 void CCoinsViewCache::SanityCheck() const
@@ -337,6 +452,19 @@ void CCoinsViewCache::SanityCheck() const
         recomputed_usage += entry.coin.DynamicMemoryUsage();
     }
     assert(recomputed_usage == cachedCoinsUsage);
+
+    // Every entry in the list of entries must be in the map, in both directions.
+    size_t linked = 0;
+    const CCoinsMap::value_type* prev = nullptr;
+    for (const CCoinsMap::value_type* entry = m_oldest; entry; entry = entry->second.m_next) {
+        assert(entry->second.m_prev == prev);
+        const auto it = cacheCoins.find(entry->first);
+        assert(it != cacheCoins.end() && &*it == entry);
+        prev = entry;
+        ++linked;
+    }
+    assert(prev == m_newest);
+    assert(linked <= cacheCoins.size());
 }
 
 static const size_t MIN_TRANSACTION_OUTPUT_WEIGHT = WITNESS_SCALE_FACTOR * ::GetSerializeSize(CTxOut());
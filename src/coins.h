@@ -9,6 +9,7 @@
 
 #include <compressor.h>
 #include <core_memusage.h>
+#include <flatnodemap.h>
 #include <memusage.h>
 #include <primitives/transaction.h>
 #include <serialize.h>
@@ -106,6 +107,13 @@ struct CCoinsCacheEntry
 {
     Coin coin; // The actual cached data.
     unsigned char flags;
+    //! Neighbours in the owning cache's list of entries, from least to most
+    //! recently used, if it keeps one (see CCoinsViewCache::TrackUseOrder()).
+    //! Both are null if the entry is not in a list. They take 16 bytes of
+    //! every entry even if the cache keeps no list, which counts towards
+    //! the cache's memory usage and so towards -dbcache.
+    std::pair<const COutPoint, CCoinsCacheEntry>* m_prev{nullptr};
+    std::pair<const COutPoint, CCoinsCacheEntry>* m_next{nullptr};
 
     enum Flags {
         /**
@@ -134,22 +142,30 @@ struct CCoinsCacheEntry
 };
 
 /**
- * PoolAllocator's MAX_BLOCK_SIZE_BYTES parameter here uses sizeof the data, and adds the size
- * of 4 pointers. We do not know the exact node size used in the std::unordered_node implementation
- * because it is implementation defined. Most implementations have an overhead of 1 or 2 pointers,
- * so nodes can be connected in a linked list, and in some cases the hash value is stored as well.
- * Using an additional sizeof(void*)*4 for MAX_BLOCK_SIZE_BYTES should thus be sufficient so that
- * all implementations can allocate the nodes from the PoolAllocator.
+ * The entries are allocated from a PoolAllocator, which carves them out of
+ * large chunks that are all released at once when the cache is flushed. The
+ * map itself only keeps an index of entry pointers, so the entries are
+ * exactly the size of the key and value.
  */
-using CCoinsMap = std::unordered_map<COutPoint,
-                                     CCoinsCacheEntry,
-                                     SaltedOutpointHasher,
-                                     std::equal_to<COutPoint>,
-                                     PoolAllocator<std::pair<const COutPoint, CCoinsCacheEntry>,
-                                                   sizeof(std::pair<const COutPoint, CCoinsCacheEntry>) + sizeof(void*) * 4>>;
+using CCoinsMap = FlatNodeMap<COutPoint,
+                              CCoinsCacheEntry,
+                              SaltedOutpointHasher,
+                              std::equal_to<COutPoint>,
+                              PoolAllocator<std::pair<const COutPoint, CCoinsCacheEntry>,
+                                            sizeof(std::pair<const COutPoint, CCoinsCacheEntry>)>>;
 
 using CCoinsMapMemoryResource = CCoinsMap::allocator_type::ResourceType;
 
+/** Coins taken out of a CCoinsViewCache, with the memory they are allocated from. */
+struct CCoinsBatch {
+    std::unique_ptr<CCoinsMapMemoryResource> resource;
+    std::unique_ptr<CCoinsMap> coins;
+    //! Best block of the cache the coins were taken from.
+    uint256 best_block;
+    //! Memory usage of the cache the coins were taken from.
+    size_t memory_usage{0};
+};
+
 /** Cursor for iterating over CoinsView state */
 class CCoinsViewCursor
 {
@@ -195,6 +211,12 @@ public:
     //! The passed mapCoins can be modified.
     virtual bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, bool erase = true);
 
+    //! Write the changes of some of the coins modified up to hashBlock,
+    //! erasing them from mapCoins. The view is left in a transition to
+    //! hashBlock, recorded in its head blocks, until the next BatchWrite().
+    //! Returns false if the view does not support partial writes.
+    virtual bool BatchWritePartial(CCoinsMap& mapCoins, const uint256& hashBlock);
+
     //! Get a cursor to iterate over the whole state
     virtual std::unique_ptr<CCoinsViewCursor> Cursor() const;
 
@@ -220,6 +242,7 @@ public:
     std::vector<uint256> GetHeadBlocks() const override;
     void SetBackend(CCoinsView &viewIn);
     bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, bool erase = true) override;
+    bool BatchWritePartial(CCoinsMap& mapCoins, const uint256& hashBlock) override;
     std::unique_ptr<CCoinsViewCursor> Cursor() const override;
     size_t EstimateSize() const override;
 };
@@ -237,12 +260,19 @@ protected:
      * declared as "const".
      */
     mutable uint256 hashBlock;
-    mutable CCoinsMapMemoryResource m_cache_coins_memory_resource{};
+    mutable std::unique_ptr<CCoinsMapMemoryResource> m_cache_coins_memory_resource{std::make_unique<CCoinsMapMemoryResource>()};
     mutable CCoinsMap cacheCoins;
 
     /* Cached dynamic memory usage for the inner Coin objects. */
     mutable size_t cachedCoinsUsage{0};
 
+    //! Ends of the list of entries in cacheCoins, from least to most recently
+    //! used, used to pick the coins FlushOldest() writes out. Only kept after
+    //! TrackUseOrder().
+    bool m_track_use_order{false};
+    mutable CCoinsMap::value_type* m_oldest{nullptr};
+    mutable CCoinsMap::value_type* m_newest{nullptr};
+
 public:
     CCoinsViewCache(CCoinsView *baseIn, bool deterministic = false);
 
@@ -257,6 +287,7 @@ public:
     uint256 GetBestBlock() const override;
     void SetBestBlock(const uint256 &hashBlock);
     bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, bool erase = true) override;
+    bool BatchWritePartial(CCoinsMap& mapCoins, const uint256& hashBlock) override;
     std::unique_ptr<CCoinsViewCursor> Cursor() const override {
         throw std::logic_error("CCoinsViewCache cursor iteration not supported.");
     }
@@ -295,6 +326,15 @@ public:
      */
     void EmplaceCoinInternalDANGER(COutPoint&& outpoint, Coin&& coin);
 
+    /**
+     * Add a coin read from the base view to the cache, as FetchCoin() would,
+     * unless the outpoint is already cached. The coin is not marked dirty.
+     *
+     * The caller must make sure that the coin matches the base view. Used to
+     * warm the cache with coins read from the base on other threads.
+     */
+    void CacheCoin(const COutPoint& outpoint, Coin&& coin);
+
     /**
      * Spend a coin. Pass moveto in order to get the deleted data.
      * If no unspent output exists for the passed outpoint, this call
@@ -319,6 +359,39 @@ public:
      */
     bool Sync();
 
+    /**
+     * Take all coins out of the cache, leaving it empty, as Flush() does but
+     * without writing them to the base view. The caller takes over writing
+     * the dirty coins to the base, which must answer lookups of the taken
+     * coins until then.
+     */
+    CCoinsBatch TakeCoins();
+
+    /**
+     * Discard all coins in the cache without writing them to the base, and
+     * forget the best block. Unlike ReallocateCache(), the memory of the
+     * cache is kept for reuse, so that a cache used as a scratch overlay over
+     * another view does not allocate it again each time.
+     */
+    void Reset();
+
+    /**
+     * Keep the entries in a list from least to most recently used, which
+     * FlushOldest() needs. Costs a few pointer updates per access, so it is
+     * off by default. Must be called while the cache is empty.
+     */
+    void TrackUseOrder();
+
+    /**
+     * Evict the least recently used coins until at most
+     * target_size remain, writing the modified ones to the base with
+     * BatchWritePartial(). Stops early after writing max_dirty coins, so
+     * that recently used coins stay cached and the write stays bounded.
+     *
+     * If false is returned, the state of this cache (and its backing view) will be undefined.
+     */
+    bool FlushOldest(size_t target_size, size_t max_dirty);
+
     /**
      * Removes the UTXO with the given outpoint from the cache, if it is
      * not modified.
@@ -350,6 +423,15 @@ private:
      * memory usage.
      */
     CCoinsMap::iterator FetchCoin(const COutPoint &outpoint) const;
+
+    //! Append an entry to the list of entries as the most recently used.
+    void LinkNewest(CCoinsMap::value_type& entry) const;
+    //! Remove an entry from the list of entries, if it is in the list.
+    void Unlink(CCoinsMap::value_type& entry) const;
+    //! Move an entry to the end of the list of entries after using it.
+    void Touch(CCoinsMap::value_type& entry) const;
+    //! Remove an entry from both cacheCoins and the list of entries.
+    CCoinsMap::iterator EraseCoin(CCoinsMap::iterator it);
 };
 
 //! Utility function to add all of a transaction's outputs to a cache.
@@ -40,6 +40,20 @@ struct ethash_epoch_context
 struct ethash_epoch_context_full;
 
 
+/**
+ * Counters of the global epoch context cache.
+ */
+struct ethash_epoch_context_cache_stats
+{
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t builds;
+    uint64_t build_time_us;
+    uint32_t cached_epochs;
+    uint32_t capacity;
+};
+
+
 struct ethash_result
 {
     union ethash_hash256 final_hash;
@@ -93,6 +107,20 @@ struct ethash_epoch_context* ethash_create_epoch_context(int epoch_number) NOEXC
  */
 struct ethash_epoch_context_full* ethash_create_epoch_context_full(int epoch_number) NOEXCEPT;
 
+/**
+ * Creates the epoch context with the full dataset stored in memory provided by the caller.
+ *
+ * The dataset must hold ethash_calculate_full_dataset_num_items() items. Items that are
+ * zero are generated on the fly like with ethash_create_epoch_context_full(). The memory
+ * remains owned by the caller and must outlive the context.
+ *
+ * @param epoch_number  The epoch number.
+ * @param dataset       The memory of the full dataset.
+ * @return  Pointer to the context or null in case of memory allocation failure.
+ */
+struct ethash_epoch_context_full* ethash_create_epoch_context_full_with_dataset(
+    int epoch_number, union ethash_hash1024* dataset) NOEXCEPT;
+
 void ethash_destroy_epoch_context(struct ethash_epoch_context* context) NOEXCEPT;
 
 void ethash_destroy_epoch_context_full(struct ethash_epoch_context_full* context) NOEXCEPT;
@@ -103,12 +131,71 @@ void ethash_destroy_epoch_context_full(struct ethash_epoch_context_full* context
  */
 const struct ethash_epoch_context* ethash_get_global_epoch_context(int epoch_number) NOEXCEPT;
 
+/**
+ * Start building the global shared epoch context of an epoch in the background,
+ * e.g. ahead of an epoch boundary, so that the first lookup of the epoch does
+ * not wait for the light cache to be built. Does nothing if the context is
+ * already cached or another one is being built in the background.
+ */
+void ethash_prepare_global_epoch_context(int epoch_number) NOEXCEPT;
+
+/**
+ * Set the maximum number of light epoch contexts kept by the global cache.
+ *
+ * Keeping more than one context avoids rebuilding the light cache when
+ * callers alternate between epochs, e.g. around an epoch boundary or during
+ * a reorg. The minimum is 2, the default 3.
+ */
+void ethash_set_global_epoch_context_cache_size(unsigned int size) NOEXCEPT;
+
+/**
+ * Get the counters of the global epoch context cache.
+ */
+struct ethash_epoch_context_cache_stats ethash_get_global_epoch_context_cache_stats(void) NOEXCEPT;
+
+/**
+ * How the global full epoch contexts hold their dataset.
+ */
+enum ethash_full_dataset_mode
+{
+    /** Allocate the dataset and generate the items when first hit (the default). */
+    ETHASH_FULL_DATASET_LAZY = 0,
+    /** Generate the whole dataset in memory before the context is used. */
+    ETHASH_FULL_DATASET_MEMORY = 1,
+    /** Like ETHASH_FULL_DATASET_MEMORY, but keep the dataset in a file that is
+     *  mapped by later runs and other processes instead of generated again. */
+    ETHASH_FULL_DATASET_FILE = 2,
+};
+
+/**
+ * Configure how the global full epoch contexts are built.
+ *
+ * Applies to contexts built after the call.
+ *
+ * @param mode         How the dataset is held.
+ * @param dir          The directory of the dataset files, only used by ETHASH_FULL_DATASET_FILE.
+ *                     It must exist.
+ * @param num_threads  The number of threads generating a dataset.
+ */
+void ethash_set_global_full_dataset_options(
+    enum ethash_full_dataset_mode mode, const char* dir, unsigned int num_threads) NOEXCEPT;
+
 /**
  * Get global shared epoch context with full dataset initialized.
+ *
+ * Builds the context if needed, which may take minutes unless the dataset
+ * mode is ETHASH_FULL_DATASET_LAZY.
  */
 const struct ethash_epoch_context_full* ethash_get_global_epoch_context_full(
     int epoch_number) NOEXCEPT;
 
+/**
+ * Start building the global full epoch context of an epoch in the background,
+ * so that switching to it later does not wait for the dataset generation.
+ * Does nothing with ETHASH_FULL_DATASET_LAZY.
+ */
+void ethash_prepare_global_epoch_context_full(int epoch_number) NOEXCEPT;
+
 
 struct ethash_result ethash_hash(const struct ethash_epoch_context* context,
     const union ethash_hash256* header_hash, uint64_t nonce) NOEXCEPT;
@@ -25,6 +25,8 @@ using epoch_context_full = ethash_epoch_context_full;
 
 using result = ethash_result;
 
+using epoch_context_cache_stats = ethash_epoch_context_cache_stats;
+
 /// Constructs a 256-bit hash from an array of bytes.
 ///
 /// @param bytes  A pointer to array of at least 32 bytes.
@@ -154,9 +156,24 @@ inline const epoch_context& get_global_epoch_context(int epoch_number) noexcept
     return *ethash_get_global_epoch_context(epoch_number);
 }
 
+/// Alias for ethash_prepare_global_epoch_context().
+static constexpr auto prepare_global_epoch_context = ethash_prepare_global_epoch_context;
+
+/// Alias for ethash_set_global_epoch_context_cache_size().
+static constexpr auto set_global_epoch_context_cache_size = ethash_set_global_epoch_context_cache_size;
+
+/// Alias for ethash_get_global_epoch_context_cache_stats().
+static constexpr auto get_global_epoch_context_cache_stats = ethash_get_global_epoch_context_cache_stats;
+
 /// Get global shared epoch context with full dataset initialized.
 inline const epoch_context_full& get_global_epoch_context_full(int epoch_number) noexcept
 {
     return *ethash_get_global_epoch_context_full(epoch_number);
 }
+
+/// Alias for ethash_set_global_full_dataset_options().
+static constexpr auto set_global_full_dataset_options = ethash_set_global_full_dataset_options;
+
+/// Alias for ethash_prepare_global_epoch_context_full().
+static constexpr auto prepare_global_epoch_context_full = ethash_prepare_global_epoch_context_full;
 }  // namespace ethash
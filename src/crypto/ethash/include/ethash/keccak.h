@@ -38,6 +38,25 @@ void ethash_keccakf1600(uint64_t state[25]) NOEXCEPT;
  */
 void ethash_keccakf800(uint32_t state[25]) NOEXCEPT;
 
+/**
+ * Eight independent Keccak-f[800] permutations.
+ *
+ * Uses the implementation selected by ethash_keccakf800_autodetect(), which
+ * processes all states at once with AVX2 where available. Until it is called,
+ * ethash_keccakf800() is applied to each state in turn.
+ *
+ * @param states  The 8 states of 25 32-bit words to be permuted.
+ */
+void ethash_keccakf800_8way(uint32_t states[8][25]) NOEXCEPT;
+
+/**
+ * Select the fastest ethash_keccakf800_8way() implementation supported by
+ * the CPU. Not thread-safe, must be called before any hashing is done.
+ *
+ * @return  The name of the selected implementation.
+ */
+const char* ethash_keccakf800_autodetect(void) NOEXCEPT;
+
 union ethash_hash256 ethash_keccak256(const uint8_t* data, size_t size) NOEXCEPT;
 union ethash_hash256 ethash_keccak256_32(const uint8_t data[32]) NOEXCEPT;
 union ethash_hash512 ethash_keccak512(const uint8_t* data, size_t size) NOEXCEPT;
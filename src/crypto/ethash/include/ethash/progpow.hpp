@@ -32,6 +32,11 @@ bool verify(const epoch_context& context, int block_number, const hash256& heade
 hash256 hash_no_verify(const int& block_number, const hash256& header_hash,
     const hash256& hashMix, const uint64_t& nonce) noexcept;
 
+/// Computes hash_no_verify() for 8 (header hash, mix, nonce) triples at once,
+/// using ethash_keccakf800_8way() for the keccak permutations.
+void hash_no_verify_8way(const hash256 header_hashes[8], const hash256 hashMixes[8],
+    const uint64_t nonces[8], hash256 final_hashes[8]) noexcept;
+
 search_result search_light(const epoch_context& context, int block_number,
     const hash256& header_hash, const hash256& boundary, uint64_t start_nonce,
     size_t iterations) noexcept;
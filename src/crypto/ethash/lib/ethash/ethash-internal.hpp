@@ -7,7 +7,9 @@
 #include <crypto/ethash/include/ethash/ethash.hpp>
 #include <crypto/ethash/lib/ethash/endianness.hpp>
 
+#include <atomic>
 #include <memory>
+#include <string>
 #include <vector>
 
 extern "C" struct ethash_epoch_context_full : ethash_epoch_context
@@ -55,9 +57,26 @@ using build_light_cache_fn = void (*)(hash512 cache[], int num_items, const hash
 void build_light_cache(
     hash_fn_512 hash_fn, hash512 cache[], int num_items, const hash256& seed) noexcept;
 
-epoch_context_full* create_epoch_context(
-    build_light_cache_fn build_fn, int epoch_number, bool full) noexcept;
+/// Creates an epoch context. With a dataset given, the full dataset and the
+/// L1 cache are stored there instead of in the context's own allocation.
+epoch_context_full* create_epoch_context(build_light_cache_fn build_fn, int epoch_number,
+    bool full, hash1024* dataset = nullptr) noexcept;
 
 }  // namespace generic
 
+/// Generates all items of the full dataset of a context on num_threads
+/// threads. Returns false without finishing if abort is set meanwhile.
+bool generate_full_dataset(
+    const epoch_context_full& context, unsigned int num_threads, const std::atomic<bool>& abort) noexcept;
+
+/// Builds a full epoch context with the whole dataset generated.
+///
+/// The dataset is placed in anonymous memory, backed by huge pages where
+/// possible. If dir is not empty, the dataset is kept in a file in that
+/// directory instead: an existing file is mapped if it passes a spot check,
+/// otherwise it is generated and written there for later runs and other
+/// processes to map. Returns null if out of memory or aborted.
+std::shared_ptr<epoch_context_full> build_full_epoch_context(int epoch_number,
+    const std::string& dir, unsigned int num_threads, const std::atomic<bool>& abort) noexcept;
+
 }  // namespace ethash
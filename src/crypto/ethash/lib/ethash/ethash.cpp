@@ -129,7 +129,7 @@ void build_light_cache(
 }
 
 epoch_context_full* create_epoch_context(
-    build_light_cache_fn build_fn, int epoch_number, bool full) noexcept
+    build_light_cache_fn build_fn, int epoch_number, bool full, hash1024* dataset) noexcept
 {
     static_assert(sizeof(epoch_context_full) < sizeof(hash512), "epoch_context too big");
     static constexpr size_t context_alloc_size = sizeof(hash512);
@@ -137,7 +137,9 @@ epoch_context_full* create_epoch_context(
     const int light_cache_num_items = calculate_light_cache_num_items(epoch_number);
     const int full_dataset_num_items = calculate_full_dataset_num_items(epoch_number);
     const size_t light_cache_size = get_light_cache_size(light_cache_num_items);
+    // A dataset provided by the caller also holds the L1 cache.
     const size_t full_dataset_size =
+        dataset ? 0 :
         full ? static_cast<size_t>(full_dataset_num_items) * sizeof(hash1024) :
                progpow::l1_cache_size;
 
@@ -151,7 +153,8 @@ epoch_context_full* create_epoch_context(
     const hash256 epoch_seed = calculate_epoch_seed(epoch_number);
     build_fn(light_cache, light_cache_num_items, epoch_seed);
 
-    uint32_t* const l1_cache =
+    uint32_t* const l1_cache = dataset ?
+        reinterpret_cast<uint32_t*>(dataset) :
         reinterpret_cast<uint32_t*>(alloc_data + context_alloc_size + light_cache_size);
 
     hash1024* full_dataset = full ? reinterpret_cast<hash1024*>(l1_cache) : nullptr;
@@ -402,6 +405,12 @@ epoch_context_full* ethash_create_epoch_context_full(int epoch_number) noexcept
     return generic::create_epoch_context(build_light_cache, epoch_number, true);
 }
 
+epoch_context_full* ethash_create_epoch_context_full_with_dataset(
+    int epoch_number, hash1024* dataset) noexcept
+{
+    return generic::create_epoch_context(build_light_cache, epoch_number, true, dataset);
+}
+
 void ethash_destroy_epoch_context_full(epoch_context_full* context) noexcept
 {
     ethash_destroy_epoch_context(context);
@@ -0,0 +1,265 @@
+// Copyright (c) 2024 The Griffion Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <crypto/ethash/lib/ethash/ethash-internal.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace ethash;
+
+namespace
+{
+/// Number of consecutive items a generating thread claims at a time.
+constexpr uint32_t generate_batch_size = 4096;
+
+/// Number of items compared against freshly generated ones when mapping a dataset file.
+constexpr int num_spot_check_items = 16;
+
+/// Memory holding a full dataset, released after the context using it.
+struct dataset_memory
+{
+    void* data = nullptr;
+    size_t size = 0;
+    bool mapped = false;
+};
+
+void release(const dataset_memory& memory) noexcept
+{
+#ifndef _WIN32
+    if (memory.mapped)
+    {
+        munmap(memory.data, memory.size);
+        return;
+    }
+#endif
+    std::free(memory.data);
+}
+
+/// Allocates zeroed anonymous memory, preferring huge pages.
+dataset_memory allocate(size_t size) noexcept
+{
+    dataset_memory memory;
+#ifndef _WIN32
+#if defined(MAP_HUGETLB)
+    // Huge pages must be reserved by the administrator, so this usually fails.
+    constexpr size_t huge_page_size = 2 * 1024 * 1024;
+    memory.size = (size + huge_page_size - 1) / huge_page_size * huge_page_size;
+    memory.data = mmap(nullptr, memory.size, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (memory.data != MAP_FAILED)
+    {
+        memory.mapped = true;
+        return memory;
+    }
+#endif
+    memory.size = size;
+    memory.data = mmap(nullptr, memory.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory.data != MAP_FAILED)
+    {
+#if defined(MADV_HUGEPAGE)
+        // Transparent huge pages cut the TLB misses of the random dataset reads.
+        madvise(memory.data, memory.size, MADV_HUGEPAGE);
+#endif
+        memory.mapped = true;
+        return memory;
+    }
+#endif
+    memory.size = size;
+    memory.data = std::calloc(1, size);
+    return memory;
+}
+
+std::shared_ptr<epoch_context_full> make_context(int epoch_number, const dataset_memory& memory) noexcept
+{
+    epoch_context_full* const context = ethash_create_epoch_context_full_with_dataset(
+        epoch_number, static_cast<hash1024*>(memory.data));
+    if (!context)
+    {
+        release(memory);
+        return nullptr;
+    }
+
+    try
+    {
+        return std::shared_ptr<epoch_context_full>{context, [memory](epoch_context_full* ctx) {
+            ethash_destroy_epoch_context_full(ctx);
+            release(memory);
+        }};
+    }
+    catch (...)
+    {
+        ethash_destroy_epoch_context_full(context);
+        release(memory);
+        return nullptr;
+    }
+}
+
+/// Compares some items of a mapped dataset against freshly generated ones.
+bool spot_check(const epoch_context_full& context) noexcept
+{
+    const uint32_t num_items = static_cast<uint32_t>(context.full_dataset_num_items);
+    for (int i = 0; i <= num_spot_check_items; ++i)
+    {
+        const uint32_t index = static_cast<uint32_t>(uint64_t{num_items - 1} * i / num_spot_check_items);
+        const hash1024 expected = calculate_dataset_item_1024(context, index);
+        if (std::memcmp(&expected, &context.full_dataset[index], sizeof(expected)) != 0)
+            return false;
+    }
+    return true;
+}
+
+#ifndef _WIN32
+std::string dataset_file_path(const std::string& dir, int epoch_number)
+{
+    return dir + "/kawpow" KAWPOW_REVISION "-epoch" + std::to_string(epoch_number) + ".dag";
+}
+
+/// Maps an existing dataset file. Pages are private so that writing the
+/// L1 cache does not touch the file, and shared with other processes
+/// mapping the same file until then.
+std::shared_ptr<epoch_context_full> map_dataset_file(
+    const std::string& path, int epoch_number, size_t size) noexcept
+{
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return nullptr;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<uint64_t>(st.st_size) != size)
+    {
+        close(fd);
+        return nullptr;
+    }
+
+    dataset_memory memory;
+    memory.size = size;
+    memory.data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (memory.data == MAP_FAILED)
+        return nullptr;
+    memory.mapped = true;
+    madvise(memory.data, size, MADV_RANDOM);
+
+    auto context = make_context(epoch_number, memory);
+    if (context && !spot_check(*context))
+        return nullptr;
+    return context;
+}
+
+/// Generates the dataset into a new file. It is written under a temporary
+/// name and renamed when complete, so a partial file is never mapped.
+std::shared_ptr<epoch_context_full> create_dataset_file(const std::string& path, int epoch_number,
+    size_t size, unsigned int num_threads, const std::atomic<bool>& abort) noexcept
+{
+    const std::string tmp_path = path + ".tmp" + std::to_string(getpid());
+    const int fd = open(tmp_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return nullptr;
+
+    dataset_memory memory;
+    memory.size = size;
+    if (ftruncate(fd, static_cast<off_t>(size)) == 0)
+        memory.data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (!memory.data || memory.data == MAP_FAILED)
+    {
+        unlink(tmp_path.c_str());
+        return nullptr;
+    }
+    memory.mapped = true;
+
+    auto context = make_context(epoch_number, memory);
+    if (!context || !generate_full_dataset(*context, num_threads, abort) ||
+        msync(memory.data, size, MS_SYNC) != 0 || rename(tmp_path.c_str(), path.c_str()) != 0)
+    {
+        unlink(tmp_path.c_str());
+        return nullptr;
+    }
+    return context;
+}
+#endif
+}  // namespace
+
+namespace ethash
+{
+bool generate_full_dataset(
+    const epoch_context_full& context, unsigned int num_threads, const std::atomic<bool>& abort) noexcept
+{
+    const uint32_t num_items = static_cast<uint32_t>(context.full_dataset_num_items);
+    std::atomic<uint32_t> next_item{0};
+
+    const auto generate = [&] {
+        while (!abort)
+        {
+            const uint32_t begin = next_item.fetch_add(generate_batch_size);
+            if (begin >= num_items)
+                return;
+            const uint32_t end = std::min(begin + generate_batch_size, num_items);
+            for (uint32_t i = begin; i < end; ++i)
+                context.full_dataset[i] = calculate_dataset_item_1024(context, i);
+        }
+    };
+
+    // Failing to start more threads leaves their share to the others.
+    std::vector<std::thread> threads;
+    try
+    {
+        threads.reserve(num_threads);
+        for (unsigned int i = 1; i < num_threads; ++i)
+            threads.emplace_back(generate);
+    }
+    catch (...)
+    {
+    }
+    generate();
+    for (auto& thread : threads)
+        thread.join();
+    return !abort;
+}
+
+std::shared_ptr<epoch_context_full> build_full_epoch_context(int epoch_number,
+    const std::string& dir, unsigned int num_threads, const std::atomic<bool>& abort) noexcept
+{
+    const size_t size =
+        static_cast<size_t>(calculate_full_dataset_num_items(epoch_number)) * sizeof(hash1024);
+
+#ifndef _WIN32
+    if (!dir.empty())
+    {
+        try
+        {
+            const std::string path = dataset_file_path(dir, epoch_number);
+            if (auto context = map_dataset_file(path, epoch_number, size))
+                return context;
+            if (auto context = create_dataset_file(path, epoch_number, size, num_threads, abort))
+                return context;
+        }
+        catch (const std::bad_alloc&)
+        {
+        }
+        if (abort)
+            return nullptr;
+        // Fall back to memory if the file cannot be used.
+    }
+#endif
+
+    const dataset_memory memory = allocate(size);
+    if (!memory.data)
+        return nullptr;
+    auto context = make_context(epoch_number, memory);
+    if (context && !generate_full_dataset(*context, num_threads, abort))
+        return nullptr;
+    return context;
+}
+}  // namespace ethash
@@ -5,7 +5,16 @@
 #include <crypto/ethash/lib/ethash/ethash-internal.hpp>
 #include <sync.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <list>
 #include <memory>
+#include <shared_mutex>
+#include <string>
+#include <system_error>
+#include <vector>
 
 #if !defined(__has_cpp_attribute)
 #define __has_cpp_attribute(x) 0
@@ -24,39 +33,214 @@ using namespace ethash;
 namespace
 {
 
-RecursiveMutex shared_context_cs;
-std::shared_ptr<epoch_context> shared_context;
+/// An entry of the shared light epoch context cache.
+struct cached_context
+{
+    std::shared_ptr<epoch_context> context;
+    /// Value of last_use_counter when the entry was last handed out.
+    std::atomic<uint64_t> last_used{0};
+
+    explicit cached_context(std::shared_ptr<epoch_context> ctx) noexcept : context{std::move(ctx)} {}
+};
+
+constexpr unsigned int min_cache_size = 2;
+constexpr unsigned int default_cache_size = 3;
+
+/// Guards the list of cached contexts. Lookups take a shared lock, only
+/// inserting and evicting entries takes an exclusive one.
+std::shared_mutex shared_contexts_mutex;
+std::list<cached_context> shared_contexts;
+std::atomic<unsigned int> shared_contexts_capacity{default_cache_size};
+std::atomic<uint64_t> last_use_counter{0};
+
+/// Serializes light cache builds so that concurrent misses for the same
+/// epoch build it only once. Not held while serving cache hits.
+Mutex build_context_mutex;
+
+std::atomic<uint64_t> stat_misses{0};
+std::atomic<uint64_t> stat_builds{0};
+std::atomic<uint64_t> stat_build_time_us{0};
+
+/// Cache hits are counted per thread, so that the fast path of
+/// ethash_get_global_epoch_context() does not write to memory shared with
+/// other threads. The counts are summed up when the stats are read.
+struct hit_counter;
+Mutex hit_counters_mutex;
+std::vector<const hit_counter*> hit_counters GUARDED_BY(hit_counters_mutex);
+/// Hits of the threads that have exited.
+uint64_t stat_exited_hits GUARDED_BY(hit_counters_mutex){0};
+
+struct hit_counter
+{
+    /// Only written by the owning thread.
+    std::atomic<uint64_t> hits{0};
+
+    hit_counter() noexcept
+    {
+        LOCK(hit_counters_mutex);
+        hit_counters.push_back(this);
+    }
+
+    ~hit_counter()
+    {
+        LOCK(hit_counters_mutex);
+        stat_exited_hits += hits.load(std::memory_order_relaxed);
+        hit_counters.erase(std::find(hit_counters.begin(), hit_counters.end(), this));
+    }
+
+    void add() noexcept { hits.store(hits.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+};
+
+thread_local hit_counter thread_local_hits;
+
 thread_local std::shared_ptr<epoch_context> thread_local_context;
 
+std::shared_ptr<epoch_context> find_shared_context(int epoch_number) noexcept
+{
+    std::shared_lock<std::shared_mutex> lock(shared_contexts_mutex);
+    for (auto& entry : shared_contexts)
+    {
+        if (entry.context->epoch_number == epoch_number)
+        {
+            entry.last_used.store(++last_use_counter, std::memory_order_relaxed);
+            return entry.context;
+        }
+    }
+    return nullptr;
+}
+
+/// Drop the least recently used entries until at most max_size remain.
+/// shared_contexts_mutex must be held exclusively.
+void evict_shared_contexts(size_t max_size) noexcept
+{
+    while (shared_contexts.size() > max_size)
+    {
+        auto lru = shared_contexts.begin();
+        for (auto it = shared_contexts.begin(); it != shared_contexts.end(); ++it)
+        {
+            if (it->last_used.load(std::memory_order_relaxed) <
+                lru->last_used.load(std::memory_order_relaxed))
+                lru = it;
+        }
+        // Threads still using the context keep it alive through their own
+        // shared pointer.
+        shared_contexts.erase(lru);
+    }
+}
+
+/// Options set by ethash_set_global_full_dataset_options().
+struct full_dataset_options
+{
+    ethash_full_dataset_mode mode = ETHASH_FULL_DATASET_LAZY;
+    std::string dir;
+    unsigned int num_threads = 1;
+};
+
+Mutex full_dataset_options_mutex;
+full_dataset_options full_options;
+
 RecursiveMutex shared_context_full_cs;
 std::shared_ptr<epoch_context_full> shared_context_full;
+
+/// Full context being built in the background by
+/// ethash_prepare_global_epoch_context_full().
+int prepared_epoch_number = -1;
+std::future<std::shared_ptr<epoch_context_full>> prepared_context_full;
+
+/// Stops dataset generation on exit, so that destroying prepared_context_full
+/// does not wait for a background build to finish.
+std::atomic<bool> abort_full_builds{false};
+struct abort_full_builds_on_exit
+{
+    ~abort_full_builds_on_exit() { abort_full_builds = true; }
+} abort_full_builds_guard;
+
 thread_local std::shared_ptr<epoch_context_full> thread_local_context_full;
 
+std::shared_ptr<epoch_context_full> build_full_context(
+    int epoch_number, const full_dataset_options& options) noexcept
+{
+    if (options.mode == ETHASH_FULL_DATASET_LAZY)
+        return create_epoch_context_full(epoch_number);
+
+    const std::string dir = options.mode == ETHASH_FULL_DATASET_FILE ? options.dir : std::string{};
+    return build_full_epoch_context(epoch_number, dir, options.num_threads, abort_full_builds);
+}
+
+/// Make the prepared context of the given epoch the shared one, if it is
+/// ready or wait is set. shared_context_full_cs must be held.
+void take_prepared_context_full(int epoch_number, bool wait)
+{
+    if (prepared_epoch_number != epoch_number || !prepared_context_full.valid())
+        return;
+    if (!wait && prepared_context_full.wait_for(std::chrono::seconds{0}) != std::future_status::ready)
+        return;
+
+    prepared_epoch_number = -1;
+    auto prepared = prepared_context_full.get();
+    if (prepared)
+        shared_context_full = std::move(prepared);
+}
+
+/// Build the context of an epoch and add it to the shared contexts.
+/// build_context_mutex must be held.
+std::shared_ptr<epoch_context> build_shared_context(int epoch_number) noexcept
+{
+    // Build new context without blocking lookups of other epochs.
+    const auto start = std::chrono::steady_clock::now();
+    std::shared_ptr<epoch_context> context{create_epoch_context(epoch_number)};
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    if (!context)
+        return nullptr;
+
+    stat_builds.fetch_add(1, std::memory_order_relaxed);
+    stat_build_time_us.fetch_add(
+        std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count(),
+        std::memory_order_relaxed);
+
+    std::unique_lock<std::shared_mutex> lock(shared_contexts_mutex);
+    evict_shared_contexts(shared_contexts_capacity.load() - 1);
+    auto& entry = shared_contexts.emplace_back(context);
+    entry.last_used.store(++last_use_counter, std::memory_order_relaxed);
+    return context;
+}
+
+/// Context build started by ethash_prepare_global_epoch_context(). It is
+/// added to the shared contexts when done, so nothing reads the result.
+Mutex prepare_context_mutex;
+std::future<void> prepared_context;
+
 /// Update thread local epoch context.
 ///
 /// This function is on the slow path. It's separated to allow inlining the fast
 /// path.
-///
-/// @todo: Redesign to guarantee deallocation before new allocation.
 ATTRIBUTE_NOINLINE
 void update_local_context(int epoch_number)
 {
     // Release the shared pointer of the obsoleted context.
     thread_local_context.reset();
 
-    // Local context invalid, check the shared context.
-    LOCK(shared_context_cs);
-
-    if (!shared_context || shared_context->epoch_number != epoch_number)
+    thread_local_context = find_shared_context(epoch_number);
+    if (thread_local_context)
     {
-        // Release the shared pointer of the obsoleted context.
-        shared_context.reset();
+        thread_local_hits.add();
+        return;
+    }
+
+    // Waits for a build of this epoch started by
+    // ethash_prepare_global_epoch_context() to finish.
+    LOCK(build_context_mutex);
 
-        // Build new context.
-        shared_context = create_epoch_context(epoch_number);
+    // Another thread may have built the context while we were waiting.
+    thread_local_context = find_shared_context(epoch_number);
+    if (thread_local_context)
+    {
+        thread_local_hits.add();
+        return;
     }
+    stat_misses.fetch_add(1, std::memory_order_relaxed);
 
-    thread_local_context = shared_context;
+    thread_local_context = build_shared_context(epoch_number);
 }
 
 ATTRIBUTE_NOINLINE
@@ -73,8 +257,17 @@ void update_local_context_full(int epoch_number)
         // Release the shared pointer of the obsoleted context.
         shared_context_full.reset();
 
-        // Build new context.
-        shared_context_full = create_epoch_context_full(epoch_number);
+        // Use the context built in the background, or build a new one.
+        take_prepared_context_full(epoch_number, /*wait=*/true);
+        if (!shared_context_full)
+        {
+            full_dataset_options options;
+            {
+                LOCK(full_dataset_options_mutex);
+                options = full_options;
+            }
+            shared_context_full = build_full_context(epoch_number, options);
+        }
     }
 
     thread_local_context_full = shared_context_full;
@@ -86,10 +279,73 @@ const ethash_epoch_context* ethash_get_global_epoch_context(int epoch_number) no
     // Check if local context matches epoch number.
     if (!thread_local_context || thread_local_context->epoch_number != epoch_number)
         update_local_context(epoch_number);
+    else
+        thread_local_hits.add();
 
     return thread_local_context.get();
 }
 
+void ethash_prepare_global_epoch_context(int epoch_number) noexcept
+{
+    if (find_shared_context(epoch_number))
+        return;
+
+    LOCK(prepare_context_mutex);
+    // Only one background build at a time.
+    if (prepared_context.valid() &&
+        prepared_context.wait_for(std::chrono::seconds{0}) != std::future_status::ready)
+        return;
+
+    try
+    {
+        prepared_context = std::async(std::launch::async, [epoch_number] {
+            LOCK(build_context_mutex);
+            if (!find_shared_context(epoch_number))
+                build_shared_context(epoch_number);
+        });
+    }
+    catch (const std::system_error&)
+    {
+    }
+}
+
+void ethash_set_global_epoch_context_cache_size(unsigned int size) noexcept
+{
+    size = std::max(size, min_cache_size);
+    shared_contexts_capacity.store(size);
+
+    std::unique_lock<std::shared_mutex> lock(shared_contexts_mutex);
+    evict_shared_contexts(size);
+}
+
+ethash_epoch_context_cache_stats ethash_get_global_epoch_context_cache_stats() noexcept
+{
+    ethash_epoch_context_cache_stats stats{};
+    {
+        LOCK(hit_counters_mutex);
+        stats.hits = stat_exited_hits;
+        for (const hit_counter* counter : hit_counters)
+            stats.hits += counter->hits.load(std::memory_order_relaxed);
+    }
+    stats.misses = stat_misses.load(std::memory_order_relaxed);
+    stats.builds = stat_builds.load(std::memory_order_relaxed);
+    stats.build_time_us = stat_build_time_us.load(std::memory_order_relaxed);
+    stats.capacity = shared_contexts_capacity.load();
+
+    std::shared_lock<std::shared_mutex> lock(shared_contexts_mutex);
+    stats.cached_epochs = static_cast<uint32_t>(shared_contexts.size());
+    return stats;
+}
+
+void ethash_set_global_full_dataset_options(
+    ethash_full_dataset_mode mode, const char* dir, unsigned int num_threads) noexcept
+{
+    LOCK(full_dataset_options_mutex);
+    full_options.mode = mode;
+    full_options.dir = dir ? dir : "";
+    full_options.num_threads = std::max(num_threads, 1U);
+}
+
 const ethash_epoch_context_full* ethash_get_global_epoch_context_full(int epoch_number) noexcept
 {
     // Check if local context matches epoch number.
@@ -98,3 +354,35 @@ const ethash_epoch_context_full* ethash_get_global_epoch_context_full(int epoch_
 
     return thread_local_context_full.get();
 }
+
+void ethash_prepare_global_epoch_context_full(int epoch_number) noexcept
+{
+    full_dataset_options options;
+    {
+        LOCK(full_dataset_options_mutex);
+        options = full_options;
+    }
+    if (options.mode == ETHASH_FULL_DATASET_LAZY)
+        return;
+
+    LOCK(shared_context_full_cs);
+    if (shared_context_full && shared_context_full->epoch_number == epoch_number)
+        return;
+    if (prepared_context_full.valid())
+    {
+        // Only one background build at a time.
+        if (prepared_epoch_number == epoch_number ||
+            prepared_context_full.wait_for(std::chrono::seconds{0}) != std::future_status::ready)
+            return;
+    }
+
+    try
+    {
+        prepared_context_full = std::async(std::launch::async,
+            [epoch_number, options] { return build_full_context(epoch_number, options); });
+        prepared_epoch_number = epoch_number;
+    }
+    catch (const std::system_error&)
+    {
+    }
+}
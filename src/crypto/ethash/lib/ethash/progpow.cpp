@@ -10,7 +10,10 @@
 #include <crypto/ethash/lib/ethash/kiss99.hpp>
 #include <crypto/ethash/include/ethash/keccak.hpp>
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <limits>
 
 namespace progpow
 {
@@ -166,14 +169,27 @@ using lookup_fn = hash2048 (*)(const epoch_context&, uint32_t);
 
 using mix_array = std::array<std::array<uint32_t, num_regs>, num_lanes>;
 
-void round(
-    const epoch_context& context, uint32_t r, mix_array& mix, mix_rng_state state, lookup_fn lookup)
+/// The largest number of mixes computed together by hash_mixes().
+constexpr size_t max_mixes = 8;
+
+/// Runs round r of the mix loop over `count` mixes at once.
+///
+/// The random program depends only on the block period, so each cache and
+/// math step is drawn from `state` once and applied to every mix. The dataset
+/// items of all mixes are looked up before any of them is merged, so their
+/// memory accesses overlap.
+void round(const epoch_context& context, uint32_t r, mix_array mixes[], size_t count,
+    mix_rng_state state, lookup_fn lookup)
 {
     const uint32_t num_items = static_cast<uint32_t>(context.full_dataset_num_items / 2);
-    const uint32_t item_index = mix[r % num_lanes][0] % num_items;
-    const hash2048 item = lookup(context, item_index);
+    hash2048 items[max_mixes];
+    for (size_t n = 0; n < count; ++n)
+    {
+        const uint32_t item_index = mixes[n][r % num_lanes][0] % num_items;
+        items[n] = lookup(context, item_index);
+    }
 
-    constexpr size_t num_words_per_lane = sizeof(item) / (sizeof(uint32_t) * num_lanes);
+    constexpr size_t num_words_per_lane = sizeof(hash2048) / (sizeof(uint32_t) * num_lanes);
     constexpr int max_operations =
         num_cache_accesses > num_math_operations ? num_cache_accesses : num_math_operations;
 
@@ -186,10 +202,14 @@ void round(
             const auto dst = state.next_dst();
             const auto sel = state.rng();
 
-            for (size_t l = 0; l < num_lanes; ++l)
+            for (size_t n = 0; n < count; ++n)
             {
-                const size_t offset = mix[l][src] % l1_cache_num_items;
-                random_merge(mix[l][dst], le::uint32(context.l1_cache[offset]), sel);
+                auto& mix = mixes[n];
+                for (size_t l = 0; l < num_lanes; ++l)
+                {
+                    const size_t offset = mix[l][src] % l1_cache_num_items;
+                    random_merge(mix[l][dst], le::uint32(context.l1_cache[offset]), sel);
+                }
             }
         }
         if (i < num_math_operations)  // Random math.
@@ -205,10 +225,14 @@ void round(
             const auto dst = state.next_dst();
             const auto sel2 = state.rng();
 
-            for (size_t l = 0; l < num_lanes; ++l)
+            for (size_t n = 0; n < count; ++n)
             {
-                const uint32_t data = random_math(mix[l][src1], mix[l][src2], sel1);
-                random_merge(mix[l][dst], data, sel2);
+                auto& mix = mixes[n];
+                for (size_t l = 0; l < num_lanes; ++l)
+                {
+                    const uint32_t data = random_math(mix[l][src1], mix[l][src2], sel1);
+                    random_merge(mix[l][dst], data, sel2);
+                }
             }
         }
     }
@@ -223,13 +247,17 @@ void round(
     }
 
     // DAG access.
-    for (size_t l = 0; l < num_lanes; ++l)
+    for (size_t n = 0; n < count; ++n)
     {
-        const auto offset = ((l ^ r) % num_lanes) * num_words_per_lane;
-        for (size_t i = 0; i < num_words_per_lane; ++i)
+        auto& mix = mixes[n];
+        for (size_t l = 0; l < num_lanes; ++l)
         {
-            const auto word = le::uint32(item.word32s[offset + i]);
-            random_merge(mix[l][dsts[i]], word, sels[i]);
+            const auto offset = ((l ^ r) % num_lanes) * num_words_per_lane;
+            for (size_t i = 0; i < num_words_per_lane; ++i)
+            {
+                const auto word = le::uint32(items[n].word32s[offset + i]);
+                random_merge(mix[l][dsts[i]], word, sels[i]);
+            }
         }
     }
 }
@@ -252,10 +280,15 @@ mix_array init_mix(uint32_t* hash_seed)
     return mix;
 }
 
-hash256 hash_mix(
-    const epoch_context& context, int block_number, uint32_t * seed, lookup_fn lookup) noexcept
+/// Computes the mixes of `count` seeds, at most max_mixes, in one pass over
+/// the rounds.
+void hash_mixes(const epoch_context& context, int block_number, uint32_t* const seeds[],
+    size_t count, lookup_fn lookup, hash256 hashMixes[]) noexcept
 {
-    auto mix = init_mix(seed);
+    mix_array mixes[max_mixes];
+    for (size_t n = 0; n < count; ++n)
+        mixes[n] = init_mix(seeds[n]);
+
     auto number = uint64_t(block_number / period_length);
     uint32_t new_state[2];
     new_state[0] = number;
@@ -263,25 +296,176 @@ hash256 hash_mix(
     mix_rng_state state{new_state};
 
     for (uint32_t i = 0; i < 64; ++i)
-        round(context, i, mix, state, lookup);
+        round(context, i, mixes, count, state, lookup);
 
-    // Reduce mix data to a single per-lane result.
-    uint32_t lane_hash[num_lanes];
-    for (size_t l = 0; l < num_lanes; ++l)
+    for (size_t n = 0; n < count; ++n)
     {
-        lane_hash[l] = fnv_offset_basis;
-        for (uint32_t i = 0; i < num_regs; ++i)
-            lane_hash[l] = fnv1a(lane_hash[l], mix[l][i]);
+        const mix_array& mix = mixes[n];
+
+        // Reduce mix data to a single per-lane result.
+        uint32_t lane_hash[num_lanes];
+        for (size_t l = 0; l < num_lanes; ++l)
+        {
+            lane_hash[l] = fnv_offset_basis;
+            for (uint32_t i = 0; i < num_regs; ++i)
+                lane_hash[l] = fnv1a(lane_hash[l], mix[l][i]);
+        }
+
+        // Reduce all lanes to a single 256-bit result.
+        static constexpr size_t num_words = sizeof(hash256) / sizeof(uint32_t);
+        hash256 hashMix;
+        for (uint32_t& w : hashMix.word32s)
+            w = fnv_offset_basis;
+        for (size_t l = 0; l < num_lanes; ++l)
+            hashMix.word32s[l % num_words] = fnv1a(hashMix.word32s[l % num_words], lane_hash[l]);
+        hashMixes[n] = le::uint32s(hashMix);
     }
+}
 
-    // Reduce all lanes to a single 256-bit result.
-    static constexpr size_t num_words = sizeof(hash256) / sizeof(uint32_t);
+hash256 hash_mix(
+    const epoch_context& context, int block_number, uint32_t * seed, lookup_fn lookup) noexcept
+{
     hash256 hashMix;
-    for (uint32_t& w : hashMix.word32s)
-        w = fnv_offset_basis;
-    for (size_t l = 0; l < num_lanes; ++l)
-        hashMix.word32s[l % num_words] = fnv1a(hashMix.word32s[l % num_words], lane_hash[l]);
-    return le::uint32s(hashMix);
+    hash_mixes(context, block_number, &seed, 1, lookup, &hashMix);
+    return hashMix;
+}
+
+/// Looks up an item of the full dataset, generating it when first hit.
+///
+/// Several threads may search with the same dataset, so the words of an item
+/// are only accessed atomically. The first word marks the item as generated
+/// and is stored last, with release ordering, so a thread that sees it set
+/// also sees the rest of the item. Threads filling in the same item at the
+/// same time store identical values.
+hash2048 lazy_lookup(const epoch_context& ctx, uint32_t index) noexcept
+{
+    auto* full_dataset_1024 = static_cast<const epoch_context_full&>(ctx).full_dataset;
+    auto* full_dataset_2048 = reinterpret_cast<hash2048*>(full_dataset_1024);
+    uint64_t* const words = full_dataset_2048[index].word64s;
+    constexpr size_t num_words = sizeof(hash2048) / sizeof(uint64_t);
+
+    hash2048 item;
+    item.word64s[0] = std::atomic_ref<uint64_t>{words[0]}.load(std::memory_order_acquire);
+    if (item.word64s[0] != 0)
+    {
+        for (size_t i = 1; i < num_words; ++i)
+            item.word64s[i] = std::atomic_ref<uint64_t>{words[i]}.load(std::memory_order_relaxed);
+        return item;
+    }
+
+    item = calculate_dataset_item_2048(ctx, index);
+    for (size_t i = 1; i < num_words; ++i)
+        std::atomic_ref<uint64_t>{words[i]}.store(item.word64s[i], std::memory_order_relaxed);
+    std::atomic_ref<uint64_t>{words[0]}.store(item.word64s[0], std::memory_order_release);
+    return item;
+}
+
+/// Initial keccak of 8 (header hash, nonce) pairs at once.
+///
+/// Fills the 8 words of state carried over to the final keccak for each pair.
+void init_keccak_8way(const hash256 header_hashes[8], const uint64_t nonces[8],
+    uint32_t state2[8][8]) noexcept
+{
+    uint32_t states[8][25];
+    for (int n = 0; n < 8; ++n)
+    {
+        uint32_t* state = states[n];
+
+        // 1st fill with header data (8 words)
+        for (int i = 0; i < 8; i++)
+            state[i] = header_hashes[n].word32s[i];
+
+        // 2nd fill with nonce (2 words)
+        state[8] = nonces[n];
+        state[9] = nonces[n] >> 32;
+
+        // 3rd apply ethash input constraints
+        for (int i = 10; i < 25; i++)
+            state[i] = ethash_constants[i-10];
+    }
+
+    ethash_keccakf800_8way(states);
+
+    for (int n = 0; n < 8; ++n)
+        for (int i = 0; i < 8; i++)
+            state2[n][i] = states[n][i];
+}
+
+/// Final keccak of 8 (carry-over state, mix) pairs at once.
+void final_keccak_8way(const uint32_t state2[8][8], const hash256 hashMixes[8],
+    hash256 final_hashes[8]) noexcept
+{
+    uint32_t states[8][25];
+    for (int n = 0; n < 8; ++n)
+    {
+        uint32_t* state = states[n];
+
+        // 1st initial 8 words of state are kept as carry-over from initial keccak
+        for (int i = 0; i < 8; i++)
+            state[i] = state2[n][i];
+
+        // 2nd subsequent 8 words are carried from digest/mix
+        for (int i = 8; i < 16; i++)
+            state[i] = hashMixes[n].word32s[i-8];
+
+        // 3rd apply ethash input constraints
+        for (int i = 16; i < 25; i++)
+            state[i] = ethash_constants[i - 16];
+    }
+
+    ethash_keccakf800_8way(states);
+
+    for (int n = 0; n < 8; ++n)
+        for (int i = 0; i < 8; ++i)
+            final_hashes[n].word32s[i] = le::uint32(states[n][i]);
+}
+
+/// Search 8 nonces at a time, batching the keccak permutations and the mix
+/// loop of the group.
+search_result search_8way(const epoch_context& context, int block_number,
+    const hash256& header_hash, const hash256& boundary, uint64_t start_nonce,
+    size_t iterations, lookup_fn lookup) noexcept
+{
+    hash256 header_hashes[8];
+    for (auto& h : header_hashes)
+        h = header_hash;
+
+    // Count the nonces left rather than comparing against an end nonce, so a range that
+    // reaches the top of the nonce space stops at UINT64_MAX instead of wrapping.
+    uint64_t remaining = iterations;
+    if (remaining != 0 && remaining - 1 > std::numeric_limits<uint64_t>::max() - start_nonce)
+        remaining = std::numeric_limits<uint64_t>::max() - start_nonce + 1;
+
+    for (uint64_t first_nonce = start_nonce; remaining != 0;)
+    {
+        const size_t count = static_cast<size_t>(std::min<uint64_t>(8, remaining));
+
+        uint64_t nonces[8];
+        for (size_t n = 0; n < 8; ++n)
+            nonces[n] = first_nonce + n;
+
+        uint32_t state2[8][8];
+        init_keccak_8way(header_hashes, nonces, state2);
+
+        uint32_t* seeds[8];
+        for (size_t n = 0; n < 8; ++n)
+            seeds[n] = state2[n];
+
+        hash256 hashMixes[8] = {};
+        hash_mixes(context, block_number, seeds, count, lookup, hashMixes);
+
+        hash256 final_hashes[8];
+        final_keccak_8way(state2, hashMixes, final_hashes);
+
+        for (size_t n = 0; n < count; ++n)
+        {
+            if (is_less_or_equal(final_hashes[n], boundary))
+                return {result{final_hashes[n], hashMixes[n]}, nonces[n]};
+        }
+        first_nonce += count;
+        remaining -= count;
+    }
+    return {};
 }
 }  // namespace
 
@@ -347,20 +531,6 @@ result hash(const epoch_context& context, int block_number, const hash256& heade
 result hash(const epoch_context_full& context, int block_number, const hash256& header_hash,
     uint64_t nonce) noexcept
 {
-    static const auto lazy_lookup = [](const epoch_context& ctx, uint32_t index) noexcept
-    {
-        auto* full_dataset_1024 = static_cast<const epoch_context_full&>(ctx).full_dataset;
-        auto* full_dataset_2048 = reinterpret_cast<hash2048*>(full_dataset_1024);
-        hash2048& item = full_dataset_2048[index];
-        if (item.word64s[0] == 0)
-        {
-            // TODO: Copy elision here makes it thread-safe?
-            item = calculate_dataset_item_2048(ctx, index);
-        }
-
-        return item;
-    };
-
     uint32_t hash_seed[2];  // KISS99 initiator
 
     uint32_t state2[8];
@@ -540,32 +710,29 @@ hash256 hash_no_verify(const int& block_number, const hash256& header_hash,
 }
 
 
+void hash_no_verify_8way(const hash256 header_hashes[8], const hash256 hashMixes[8],
+    const uint64_t nonces[8], hash256 final_hashes[8]) noexcept
+{
+    uint32_t state2[8][8];
+    init_keccak_8way(header_hashes, nonces, state2);
+    final_keccak_8way(state2, hashMixes, final_hashes);
+}
+
+
 search_result search_light(const epoch_context& context, int block_number,
     const hash256& header_hash, const hash256& boundary, uint64_t start_nonce,
     size_t iterations) noexcept
 {
-    const uint64_t end_nonce = start_nonce + iterations;
-    for (uint64_t nonce = start_nonce; nonce < end_nonce; ++nonce)
-    {
-        result r = hash(context, block_number, header_hash, nonce);
-        if (is_less_or_equal(r.final_hash, boundary))
-            return {r, nonce};
-    }
-    return {};
+    return search_8way(context, block_number, header_hash, boundary, start_nonce, iterations,
+        calculate_dataset_item_2048);
 }
 
 search_result search(const epoch_context_full& context, int block_number,
     const hash256& header_hash, const hash256& boundary, uint64_t start_nonce,
     size_t iterations) noexcept
 {
-    const uint64_t end_nonce = start_nonce + iterations;
-    for (uint64_t nonce = start_nonce; nonce < end_nonce; ++nonce)
-    {
-        result r = hash(context, block_number, header_hash, nonce);
-        if (is_less_or_equal(r.final_hash, boundary))
-            return {r, nonce};
-    }
-    return {};
+    return search_8way(context, block_number, header_hash, boundary, start_nonce, iterations,
+        lazy_lookup);
 }
 
 }  // namespace progpow
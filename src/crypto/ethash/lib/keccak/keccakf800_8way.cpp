@@ -0,0 +1,87 @@
+// Copyright (c) 2024 The Griffion Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#if defined(HAVE_CONFIG_H)
+#include <config/griffion-config.h>
+#endif
+
+#include <crypto/ethash/include/ethash/keccak.h>
+
+#include <compat/cpuid.h>
+
+#include <assert.h>
+#include <string.h>
+
+#if defined(ENABLE_AVX2)
+namespace keccakf800_avx2
+{
+void Permute_8way(uint32_t states[8][25]);
+}
+#endif
+
+namespace
+{
+void Permute_8way_generic(uint32_t states[8][25])
+{
+    for (int i = 0; i < 8; ++i)
+        ethash_keccakf800(states[i]);
+}
+
+typedef void (*Permute8wayFn)(uint32_t states[8][25]);
+Permute8wayFn Permute_8way = Permute_8way_generic;
+
+/** Check the selected implementation against the scalar one. */
+bool SelfTest()
+{
+    uint32_t states[8][25];
+    uint32_t expected[8][25];
+    for (uint32_t i = 0; i < 8; ++i)
+        for (uint32_t j = 0; j < 25; ++j)
+            states[i][j] = expected[i][j] = 0x9e3779b9 * (i * 25 + j + 1);
+
+    Permute_8way_generic(expected);
+    Permute_8way(states);
+    return memcmp(states, expected, sizeof(states)) == 0;
+}
+
+#if defined(HAVE_GETCPUID)
+/** Check whether the OS has enabled AVX registers. */
+bool AVXEnabled()
+{
+    uint32_t a, d;
+    __asm__("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+    return (a & 6) == 6;
+}
+#endif
+}  // namespace
+
+void ethash_keccakf800_8way(uint32_t states[8][25]) noexcept
+{
+    Permute_8way(states);
+}
+
+const char* ethash_keccakf800_autodetect() noexcept
+{
+    const char* ret = "standard";
+    Permute_8way = Permute_8way_generic;
+
+#if defined(HAVE_GETCPUID) && defined(ENABLE_AVX2)
+    uint32_t eax, ebx, ecx, edx;
+    GetCPUID(1, 0, eax, ebx, ecx, edx);
+    const bool have_xsave = (ecx >> 27) & 1;
+    const bool have_avx = (ecx >> 28) & 1;
+    if (have_xsave && have_avx && AVXEnabled())
+    {
+        GetCPUID(7, 0, eax, ebx, ecx, edx);
+        if ((ebx >> 5) & 1)
+        {
+            Permute_8way = keccakf800_avx2::Permute_8way;
+            ret = "avx2(8way)";
+        }
+    }
+#endif
+
+    assert(SelfTest());
+    return ret;
+}
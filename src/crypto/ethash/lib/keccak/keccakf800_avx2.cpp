@@ -0,0 +1,93 @@
+// Copyright (c) 2024 The Griffion Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifdef ENABLE_AVX2
+
+#include <stdint.h>
+#include <immintrin.h>
+
+namespace keccakf800_avx2 {
+namespace {
+
+constexpr uint32_t round_constants[22] = {
+    0x00000001, 0x00008082, 0x0000808A, 0x80008000, 0x0000808B, 0x80000001,
+    0x80008081, 0x00008009, 0x0000008A, 0x00000088, 0x80008009, 0x8000000A,
+    0x8000808B, 0x0000008B, 0x00008089, 0x00008003, 0x00008002, 0x00000080,
+    0x0000800A, 0x8000000A, 0x80008081, 0x00008080,
+};
+
+/** Rotation offsets of the rho step, indexed by x + 5 * y. */
+constexpr int rho[25] = {
+    0, 1, 30, 28, 27,
+    4, 12, 6, 23, 20,
+    3, 10, 11, 25, 7,
+    9, 13, 15, 21, 8,
+    18, 2, 29, 24, 14,
+};
+
+/** Destination of lane x + 5 * y in the pi step, which is y + 5 * ((2x + 3y) % 5). */
+constexpr int pi[25] = {
+    0, 10, 20, 5, 15,
+    16, 1, 11, 21, 6,
+    7, 17, 2, 12, 22,
+    23, 8, 18, 3, 13,
+    14, 24, 9, 19, 4,
+};
+
+__m256i inline Xor(__m256i x, __m256i y) { return _mm256_xor_si256(x, y); }
+__m256i inline AndNot(__m256i x, __m256i y) { return _mm256_andnot_si256(x, y); }
+__m256i inline Rol(__m256i x, int n) { return _mm256_or_si256(_mm256_sllv_epi32(x, _mm256_set1_epi32(n)), _mm256_srlv_epi32(x, _mm256_set1_epi32(32 - n))); }
+
+} // namespace
+
+void Permute_8way(uint32_t states[8][25])
+{
+    __m256i A[25];
+    for (int i = 0; i < 25; ++i) {
+        A[i] = _mm256_set_epi32(states[7][i], states[6][i], states[5][i], states[4][i],
+                                states[3][i], states[2][i], states[1][i], states[0][i]);
+    }
+
+    __m256i B[25];
+    __m256i C[5];
+    for (int round = 0; round < 22; ++round) {
+        // Theta
+        for (int x = 0; x < 5; ++x) {
+            C[x] = Xor(Xor(Xor(A[x], A[x + 5]), Xor(A[x + 10], A[x + 15])), A[x + 20]);
+        }
+        for (int x = 0; x < 5; ++x) {
+            const __m256i D = Xor(C[(x + 4) % 5], Rol(C[(x + 1) % 5], 1));
+            for (int y = 0; y < 25; y += 5) {
+                A[y + x] = Xor(A[y + x], D);
+            }
+        }
+
+        // Rho and pi
+        for (int i = 0; i < 25; ++i) {
+            B[pi[i]] = Rol(A[i], rho[i]);
+        }
+
+        // Chi
+        for (int y = 0; y < 25; y += 5) {
+            for (int x = 0; x < 5; ++x) {
+                A[y + x] = Xor(B[y + x], AndNot(B[y + (x + 1) % 5], B[y + (x + 2) % 5]));
+            }
+        }
+
+        // Iota
+        A[0] = Xor(A[0], _mm256_set1_epi32(round_constants[round]));
+    }
+
+    alignas(32) uint32_t lanes[8];
+    for (int i = 0; i < 25; ++i) {
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), A[i]);
+        for (int j = 0; j < 8; ++j) {
+            states[j][i] = lanes[j];
+        }
+    }
+}
+
+} // namespace keccakf800_avx2
+
+#endif
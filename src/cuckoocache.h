@@ -484,6 +484,21 @@ public:
             }
         return false;
     }
+
+    /** for_each calls f on every element in the table that is not
+     * collected yet, such as to save the contents of the cache.
+     *
+     * for_each is not thread safe with insert.
+     *
+     * @param f the function to call with each element
+     */
+    template <typename F>
+    void for_each(F f) const
+    {
+        for (uint32_t i = 0; i < size; ++i) {
+            if (!collection_flags.bit_is_set(i)) f(table[i]);
+        }
+    }
 };
 } // namespace CuckooCache
 
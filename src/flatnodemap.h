@@ -0,0 +1,368 @@
+// Copyright (c) 2024 The Griffion Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef GRIFFION_FLATNODEMAP_H
+#define GRIFFION_FLATNODEMAP_H
+
+#include <crypto/common.h>
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+/**
+ * Hash map with an open addressing index over separately allocated entries.
+ *
+ * The index is a flat array of one control byte and one entry pointer per
+ * slot. A control byte holds 7 bits of the hash of a used slot, so a lookup
+ * compares the bytes of a group of 8 slots at once and only dereferences the
+ * entries whose bits match, usually only the one it is looking for. This
+ * avoids the bucket and node chains of std::unordered_map and needs fewer
+ * bytes per entry.
+ *
+ * Entries are allocated one at a time from the allocator, usually a
+ * PoolAllocator, and never move. References to entries stay valid until the
+ * entry is erased, even when the index grows. Iterators are invalidated by
+ * inserting into the map, but not by erasing other entries, so erase() can
+ * be used while iterating.
+ *
+ * Only the subset of the std::unordered_map interface used for the coins
+ * cache is provided.
+ */
+template <typename Key, typename T, typename Hash, typename KeyEqual, typename Allocator>
+class FlatNodeMap
+{
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<const Key, T>;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using allocator_type = Allocator;
+
+private:
+    static constexpr size_t GROUP_WIDTH{8};
+    static constexpr uint64_t LSBS{0x0101010101010101};
+    static constexpr uint64_t MSBS{0x8080808080808080};
+
+    //! Control bytes of unused slots. Used slots store 7 bits of the hash.
+    static constexpr uint8_t CTRL_EMPTY{0x80};
+    static constexpr uint8_t CTRL_DELETED{0xfe};
+
+    static constexpr bool IsFull(uint8_t ctrl) { return (ctrl & 0x80) == 0; }
+
+    //! Bit 7 of each byte that equals h2.
+    static constexpr uint64_t MatchByte(uint64_t group, uint8_t h2)
+    {
+        const uint64_t x{group ^ (LSBS * h2)};
+        return (x - LSBS) & ~x & MSBS;
+    }
+
+    //! Bit 7 of each byte that is CTRL_EMPTY.
+    static constexpr uint64_t MatchEmpty(uint64_t group) { return group & ~(group << 6) & MSBS; }
+
+    //! Bit 7 of each byte that is CTRL_EMPTY or CTRL_DELETED.
+    static constexpr uint64_t MatchEmptyOrDeleted(uint64_t group) { return group & MSBS; }
+
+    //! Smallest capacity that holds num_entries without exceeding the maximum load of 7/8.
+    static constexpr size_t CapacityFor(size_t num_entries)
+    {
+        size_t capacity{GROUP_WIDTH};
+        while (capacity - capacity / 8 < num_entries) capacity *= 2;
+        return capacity;
+    }
+
+    [[no_unique_address]] hasher m_hash;
+    [[no_unique_address]] key_equal m_key_equal;
+    allocator_type m_alloc;
+
+    std::unique_ptr<uint8_t[]> m_ctrl;
+    std::unique_ptr<value_type*[]> m_slots;
+    size_t m_capacity{0};
+    size_t m_size{0};
+    //! Number of empty slots that can be used before the index has to grow.
+    size_t m_growth_left{0};
+
+    uint64_t LoadGroup(size_t group) const { return ReadLE64(&m_ctrl[group * GROUP_WIDTH]); }
+
+    /** Index of the slot holding key, or m_capacity if there is none. */
+    size_t FindSlot(const Key& key, size_t hash) const
+    {
+        if (m_capacity == 0) return m_capacity;
+        const uint8_t h2{static_cast<uint8_t>(hash & 0x7f)};
+        const size_t group_mask{m_capacity / GROUP_WIDTH - 1};
+        size_t group{(hash >> 7) & group_mask};
+        for (size_t step{1};; ++step) {
+            const uint64_t ctrl{LoadGroup(group)};
+            for (uint64_t match{MatchByte(ctrl, h2)}; match != 0; match &= match - 1) {
+                const size_t slot{group * GROUP_WIDTH + std::countr_zero(match) / 8};
+                if (m_key_equal(m_slots[slot]->first, key)) return slot;
+            }
+            if (MatchEmpty(ctrl) != 0) return m_capacity;
+            group = (group + step) & group_mask;
+        }
+    }
+
+    /** Index of the first unused slot on the probe sequence of hash. */
+    size_t FindInsertSlot(size_t hash) const
+    {
+        const size_t group_mask{m_capacity / GROUP_WIDTH - 1};
+        size_t group{(hash >> 7) & group_mask};
+        for (size_t step{1};; ++step) {
+            const uint64_t match{MatchEmptyOrDeleted(LoadGroup(group))};
+            if (match != 0) return group * GROUP_WIDTH + std::countr_zero(match) / 8;
+            group = (group + step) & group_mask;
+        }
+    }
+
+    /** Rebuild the index with the given capacity. Entries are not moved. */
+    void Resize(size_t capacity)
+    {
+        auto old_ctrl{std::move(m_ctrl)};
+        auto old_slots{std::move(m_slots)};
+        const size_t old_capacity{m_capacity};
+
+        m_ctrl = std::make_unique_for_overwrite<uint8_t[]>(capacity);
+        m_slots = std::make_unique_for_overwrite<value_type*[]>(capacity);
+        std::memset(m_ctrl.get(), CTRL_EMPTY, capacity);
+        m_capacity = capacity;
+        m_growth_left = capacity - capacity / 8 - m_size;
+
+        for (size_t i{0}; i < old_capacity; ++i) {
+            if (!IsFull(old_ctrl[i])) continue;
+            const size_t hash{m_hash(old_slots[i]->first)};
+            const size_t slot{FindInsertSlot(hash)};
+            m_ctrl[slot] = static_cast<uint8_t>(hash & 0x7f);
+            m_slots[slot] = old_slots[i];
+        }
+    }
+
+    void DestroyEntry(value_type* entry) noexcept
+    {
+        std::destroy_at(entry);
+        m_alloc.deallocate(entry, 1);
+    }
+
+    void EraseSlot(size_t slot) noexcept
+    {
+        DestroyEntry(m_slots[slot]);
+        --m_size;
+        // A lookup only continues past a group without empty slots. If this
+        // group has one, no lookup can depend on this slot being used, and it
+        // can become empty instead of a tombstone.
+        if (MatchEmpty(LoadGroup(slot / GROUP_WIDTH)) != 0) {
+            m_ctrl[slot] = CTRL_EMPTY;
+            ++m_growth_left;
+        } else {
+            m_ctrl[slot] = CTRL_DELETED;
+        }
+    }
+
+    template <typename K, typename... Args>
+    std::pair<size_t, bool> TryEmplace(K&& key, Args&&... args)
+    {
+        const size_t hash{m_hash(key)};
+        const size_t found{FindSlot(key, hash)};
+        if (found != m_capacity) return {found, false};
+
+        if (m_growth_left == 0) {
+            // Grow by half of the entries; if most unused slots are
+            // tombstones, this rebuilds the index at the same size.
+            Resize(CapacityFor(m_size + m_size / 2 + 1));
+        }
+        value_type* entry{m_alloc.allocate(1)};
+        try {
+            ::new (entry) value_type(std::piecewise_construct,
+                                     std::forward_as_tuple(std::forward<K>(key)),
+                                     std::forward_as_tuple(std::forward<Args>(args)...));
+        } catch (...) {
+            m_alloc.deallocate(entry, 1);
+            throw;
+        }
+        const size_t slot{FindInsertSlot(hash)};
+        if (m_ctrl[slot] == CTRL_EMPTY) --m_growth_left;
+        m_ctrl[slot] = static_cast<uint8_t>(hash & 0x7f);
+        m_slots[slot] = entry;
+        ++m_size;
+        return {slot, true};
+    }
+
+    template <bool IS_CONST>
+    class Iterator
+    {
+        friend class FlatNodeMap;
+        friend class Iterator<true>;
+        using Map = std::conditional_t<IS_CONST, const FlatNodeMap, FlatNodeMap>;
+
+        Map* m_map{nullptr};
+        size_t m_slot{0};
+
+        Iterator(Map* map, size_t slot) : m_map{map}, m_slot{slot} {}
+
+        void SkipUnused()
+        {
+            while (m_slot < m_map->m_capacity && !IsFull(m_map->m_ctrl[m_slot])) ++m_slot;
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = FlatNodeMap::value_type;
+        using difference_type = FlatNodeMap::difference_type;
+        using pointer = std::conditional_t<IS_CONST, const value_type*, value_type*>;
+        using reference = std::conditional_t<IS_CONST, const value_type&, value_type&>;
+
+        Iterator() = default;
+        // Allow conversion from iterator to const_iterator.
+        template <bool OTHER_IS_CONST>
+            requires(IS_CONST && !OTHER_IS_CONST)
+        Iterator(const Iterator<OTHER_IS_CONST>& other) : m_map{other.m_map}, m_slot{other.m_slot} {}
+
+        reference operator*() const { return *m_map->m_slots[m_slot]; }
+        pointer operator->() const { return m_map->m_slots[m_slot]; }
+
+        Iterator& operator++()
+        {
+            ++m_slot;
+            SkipUnused();
+            return *this;
+        }
+        Iterator operator++(int)
+        {
+            Iterator copy{*this};
+            ++*this;
+            return copy;
+        }
+
+        friend bool operator==(const Iterator& a, const Iterator& b) { return a.m_slot == b.m_slot; }
+    };
+
+public:
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    explicit FlatNodeMap(size_t bucket_count, const hasher& hash = hasher{}, const key_equal& equal = key_equal{},
+                         const allocator_type& alloc = allocator_type{})
+        : m_hash{hash}, m_key_equal{equal}, m_alloc{alloc}
+    {
+        reserve(bucket_count);
+    }
+
+    /** Take over the entries of other, which is left empty. */
+    FlatNodeMap(FlatNodeMap&& other) noexcept
+        : m_hash{std::move(other.m_hash)},
+          m_key_equal{std::move(other.m_key_equal)},
+          m_alloc{other.m_alloc},
+          m_ctrl{std::move(other.m_ctrl)},
+          m_slots{std::move(other.m_slots)},
+          m_capacity{std::exchange(other.m_capacity, 0)},
+          m_size{std::exchange(other.m_size, 0)},
+          m_growth_left{std::exchange(other.m_growth_left, 0)}
+    {
+    }
+
+    FlatNodeMap(const FlatNodeMap&) = delete;
+    FlatNodeMap& operator=(const FlatNodeMap&) = delete;
+    FlatNodeMap& operator=(FlatNodeMap&&) = delete;
+
+    ~FlatNodeMap() { clear(); }
+
+    iterator begin()
+    {
+        iterator it{this, 0};
+        it.SkipUnused();
+        return it;
+    }
+    const_iterator begin() const
+    {
+        const_iterator it{this, 0};
+        it.SkipUnused();
+        return it;
+    }
+    iterator end() { return {this, m_capacity}; }
+    const_iterator end() const { return {this, m_capacity}; }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    //! Number of slots in the index.
+    size_t bucket_count() const { return m_capacity; }
+    allocator_type get_allocator() const { return m_alloc; }
+
+    iterator find(const Key& key) { return {this, FindSlot(key, m_hash(key))}; }
+    const_iterator find(const Key& key) const { return {this, FindSlot(key, m_hash(key))}; }
+    size_t count(const Key& key) const { return find(key) == end() ? 0 : 1; }
+
+    T& at(const Key& key)
+    {
+        const auto it{find(key)};
+        if (it == end()) throw std::out_of_range("FlatNodeMap::at");
+        return it->second;
+    }
+    const T& at(const Key& key) const
+    {
+        const auto it{find(key)};
+        if (it == end()) throw std::out_of_range("FlatNodeMap::at");
+        return it->second;
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args)
+    {
+        const auto [slot, inserted]{TryEmplace(key, std::forward<Args>(args)...)};
+        return {iterator{this, slot}, inserted};
+    }
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(Key&& key, Args&&... args)
+    {
+        const auto [slot, inserted]{TryEmplace(std::move(key), std::forward<Args>(args)...)};
+        return {iterator{this, slot}, inserted};
+    }
+    template <typename M>
+    std::pair<iterator, bool> emplace(const Key& key, M&& mapped) { return try_emplace(key, std::forward<M>(mapped)); }
+
+    T& operator[](const Key& key) { return try_emplace(key).first->second; }
+
+    /** Erase the entry at it, returning an iterator to the next entry. */
+    iterator erase(iterator it)
+    {
+        EraseSlot(it.m_slot);
+        ++it;
+        return it;
+    }
+    size_t erase(const Key& key)
+    {
+        const size_t slot{FindSlot(key, m_hash(key))};
+        if (slot == m_capacity) return 0;
+        EraseSlot(slot);
+        return 1;
+    }
+
+    /** Erase all entries, keeping the capacity of the index. */
+    void clear() noexcept
+    {
+        for (size_t i{0}; i < m_capacity; ++i) {
+            if (IsFull(m_ctrl[i])) DestroyEntry(m_slots[i]);
+        }
+        if (m_capacity > 0) std::memset(m_ctrl.get(), CTRL_EMPTY, m_capacity);
+        m_size = 0;
+        m_growth_left = m_capacity - m_capacity / 8;
+    }
+
+    /** Make room for num_entries entries without growing the index. */
+    void reserve(size_t num_entries)
+    {
+        if (num_entries == 0) return;
+        const size_t capacity{CapacityFor(num_entries)};
+        if (capacity > m_capacity) Resize(capacity);
+    }
+};
+
+#endif // GRIFFION_FLATNODEMAP_H
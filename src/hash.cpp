@@ -9,8 +9,10 @@
 #include <crypto/hmac_sha512.h>
 #include <crypto/ethash/include/ethash/progpow.hpp>
 
+#include <algorithm>
 #include <bit>
 #include <string>
+#include <vector>
 
 unsigned int MurmurHash3(unsigned int nHashSeed, Span<const unsigned char> vDataToHash)
 {
@@ -86,28 +88,62 @@ uint256 SHA256Uint256(const uint256& input)
 
 uint256 ETHash(const CBlockHeader& blockHeader)
 {
-    uint256 nHeaderHash = blockHeader.GetHeaderHash();
-    const auto header_hash = to_hash256(nHeaderHash.GetHex());
-    const auto result = progpow::hash_no_verify(blockHeader.nHeight, header_hash, to_hash256(blockHeader.hashMix.GetHex()), blockHeader.nNonce);
+    const auto header_hash = ToEthashHash(blockHeader.GetHeaderHash());
+    const auto result = progpow::hash_no_verify(blockHeader.nHeight, header_hash, ToEthashHash(blockHeader.hashMix), blockHeader.nNonce);
 
-    return uint256S(to_hex(result));
+    return FromEthashHash(result);
+}
+
+std::vector<uint256> ETHash(const std::vector<CBlockHeader>& headers)
+{
+    std::vector<uint256> hashes;
+    hashes.reserve(headers.size());
+
+    for (size_t first = 0; first < headers.size(); first += 8) {
+        const size_t count{std::min<size_t>(8, headers.size() - first)};
+
+        // Unused lanes are left zeroed and their results discarded.
+        ethash::hash256 header_hashes[8]{};
+        ethash::hash256 hash_mixes[8]{};
+        uint64_t nonces[8]{};
+        for (size_t i = 0; i < count; ++i) {
+            const CBlockHeader& header = headers[first + i];
+            header_hashes[i] = ToEthashHash(header.GetHeaderHash());
+            hash_mixes[i] = ToEthashHash(header.hashMix);
+            nonces[i] = header.nNonce;
+        }
+
+        ethash::hash256 final_hashes[8];
+        progpow::hash_no_verify_8way(header_hashes, hash_mixes, nonces, final_hashes);
+        for (size_t i = 0; i < count; ++i) {
+            hashes.push_back(FromEthashHash(final_hashes[i]));
+        }
+    }
+    return hashes;
 }
 
 uint256 ETHash(const CBlockHeader& blockHeader, uint256& hashMix)
 {
-    static ethash::epoch_context_ptr context{nullptr, nullptr};
+    // The global context cache is shared by all threads validating headers
+    // and keeps the contexts of recently used epochs around.
+    const auto& context = ethash::get_global_epoch_context(ethash::get_epoch_number(blockHeader.nHeight));
 
-    const auto epoch_number = ethash::get_epoch_number(blockHeader.nHeight);
+    const auto header_hash = ToEthashHash(blockHeader.GetHeaderHash());
+    const auto result = progpow::hash(context, blockHeader.nHeight, header_hash, blockHeader.nNonce);
 
-    if (!context || context->epoch_number != epoch_number)
-        context = ethash::create_epoch_context(epoch_number);
+    hashMix = FromEthashHash(result.hashMix);
+    return FromEthashHash(result.final_hash);
+}
 
-    uint256 nHeaderHash = blockHeader.GetHeaderHash();
-    const auto header_hash = to_hash256(nHeaderHash.GetHex());
-    const auto result = progpow::hash(*context, blockHeader.nHeight, header_hash, blockHeader.nNonce);
+bool ETHashVerify(const CBlockHeader& blockHeader, const uint256& boundary)
+{
+    // Always verify against the light cache, never the full dataset used for
+    // mining: that may be mapped from a file that is only spot-checked, and a
+    // corrupt file must not change which headers are valid.
+    const auto& context = ethash::get_global_epoch_context(ethash::get_epoch_number(blockHeader.nHeight));
 
-    hashMix = uint256S(to_hex(result.hashMix));
-    return uint256S(to_hex(result.final_hash));
+    return progpow::verify(context, blockHeader.nHeight, ToEthashHash(blockHeader.GetHeaderHash()),
+                           ToEthashHash(blockHeader.hashMix), blockHeader.nNonce, ToEthashHash(boundary));
 }
 
 HashWriter TaggedHash(const std::string& tag)
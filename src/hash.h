@@ -18,6 +18,8 @@
 #include <span.h>
 #include <uint256.h>
 
+#include <algorithm>
+#include <iterator>
 #include <string>
 #include <vector>
 
@@ -209,12 +211,45 @@ public:
 /** Single-SHA256 a 32-byte input (represented as uint256). */
 [[nodiscard]] uint256 SHA256Uint256(const uint256& input);
 
+/** Convert a uint256 to an ethash::hash256.
+ *
+ * uint256 stores its bytes little-endian while ethash::hash256 is the
+ * big-endian (display order) representation, so the bytes are reversed.
+ * Equivalent to to_hash256(in.GetHex()) without the string round-trip.
+ */
+inline ethash::hash256 ToEthashHash(const uint256& in)
+{
+    ethash::hash256 out;
+    std::reverse_copy(in.begin(), in.end(), out.bytes);
+    return out;
+}
+
+/** Convert an ethash::hash256 back to a uint256. Inverse of ToEthashHash(). */
+inline uint256 FromEthashHash(const ethash::hash256& in)
+{
+    uint256 out;
+    std::reverse_copy(std::begin(in.bytes), std::end(in.bytes), out.begin());
+    return out;
+}
+
 /** ETHash hashing function, returns only hash */
 uint256 ETHash(const CBlockHeader& blockHeader);
 
+/** ETHash hashing function over a batch of headers. Equivalent to calling
+ * ETHash(header) for each one, but runs the keccak permutations of eight
+ * headers at a time. */
+std::vector<uint256> ETHash(const std::vector<CBlockHeader>& headers);
+
 /** ETHash hashing function, returns the hash and hashMix */
 uint256 ETHash(const CBlockHeader& blockHeader, uint256& hashMix);
 
+/** ETHash verification function. Checks the final hash computed from the
+ * claimed hashMix against the boundary first, which only costs two
+ * keccak-f800 permutations, and computes the expensive mix only if that
+ * passes. Returns whether the final hash is below the boundary and the
+ * claimed hashMix is correct. */
+bool ETHashVerify(const CBlockHeader& blockHeader, const uint256& boundary);
+
 unsigned int MurmurHash3(unsigned int nHashSeed, Span<const unsigned char> vDataToHash);
 
 void BIP32Hash(const ChainCode &chainCode, unsigned int nChild, unsigned char header, const unsigned char data[32], unsigned char output[64]);
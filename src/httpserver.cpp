@@ -640,13 +640,37 @@ void HTTPRequest::WriteHeader(const std::string& hdr, const std::string& value)
 void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
 {
     assert(!replySent && req);
+    struct evbuffer* evb = evhttp_request_get_output_buffer(req);
+    assert(evb);
+    evbuffer_add(evb, strReply.data(), strReply.size());
+    SendReply(nStatus);
+}
+
+void HTTPRequest::WriteReply(int nStatus, std::shared_ptr<const std::vector<unsigned char>> reply)
+{
+    assert(!replySent && req);
+    struct evbuffer* evb = evhttp_request_get_output_buffer(req);
+    assert(evb);
+    if (reply && !reply->empty()) {
+        // libevent sends straight from the vector and drops the reference once done with it
+        auto ref{std::make_unique<std::shared_ptr<const std::vector<unsigned char>>>(std::move(reply))};
+        const auto& data{**ref};
+        const auto cleanup{[](const void*, size_t, void* arg) { delete static_cast<std::shared_ptr<const std::vector<unsigned char>>*>(arg); }};
+        if (evbuffer_add_reference(evb, data.data(), data.size(), cleanup, ref.get()) == 0) {
+            ref.release();
+        } else {
+            evbuffer_add(evb, data.data(), data.size());
+        }
+    }
+    SendReply(nStatus);
+}
+
+void HTTPRequest::SendReply(int nStatus)
+{
     if (m_interrupt) {
         WriteHeader("Connection", "close");
     }
     // Send event to main http thread to send reply message
-    struct evbuffer* evb = evhttp_request_get_output_buffer(req);
-    assert(evb);
-    evbuffer_add(evb, strReply.data(), strReply.size());
     auto req_copy = req;
     HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, nStatus]{
         evhttp_send_reply(req_copy, nStatus, nullptr, nullptr);
@@ -7,8 +7,10 @@
 #define GRIFFION_HTTPSERVER_H
 
 #include <functional>
+#include <memory>
 #include <optional>
 #include <string>
+#include <vector>
 
 namespace util {
 class SignalInterrupt;
@@ -130,6 +132,16 @@ public:
      * main thread, do not call any other HTTPRequest methods after calling this.
      */
     void WriteReply(int nStatus, const std::string& strReply = "");
+
+    /**
+     * Write HTTP reply, sharing the body instead of copying it. Use this for large
+     * replies, such as raw blocks.
+     */
+    void WriteReply(int nStatus, std::shared_ptr<const std::vector<unsigned char>> reply);
+
+private:
+    /** Give the request, with the reply written to it, back to the main thread for sending. */
+    void SendReply(int nStatus);
 };
 
 /** Get the query parameter value from request uri for a specified key, or std::nullopt if the key
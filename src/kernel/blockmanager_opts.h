@@ -9,12 +9,25 @@
 #include <kernel/notifications_interface.h>
 #include <util/fs.h>
 
+#include <cstddef>
 #include <cstdint>
 
 class CChainParams;
 
 namespace kernel {
 
+/** Default for -compactundo */
+static constexpr bool DEFAULT_COMPACT_UNDO{false};
+/** Default for -blockcachesize, in MiB */
+static constexpr size_t DEFAULT_BLOCK_CACHE_SIZE{64};
+
+/** How much of the proof of work of the stored block index is checked on load. */
+enum class CheckPowOnLoad {
+    NONE,   //!< Trust the stored block index
+    CACHED, //!< Check the block hashes against their targets without recomputing any mix, as before -checkpowonload
+    FULL,   //!< Recompute the ProgPoW mix of every block index entry
+};
+
 /**
  * An options struct for `BlockManager`, more ergonomically referred to as
  * `BlockManager::Options` due to the using-declaration in `BlockManager`.
@@ -23,6 +36,9 @@ struct BlockManagerOpts {
     const CChainParams& chainparams;
     uint64_t prune_target{0};
     bool fast_prune{false};
+    CheckPowOnLoad check_pow_on_load{CheckPowOnLoad::CACHED};
+    bool compact_undo{DEFAULT_COMPACT_UNDO};
+    size_t block_cache_size{DEFAULT_BLOCK_CACHE_SIZE << 20};
     const fs::path blocks_dir;
     Notifications& notifications;
 };
@@ -22,6 +22,10 @@ class CChainParams;
 
 static constexpr bool DEFAULT_CHECKPOINTS_ENABLED{true};
 static constexpr auto DEFAULT_MAX_TIP_AGE{24h};
+static constexpr int DEFAULT_EPOCH_PREFETCH_BLOCKS{100};
+static constexpr bool DEFAULT_BACKGROUND_FLUSH{false};
+static constexpr bool DEFAULT_PARTIAL_FLUSH{false};
+static constexpr bool DEFAULT_PIPELINED_CONNECT{false};
 
 namespace kernel {
 
@@ -47,6 +51,14 @@ struct ChainstateManagerOpts {
     Notifications& notifications;
     //! Number of script check worker threads. Zero means no parallel verification.
     int worker_threads_num{0};
+    //! How many blocks before an epoch boundary to build the next epoch's light cache. Zero disables it.
+    int epoch_prefetch_blocks{DEFAULT_EPOCH_PREFETCH_BLOCKS};
+    //! Whether periodic flushes write the coins cache from a background thread.
+    bool background_flush{DEFAULT_BACKGROUND_FLUSH};
+    //! Whether a large coins cache is kept in size by writing out its oldest coins instead of flushing it.
+    bool partial_flush{DEFAULT_PARTIAL_FLUSH};
+    //! Whether the script checks of consecutive blocks are verified together, while the next blocks are connected.
+    bool pipelined_connect{DEFAULT_PIPELINED_CONNECT};
 };
 
 } // namespace kernel
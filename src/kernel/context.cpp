@@ -5,6 +5,7 @@
 
 #include <kernel/context.h>
 
+#include <crypto/ethash/include/ethash/keccak.h>
 #include <crypto/sha256.h>
 #include <key.h>
 #include <logging.h>
@@ -19,6 +20,8 @@ Context::Context()
 {
     std::string sha256_algo = SHA256AutoDetect();
     LogPrintf("Using the '%s' SHA256 implementation\n", sha256_algo);
+    std::string keccakf800_algo = ethash_keccakf800_autodetect();
+    LogPrintf("Using the '%s' Keccak-f[800] implementation\n", keccakf800_algo);
     RandomInit();
     ECC_Start();
 }
@@ -0,0 +1,117 @@
+// Copyright (c) 2024 The Griffion Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <kernel/validation_cache_persist.h>
+
+#include <clientversion.h>
+#include <hash.h>
+#include <kernel/cs_main.h>
+#include <logging.h>
+#include <script/sigcache.h>
+#include <streams.h>
+#include <sync.h>
+#include <uint256.h>
+#include <util/fs.h>
+#include <util/fs_helpers.h>
+#include <util/time.h>
+#include <validation.h>
+
+#include <cstdint>
+#include <exception>
+#include <stdexcept>
+
+using fsbridge::FopenFn;
+
+namespace kernel {
+
+static const uint64_t VALIDATION_CACHE_DUMP_VERSION{2};
+
+bool DumpValidationCaches(const fs::path& dump_path, FopenFn mockable_fopen_function, bool skip_file_commit)
+{
+    auto start = SteadyClock::now();
+
+    const SaltedCacheEntries signature_cache{GetSignatureCacheEntries()};
+    const SaltedCacheEntries script_execution_cache{WITH_LOCK(cs_main, return GetScriptExecutionCacheEntries())};
+
+    auto mid = SteadyClock::now();
+
+    AutoFile file{mockable_fopen_function(dump_path + ".new", "wb")};
+    if (file.IsNull()) {
+        return false;
+    }
+
+    try {
+        // The checksum guards against loading a truncated or damaged file,
+        // whose entries would be taken as valid signatures and scripts.
+        // Script execution cache entries only hold for the script rules and
+        // flags of the binary that wrote them, so the file records its version.
+        HashedSourceWriter writer{file};
+        writer << VALIDATION_CACHE_DUMP_VERSION << int32_t{CLIENT_VERSION} << signature_cache << script_execution_cache;
+        file << writer.GetHash();
+
+        if (!skip_file_commit && !FileCommit(file.Get()))
+            throw std::runtime_error("FileCommit failed");
+        file.fclose();
+        if (!RenameOver(dump_path + ".new", dump_path)) {
+            throw std::runtime_error("Rename failed");
+        }
+        auto last = SteadyClock::now();
+
+        LogPrintf("Dumped %u signature and %u script execution cache entries: %.3fs to copy, %.3fs to dump\n",
+                  signature_cache.entries.size(), script_execution_cache.entries.size(),
+                  Ticks<SecondsDouble>(mid - start),
+                  Ticks<SecondsDouble>(last - mid));
+    } catch (const std::exception& e) {
+        LogPrintf("Failed to dump validation caches: %s. Continuing anyway.\n", e.what());
+        return false;
+    }
+    return true;
+}
+
+bool LoadValidationCaches(const fs::path& load_path, FopenFn mockable_fopen_function)
+{
+    if (load_path.empty()) return false;
+
+    AutoFile file{mockable_fopen_function(load_path, "rb")};
+    if (file.IsNull()) {
+        LogPrintf("Failed to open validation cache file from disk. Continuing anyway.\n");
+        return false;
+    }
+
+    SaltedCacheEntries signature_cache;
+    SaltedCacheEntries script_execution_cache;
+    try {
+        HashVerifier verifier{file};
+        uint64_t version;
+        verifier >> version;
+        if (version != VALIDATION_CACHE_DUMP_VERSION) {
+            return false;
+        }
+        int32_t client_version;
+        verifier >> client_version;
+        if (client_version != CLIENT_VERSION) {
+            LogPrintf("Validation cache file was written by client version %d, not loading it.\n", client_version);
+            return false;
+        }
+        verifier >> signature_cache >> script_execution_cache;
+        uint256 checksum;
+        file >> checksum;
+        if (checksum != verifier.GetHash()) {
+            LogPrintf("Validation cache file on disk is corrupt. Continuing anyway.\n");
+            return false;
+        }
+    } catch (const std::exception& e) {
+        LogPrintf("Failed to deserialize validation caches on disk: %s. Continuing anyway.\n", e.what());
+        return false;
+    }
+
+    LoadSignatureCacheEntries(signature_cache);
+    WITH_LOCK(cs_main, LoadScriptExecutionCacheEntries(script_execution_cache));
+
+    LogPrintf("Imported validation caches from disk: %u signature and %u script execution cache entries\n",
+              signature_cache.entries.size(), script_execution_cache.entries.size());
+    return true;
+}
+
+} // namespace kernel
@@ -0,0 +1,28 @@
+// Copyright (c) 2024 The Griffion Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef GRIFFION_KERNEL_VALIDATION_CACHE_PERSIST_H
+#define GRIFFION_KERNEL_VALIDATION_CACHE_PERSIST_H
+
+#include <util/fs.h>
+
+namespace kernel {
+
+/** Dump the signature and script-execution caches to a file. */
+bool DumpValidationCaches(const fs::path& dump_path,
+                          fsbridge::FopenFn mockable_fopen_function = fsbridge::fopen,
+                          bool skip_file_commit = false);
+
+/**
+ * Add the entries of a file written by DumpValidationCaches() to the
+ * signature and script-execution caches, taking over their salts. Should be
+ * called before the caches are used, as entries already in them can no
+ * longer be found afterwards.
+ */
+bool LoadValidationCaches(const fs::path& load_path,
+                          fsbridge::FopenFn mockable_fopen_function = fsbridge::fopen);
+
+} // namespace kernel
+
+#endif // GRIFFION_KERNEL_VALIDATION_CACHE_PERSIST_H
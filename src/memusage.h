@@ -6,6 +6,7 @@
 #ifndef GRIFFION_MEMUSAGE_H
 #define GRIFFION_MEMUSAGE_H
 
+#include <flatnodemap.h>
 #include <indirectmap.h>
 #include <prevector.h>
 #include <support/allocators/pool.h>
@@ -203,6 +204,25 @@ static inline size_t DynamicUsage(const std::unordered_map<Key,
     return usage_resource + usage_chunks + MallocUsage(sizeof(void*) * m.bucket_count());
 }
 
+template <class Key, class T, class Hash, class Pred, std::size_t MAX_BLOCK_SIZE_BYTES, std::size_t ALIGN_BYTES>
+static inline size_t DynamicUsage(const FlatNodeMap<Key,
+                                                    T,
+                                                    Hash,
+                                                    Pred,
+                                                    PoolAllocator<std::pair<const Key, T>,
+                                                                  MAX_BLOCK_SIZE_BYTES,
+                                                                  ALIGN_BYTES>>& m)
+{
+    auto* pool_resource = m.get_allocator().resource();
+
+    size_t estimated_list_node_size = MallocUsage(sizeof(void*) * 3);
+    size_t usage_resource = estimated_list_node_size * pool_resource->NumAllocatedChunks();
+    size_t usage_chunks = MallocUsage(pool_resource->ChunkSizeBytes()) * pool_resource->NumAllocatedChunks();
+    // The index has a control byte and an entry pointer per slot.
+    size_t usage_index = MallocUsage(m.bucket_count()) + MallocUsage(sizeof(void*) * m.bucket_count());
+    return usage_resource + usage_chunks + usage_index;
+}
+
 } // namespace memusage
 
 #endif // GRIFFION_MEMUSAGE_H
@@ -105,6 +105,9 @@ enum BindFlags {
 // The sleep time needs to be small to avoid new sockets stalling
 static const uint64_t SELECT_TIMEOUT_MILLISECONDS = 50;
 
+/** How often to check all nodes for inactivity when only the ready ones are serviced. */
+static constexpr auto INACTIVITY_CHECK_INTERVAL{1s};
+
 const std::string NET_MESSAGE_TYPE_OTHER = "*other*";
 
 static const uint64_t RANDOMIZER_ID_NETGROUP = 0x6c0edd8036ef4036ULL; // SHA256("netgroup")[0:8]
@@ -124,7 +127,7 @@ size_t CSerializedNetMsg::GetMemoryUsage() const noexcept
     // Don't count the dynamic memory used for the m_type string, by assuming it fits in the
     // "small string" optimization area (which stores data inside the object itself, up to some
     // size; 15 bytes in modern libstdc++).
-    return sizeof(*this) + memusage::DynamicUsage(data);
+    return sizeof(*this) + memusage::DynamicUsage(data) + (m_shared_data ? memusage::DynamicUsage(*m_shared_data) : 0);
 }
 
 void CConnman::AddAddrFetch(const std::string& strDest)
@@ -539,6 +542,7 @@ CNode* CConnman::ConnectNode(CAddress addrConnect, const char *pszDest, bool fCo
                                  .i2p_sam_session = std::move(i2p_transient_session),
                                  .recv_flood_size = nReceiveFloodSize,
                                  .use_v2transport = use_v2transport,
+                                 .recv_buffer_pool = m_recv_buffer_pool,
                              });
     pnode->AddRef();
 
@@ -685,8 +689,48 @@ bool CNode::ReceiveMsgBytes(Span<const uint8_t> msg_bytes, bool& complete)
     return true;
 }
 
-V1Transport::V1Transport(const NodeId node_id) noexcept
-    : m_magic_bytes{Params().MessageStart()}, m_node_id{node_id}
+static_assert(RecvBufferPool::MIN_CLASS_SIZE << (RecvBufferPool::NUM_CLASSES - 1) >= 1 + CMessageHeader::COMMAND_SIZE + MAX_PROTOCOL_MESSAGE_LENGTH,
+              "the largest size class must fit the largest message, including its v2 message type");
+
+DataStream RecvBufferPool::Get(size_t size)
+{
+    DataStream buffer;
+    size_t cls{0};
+    while (cls < NUM_CLASSES && ClassSize(cls) < size) ++cls;
+    if (size < MIN_CLASS_SIZE || cls == NUM_CLASSES) {
+        buffer.reserve(size);
+        return buffer;
+    }
+    {
+        LOCK(m_mutex);
+        auto& free{m_free[cls]};
+        if (!free.empty()) {
+            buffer = std::move(free.back());
+            free.pop_back();
+            m_free_bytes[cls] -= buffer.capacity();
+            return buffer;
+        }
+    }
+    buffer.reserve(ClassSize(cls));
+    return buffer;
+}
+
+void RecvBufferPool::Release(DataStream&& buffer)
+{
+    buffer.clear();
+    const size_t capacity{buffer.capacity()};
+    if (capacity < MIN_CLASS_SIZE) return;
+    // The largest class the buffer is big enough for
+    size_t cls{NUM_CLASSES - 1};
+    while (ClassSize(cls) > capacity) --cls;
+    LOCK(m_mutex);
+    if (m_free_bytes[cls] + capacity > MAX_CLASS_BYTES && !m_free[cls].empty()) return;
+    m_free_bytes[cls] += capacity;
+    m_free[cls].push_back(std::move(buffer));
+}
+
+V1Transport::V1Transport(const NodeId node_id, std::shared_ptr<RecvBufferPool> recv_pool) noexcept
+    : m_magic_bytes{Params().MessageStart()}, m_node_id{node_id}, m_recv_pool{std::move(recv_pool)}
 {
     LOCK(m_recv_mutex);
     Reset();
@@ -746,7 +790,17 @@ int V1Transport::readData(Span<const uint8_t> msg_bytes)
 
     if (vRecv.size() < nDataPos + nCopy) {
         // Allocate up to 256 KiB ahead, but never more than the total message size.
-        vRecv.resize(std::min(hdr.nMessageSize, nDataPos + nCopy + 256 * 1024));
+        const unsigned int new_size{std::min(hdr.nMessageSize, nDataPos + nCopy + 256 * 1024)};
+        if (m_recv_pool && new_size > vRecv.capacity()) {
+            // Move what was received so far to a pooled buffer large enough
+            DataStream buffer{m_recv_pool->Get(new_size)};
+            buffer.resize(new_size);
+            std::copy_n(vRecv.begin(), nDataPos, buffer.begin());
+            m_recv_pool->Release(std::move(vRecv));
+            vRecv = std::move(buffer);
+        } else {
+            vRecv.resize(new_size);
+        }
     }
 
     hasher.Write(msg_bytes.first(nCopy));
@@ -809,13 +863,13 @@ bool V1Transport::SetMessageToSend(CSerializedNetMsg& msg) noexcept
     AssertLockNotHeld(m_send_mutex);
     // Determine whether a new message can be set.
     LOCK(m_send_mutex);
-    if (m_sending_header || m_bytes_sent < m_message_to_send.data.size()) return false;
+    if (m_sending_header || m_bytes_sent < m_message_to_send.Data().size()) return false;
 
     // create dbl-sha256 checksum
-    uint256 hash = Hash(msg.data);
+    uint256 hash = Hash(msg.Data());
 
     // create header
-    CMessageHeader hdr(m_magic_bytes, msg.m_type.c_str(), msg.data.size());
+    CMessageHeader hdr(m_magic_bytes, msg.m_type.c_str(), msg.Data().size());
     memcpy(hdr.pchChecksum, hash.begin(), CMessageHeader::CHECKSUM_SIZE);
 
     // serialize header
@@ -837,11 +891,11 @@ Transport::BytesToSend V1Transport::GetBytesToSend(bool have_next_message) const
         return {Span{m_header_to_send}.subspan(m_bytes_sent),
                 // We have more to send after the header if the message has payload, or if there
                 // is a next message after that.
-                have_next_message || !m_message_to_send.data.empty(),
+                have_next_message || !m_message_to_send.Data().empty(),
                 m_message_to_send.m_type
                };
     } else {
-        return {Span{m_message_to_send.data}.subspan(m_bytes_sent),
+        return {m_message_to_send.Data().subspan(m_bytes_sent),
                 // We only have more to send after this message's payload if there is another
                 // message.
                 have_next_message,
@@ -859,9 +913,10 @@ void V1Transport::MarkBytesSent(size_t bytes_sent) noexcept
         // We're done sending a message's header. Switch to sending its data bytes.
         m_sending_header = false;
         m_bytes_sent = 0;
-    } else if (!m_sending_header && m_bytes_sent == m_message_to_send.data.size()) {
+    } else if (!m_sending_header && m_bytes_sent == m_message_to_send.Data().size()) {
         // We're done sending a message's data. Wipe the data vector to reduce memory consumption.
         ClearShrink(m_message_to_send.data);
+        m_message_to_send.m_shared_data.reset();
         m_bytes_sent = 0;
     }
 }
@@ -963,9 +1018,9 @@ void V2Transport::StartSendingHandshake() noexcept
     // We cannot wipe m_send_garbage as it will still be used as AAD later in the handshake.
 }
 
-V2Transport::V2Transport(NodeId nodeid, bool initiating, const CKey& key, Span<const std::byte> ent32, std::vector<uint8_t> garbage) noexcept
+V2Transport::V2Transport(NodeId nodeid, bool initiating, const CKey& key, Span<const std::byte> ent32, std::vector<uint8_t> garbage, std::shared_ptr<RecvBufferPool> recv_pool) noexcept
     : m_cipher{key, ent32}, m_initiating{initiating}, m_nodeid{nodeid},
-      m_v1_fallback{nodeid},
+      m_v1_fallback{nodeid, recv_pool}, m_recv_pool{std::move(recv_pool)},
       m_recv_state{initiating ? RecvState::KEY : RecvState::KEY_MAYBE_V1},
       m_send_garbage{std::move(garbage)},
       m_send_state{initiating ? SendState::AWAITING_KEY : SendState::MAYBE_V1}
@@ -978,9 +1033,9 @@ V2Transport::V2Transport(NodeId nodeid, bool initiating, const CKey& key, Span<c
     }
 }
 
-V2Transport::V2Transport(NodeId nodeid, bool initiating) noexcept
+V2Transport::V2Transport(NodeId nodeid, bool initiating, std::shared_ptr<RecvBufferPool> recv_pool) noexcept
     : V2Transport{nodeid, initiating, GenerateRandomKey(),
-                  MakeByteSpan(GetRandHash()), GenerateRandomGarbage()} {}
+                  MakeByteSpan(GetRandHash()), GenerateRandomGarbage(), std::move(recv_pool)} {}
 
 void V2Transport::SetReceiveState(RecvState recv_state) noexcept
 {
@@ -1191,6 +1246,10 @@ bool V2Transport::ProcessReceivedPacketBytes() noexcept
         // Ciphertext received, decrypt it into m_recv_decode_buffer.
         // Note that it is impossible to reach this branch without hitting the branch above first,
         // as GetMaxBytesToProcess only allows up to LENGTH_LEN into the buffer before that point.
+        if (m_recv_pool && m_recv_decode_buffer.capacity() < m_recv_len) {
+            m_recv_pool->Release(std::move(m_recv_decode_buffer));
+            m_recv_decode_buffer = m_recv_pool->Get(m_recv_len);
+        }
         m_recv_decode_buffer.resize(m_recv_len);
         bool ignore{false};
         bool ret = m_cipher.Decrypt(
@@ -1228,7 +1287,7 @@ bool V2Transport::ProcessReceivedPacketBytes() noexcept
         // Wipe the receive buffer where the next packet will be received into.
         ClearShrink(m_recv_buffer);
         // In all but APP_READY state, we can wipe the decoded contents.
-        if (m_recv_state != RecvState::APP_READY) ClearShrink(m_recv_decode_buffer);
+        if (m_recv_state != RecvState::APP_READY) ReleaseRecvDecodeBuffer();
     } else {
         // We either have less than 3 bytes, so we don't know the packet's length yet, or more
         // than 3 bytes but less than the packet's full ciphertext. Wait until those arrive.
@@ -1422,28 +1481,37 @@ CNetMessage V2Transport::GetReceivedMessage(std::chrono::microseconds time, bool
     if (m_recv_state == RecvState::V1) return m_v1_fallback.GetReceivedMessage(time, reject_message);
 
     Assume(m_recv_state == RecvState::APP_READY);
-    Span<const uint8_t> contents{m_recv_decode_buffer};
+    const size_t contents_size{m_recv_decode_buffer.size()};
+    Span<const uint8_t> contents{MakeUCharSpan(m_recv_decode_buffer)};
     auto msg_type = GetMessageType(contents);
     CNetMessage msg{DataStream{}};
     // Note that BIP324Cipher::EXPANSION also includes the length descriptor size.
-    msg.m_raw_message_size = m_recv_decode_buffer.size() + BIP324Cipher::EXPANSION;
+    msg.m_raw_message_size = contents_size + BIP324Cipher::EXPANSION;
     if (msg_type) {
         reject_message = false;
         msg.m_type = std::move(*msg_type);
         msg.m_time = time;
         msg.m_message_size = contents.size();
-        msg.m_recv.resize(contents.size());
-        std::copy(contents.begin(), contents.end(), UCharCast(msg.m_recv.data()));
+        // The decrypted contents become the payload, after skipping the message type.
+        msg.m_recv = std::move(m_recv_decode_buffer);
+        msg.m_recv.ignore(contents_size - contents.size());
     } else {
-        LogPrint(BCLog::NET, "V2 transport error: invalid message type (%u bytes contents), peer=%d\n", m_recv_decode_buffer.size(), m_nodeid);
+        LogPrint(BCLog::NET, "V2 transport error: invalid message type (%u bytes contents), peer=%d\n", contents_size, m_nodeid);
         reject_message = true;
     }
-    ClearShrink(m_recv_decode_buffer);
+    ReleaseRecvDecodeBuffer();
     SetReceiveState(RecvState::APP);
 
     return msg;
 }
 
+void V2Transport::ReleaseRecvDecodeBuffer() noexcept
+{
+    AssertLockHeld(m_recv_mutex);
+    if (m_recv_pool) m_recv_pool->Release(std::move(m_recv_decode_buffer));
+    m_recv_decode_buffer = DataStream{};
+}
+
 bool V2Transport::SetMessageToSend(CSerializedNetMsg& msg) noexcept
 {
     AssertLockNotHeld(m_send_mutex);
@@ -1455,17 +1523,18 @@ bool V2Transport::SetMessageToSend(CSerializedNetMsg& msg) noexcept
     if (!(m_send_state == SendState::READY && m_send_buffer.empty())) return false;
     // Construct contents (encoding message type + payload).
     std::vector<uint8_t> contents;
+    const auto data{msg.Data()};
     auto short_message_id = V2_MESSAGE_MAP(msg.m_type);
     if (short_message_id) {
-        contents.resize(1 + msg.data.size());
+        contents.resize(1 + data.size());
         contents[0] = *short_message_id;
-        std::copy(msg.data.begin(), msg.data.end(), contents.begin() + 1);
+        std::copy(data.begin(), data.end(), contents.begin() + 1);
     } else {
         // Initialize with zeroes, and then write the message type string starting at offset 1.
         // This means contents[0] and the unused positions in contents[1..13] remain 0x00.
-        contents.resize(1 + CMessageHeader::COMMAND_SIZE + msg.data.size(), 0);
+        contents.resize(1 + CMessageHeader::COMMAND_SIZE + data.size(), 0);
         std::copy(msg.m_type.begin(), msg.m_type.end(), contents.data() + 1);
-        std::copy(msg.data.begin(), msg.data.end(), contents.begin() + 1 + CMessageHeader::COMMAND_SIZE);
+        std::copy(data.begin(), data.end(), contents.begin() + 1 + CMessageHeader::COMMAND_SIZE);
     }
     // Construct ciphertext in send buffer.
     m_send_buffer.resize(contents.size() + BIP324Cipher::EXPANSION);
@@ -1473,6 +1542,7 @@ bool V2Transport::SetMessageToSend(CSerializedNetMsg& msg) noexcept
     m_send_type = msg.m_type;
     // Release memory
     ClearShrink(msg.data);
+    msg.m_shared_data.reset();
     return true;
 }
 
@@ -1638,6 +1708,8 @@ std::pair<size_t, bool> CConnman::SocketSendData(CNode& node) const
         assert(node.m_send_memusage == 0);
     }
     node.vSendMsg.erase(node.vSendMsg.begin(), it);
+    // Nothing left to wait for sending, unless the transport still has to be given a message.
+    if (!data_left) node.m_sock_events_dirty = true;
     return {nSentSize, data_left};
 }
 
@@ -1813,6 +1885,7 @@ void CConnman::CreateNodeFromAcceptedSocket(std::unique_ptr<Sock>&& sock,
                                  .prefer_evict = discouraged,
                                  .recv_flood_size = nReceiveFloodSize,
                                  .use_v2transport = use_v2transport,
+                                 .recv_buffer_pool = m_recv_buffer_pool,
                              });
     pnode->AddRef();
     m_msgproc->InitializeNode(*pnode, nodeServices);
@@ -1873,6 +1946,7 @@ void CConnman::DisconnectNodes()
     // Use a temporary variable to accumulate desired reconnections, so we don't need
     // m_reconnections_mutex while holding m_nodes_mutex.
     decltype(m_reconnections) reconnections_to_add;
+    bool disconnected{false};
 
     {
         LOCK(m_nodes_mutex);
@@ -1895,6 +1969,7 @@ void CConnman::DisconnectNodes()
             {
                 // remove from m_nodes
                 m_nodes.erase(remove(m_nodes.begin(), m_nodes.end(), pnode), m_nodes.end());
+                disconnected = true;
 
                 // Add to reconnection list if appropriate. We don't reconnect right here, because
                 // the creation of a connection is a blocking operation (up to several seconds),
@@ -1924,6 +1999,18 @@ void CConnman::DisconnectNodes()
             }
         }
     }
+    if (disconnected && m_sock_events) {
+        // Stop waiting on the sockets of the nodes removed above. The registry keeps them
+        // open until then, so that their numbers cannot be reused by new connections.
+        for (auto it = m_registered_nodes.begin(); it != m_registered_nodes.end();) {
+            if (it->second->fDisconnect) {
+                (void)m_sock_events->Set(it->first, 0);
+                it = m_registered_nodes.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
     {
         // Delete disconnected nodes
         std::list<CNode*> nodes_disconnected_copy = m_nodes_disconnected;
@@ -2005,21 +2092,11 @@ Sock::EventsPerSock CConnman::GenerateWaitSockets(Span<CNode* const> nodes)
     }
 
     for (CNode* pnode : nodes) {
-        bool select_recv = !pnode->fPauseRecv;
-        bool select_send;
-        {
-            LOCK(pnode->cs_vSend);
-            // Sending is possible if either there are bytes to send right now, or if there will be
-            // once a potential message from vSendMsg is handed to the transport. GetBytesToSend
-            // determines both of these in a single call.
-            const auto& [to_send, more, _msg_type] = pnode->m_transport->GetBytesToSend(!pnode->vSendMsg.empty());
-            select_send = !to_send.empty() || more;
-        }
-        if (!select_recv && !select_send) continue;
+        const Sock::Event event{GetWaitEvents(*pnode)};
+        if (event == 0) continue;
 
         LOCK(pnode->m_sock_mutex);
         if (pnode->m_sock) {
-            Sock::Event event = (select_send ? Sock::SEND : 0) | (select_recv ? Sock::RECV : 0);
             events_per_sock.emplace(pnode->m_sock, Sock::Events{event});
         }
     }
@@ -2027,6 +2104,45 @@ Sock::EventsPerSock CConnman::GenerateWaitSockets(Span<CNode* const> nodes)
     return events_per_sock;
 }
 
+Sock::Event CConnman::GetWaitEvents(CNode& node) const
+{
+    bool select_recv = !node.fPauseRecv;
+    bool select_send;
+    {
+        LOCK(node.cs_vSend);
+        // Sending is possible if either there are bytes to send right now, or if there will be
+        // once a potential message from vSendMsg is handed to the transport. GetBytesToSend
+        // determines both of these in a single call.
+        const auto& [to_send, more, _msg_type] = node.m_transport->GetBytesToSend(!node.vSendMsg.empty());
+        select_send = !to_send.empty() || more;
+    }
+    return (select_send ? Sock::SEND : 0) | (select_recv ? Sock::RECV : 0);
+}
+
+void CConnman::UpdateRegisteredSockets(Span<CNode* const> nodes)
+{
+    for (CNode* pnode : nodes) {
+        if (!pnode->m_sock_events_dirty.exchange(false)) continue;
+        const Sock::Event event{GetWaitEvents(*pnode)};
+
+        LOCK(pnode->m_sock_mutex);
+        // A node without a socket is about to be disconnected, which unregisters it.
+        if (!pnode->m_sock) continue;
+        if (!m_sock_events->Set(pnode->m_sock, event)) {
+            LogPrintf("Unable to register socket of peer=%d, waiting on all sockets from now on: %s\n",
+                      pnode->GetId(), NetworkErrorString(WSAGetLastError()));
+            m_registered_nodes.clear();
+            m_sock_events.reset();
+            return;
+        }
+        if (event == 0) {
+            m_registered_nodes.erase(pnode->m_sock);
+        } else {
+            m_registered_nodes.emplace(pnode->m_sock, pnode);
+        }
+    }
+}
+
 void CConnman::SocketHandler()
 {
     AssertLockNotHeld(m_total_bytes_sent_mutex);
@@ -2038,17 +2154,43 @@ void CConnman::SocketHandler()
 
         const auto timeout = std::chrono::milliseconds(SELECT_TIMEOUT_MILLISECONDS);
 
-        // Check for the readiness of the already connected sockets and the
-        // listening sockets in one call ("readiness" as in poll(2) or
-        // select(2)). If none are ready, wait for a short while and return
-        // empty sets.
-        events_per_sock = GenerateWaitSockets(snap.Nodes());
-        if (events_per_sock.empty() || !events_per_sock.begin()->first->WaitMany(timeout, events_per_sock)) {
-            interruptNet.sleep_for(timeout);
+        if (m_sock_events) UpdateRegisteredSockets(snap.Nodes());
+
+        if (m_sock_events) {
+            // The sockets stay registered between iterations, so only the ones that
+            // are ready are returned, and only their nodes need to be serviced.
+            if (!m_sock_events->Wait(timeout, events_per_sock)) {
+                interruptNet.sleep_for(timeout);
+            }
+            std::vector<CNode*> ready_nodes;
+            for (const auto& [sock, events] : events_per_sock) {
+                const auto it = m_registered_nodes.find(sock);
+                if (it != m_registered_nodes.end()) ready_nodes.push_back(it->second);
+            }
+            SocketHandlerConnected(ready_nodes, events_per_sock);
+        } else {
+            // Check for the readiness of the already connected sockets and the
+            // listening sockets in one call ("readiness" as in poll(2) or
+            // select(2)). If none are ready, wait for a short while and return
+            // empty sets.
+            events_per_sock = GenerateWaitSockets(snap.Nodes());
+            if (events_per_sock.empty() || !events_per_sock.begin()->first->WaitMany(timeout, events_per_sock)) {
+                interruptNet.sleep_for(timeout);
+            }
+
+            // Service (send/receive) each of the already connected nodes.
+            SocketHandlerConnected(snap.Nodes(), events_per_sock);
         }
 
-        // Service (send/receive) each of the already connected nodes.
-        SocketHandlerConnected(snap.Nodes(), events_per_sock);
+        // Idle nodes are not visited above when their sockets are registered, so
+        // look at all of them for inactivity every now and then instead.
+        const auto now{SteadyClock::now()};
+        if (!m_sock_events || now >= m_next_inactivity_check) {
+            m_next_inactivity_check = now + INACTIVITY_CHECK_INTERVAL;
+            for (CNode* pnode : snap.Nodes()) {
+                if (InactivityCheck(*pnode)) pnode->fDisconnect = true;
+            }
+        }
     }
 
     // Accept new connections from listening sockets.
@@ -2118,6 +2260,8 @@ void CConnman::SocketHandlerConnected(const std::vector<CNode*>& nodes,
                 if (!pnode->ReceiveMsgBytes({pchBuf, (size_t)nBytes}, notify)) {
                     pnode->CloseSocketDisconnect();
                 }
+                // The transport may have something to send in response (e.g. the v2 handshake).
+                pnode->m_sock_events_dirty = true;
                 RecordBytesRecv(nBytes);
                 if (notify) {
                     pnode->MarkReceivedMsgsForProcessing();
@@ -2145,8 +2289,6 @@ void CConnman::SocketHandlerConnected(const std::vector<CNode*>& nodes,
                 }
             }
         }
-
-        if (InactivityCheck(*pnode)) pnode->fDisconnect = true;
     }
 }
 
@@ -2167,6 +2309,14 @@ void CConnman::ThreadSocketHandler()
 {
     AssertLockNotHeld(m_total_bytes_sent_mutex);
 
+    for (const ListenSocket& listen_socket : vhListenSocket) {
+        if (m_sock_events && !m_sock_events->Set(listen_socket.sock, Sock::RECV)) {
+            LogPrintf("Unable to register listening socket, waiting on all sockets from now on: %s\n",
+                      NetworkErrorString(WSAGetLastError()));
+            m_sock_events.reset();
+        }
+    }
+
     while (!interruptNet)
     {
         DisconnectNodes();
@@ -2936,6 +3086,41 @@ void CConnman::ThreadMessageHandler()
     }
 }
 
+void CConnman::WakeRequestHandlers()
+{
+    if (!HasRequestHandlers()) return;
+    WITH_LOCK(mutexMsgProc, ++m_request_wake_seq);
+    condRequestProc.notify_all();
+}
+
+void CConnman::ThreadRequestHandler(int shard)
+{
+    uint64_t wake_seq{0};
+
+    while (!flagInterruptMsgProc) {
+        bool more_work{false};
+
+        {
+            const NodesSnapshot snap{*this, /*shuffle=*/true};
+
+            for (CNode* pnode : snap.Nodes()) {
+                if (pnode->GetId() % m_request_threads != shard || pnode->fDisconnect) continue;
+
+                more_work |= m_msgproc->ProcessRequests(pnode, flagInterruptMsgProc) && !pnode->fPauseSend;
+                if (flagInterruptMsgProc) return;
+            }
+        }
+
+        WAIT_LOCK(mutexMsgProc, lock);
+        if (!more_work) {
+            condRequestProc.wait_until(lock, std::chrono::steady_clock::now() + std::chrono::milliseconds(100), [&]() EXCLUSIVE_LOCKS_REQUIRED(mutexMsgProc) {
+                return m_request_wake_seq != wake_seq || flagInterruptMsgProc;
+            });
+        }
+        wake_seq = m_request_wake_seq;
+    }
+}
+
 void CConnman::ThreadI2PAcceptIncoming()
 {
     static constexpr auto err_wait_begin = 1s;
@@ -3245,6 +3430,7 @@ bool CConnman::Start(CScheduler& scheduler, const Options& connOptions)
     }
 
     // Send and receive from sockets, accept connections
+    m_sock_events = SockEventRegistry::Make();
     threadSocketHandler = std::thread(&util::TraceThread, "net", [this] { ThreadSocketHandler(); });
 
     if (!gArgs.GetBoolArg("-dnsseed", DEFAULT_DNSSEED))
@@ -3271,6 +3457,9 @@ bool CConnman::Start(CScheduler& scheduler, const Options& connOptions)
 
     // Process messages
     threadMessageHandler = std::thread(&util::TraceThread, "msghand", [this] { ThreadMessageHandler(); });
+    for (int i = 0; i < m_request_threads; ++i) {
+        m_request_handler_threads.emplace_back(&util::TraceThread, strprintf("reqhand.%i", i), [this, i] { ThreadRequestHandler(i); });
+    }
 
     if (m_i2p_sam_session) {
         threadI2PAcceptIncoming =
@@ -3311,6 +3500,7 @@ void CConnman::Interrupt()
         flagInterruptMsgProc = true;
     }
     condMsgProc.notify_all();
+    condRequestProc.notify_all();
 
     interruptNet();
     g_socks5_interrupt();
@@ -3335,6 +3525,10 @@ void CConnman::StopThreads()
     }
     if (threadMessageHandler.joinable())
         threadMessageHandler.join();
+    for (std::thread& thread : m_request_handler_threads) {
+        thread.join();
+    }
+    m_request_handler_threads.clear();
     if (threadOpenConnections.joinable())
         threadOpenConnections.join();
     if (threadOpenAddedConnections.joinable())
@@ -3361,6 +3555,10 @@ void CConnman::StopNodes()
         }
     }
 
+    // Release the sockets held while registered, so that closing them below takes effect.
+    m_registered_nodes.clear();
+    m_sock_events.reset();
+
     // Delete peer connections.
     std::vector<CNode*> nodes;
     WITH_LOCK(m_nodes_mutex, nodes.swap(m_nodes));
@@ -3664,12 +3862,12 @@ ServiceFlags CConnman::GetLocalServices() const
     return nLocalServices;
 }
 
-static std::unique_ptr<Transport> MakeTransport(NodeId id, bool use_v2transport, bool inbound) noexcept
+static std::unique_ptr<Transport> MakeTransport(NodeId id, bool use_v2transport, bool inbound, std::shared_ptr<RecvBufferPool> recv_pool) noexcept
 {
     if (use_v2transport) {
-        return std::make_unique<V2Transport>(id, /*initiating=*/!inbound);
+        return std::make_unique<V2Transport>(id, /*initiating=*/!inbound, std::move(recv_pool));
     } else {
-        return std::make_unique<V1Transport>(id);
+        return std::make_unique<V1Transport>(id, std::move(recv_pool));
     }
 }
 
@@ -3683,7 +3881,7 @@ CNode::CNode(NodeId idIn,
              ConnectionType conn_type_in,
              bool inbound_onion,
              CNodeOptions&& node_opts)
-    : m_transport{MakeTransport(idIn, node_opts.use_v2transport, conn_type_in == ConnectionType::INBOUND)},
+    : m_transport{MakeTransport(idIn, node_opts.use_v2transport, conn_type_in == ConnectionType::INBOUND, std::move(node_opts.recv_buffer_pool))},
       m_permission_flags{node_opts.permission_flags},
       m_sock{sock},
       m_connected{GetTime<std::chrono::seconds>()},
@@ -3721,13 +3919,14 @@ void CNode::MarkReceivedMsgsForProcessing()
     for (const auto& msg : vRecvMsg) {
         // vRecvMsg contains only completed CNetMessage
         // the single possible partially deserialized message are held by TransportDeserializer
-        nSizeAdded += msg.m_raw_message_size;
+        nSizeAdded += msg.GetQueuedSize();
     }
 
     LOCK(m_msg_process_queue_mutex);
     m_msg_process_queue.splice(m_msg_process_queue.end(), vRecvMsg);
     m_msg_process_queue_size += nSizeAdded;
-    fPauseRecv = m_msg_process_queue_size > m_recv_flood_size;
+    const bool pause_recv{m_msg_process_queue_size > m_recv_flood_size};
+    if (fPauseRecv.exchange(pause_recv) != pause_recv) m_sock_events_dirty = true;
 }
 
 std::optional<std::pair<CNetMessage, bool>> CNode::PollMessage()
@@ -3738,8 +3937,9 @@ std::optional<std::pair<CNetMessage, bool>> CNode::PollMessage()
     std::list<CNetMessage> msgs;
     // Just take one message
     msgs.splice(msgs.begin(), m_msg_process_queue, m_msg_process_queue.begin());
-    m_msg_process_queue_size -= msgs.front().m_raw_message_size;
-    fPauseRecv = m_msg_process_queue_size > m_recv_flood_size;
+    m_msg_process_queue_size -= msgs.front().GetQueuedSize();
+    const bool pause_recv{m_msg_process_queue_size > m_recv_flood_size};
+    if (fPauseRecv.exchange(pause_recv) != pause_recv) m_sock_events_dirty = true;
 
     return std::make_pair(std::move(msgs.front()), !m_msg_process_queue.empty());
 }
@@ -3752,10 +3952,10 @@ bool CConnman::NodeFullyConnected(const CNode* pnode)
 void CConnman::PushMessage(CNode* pnode, CSerializedNetMsg&& msg)
 {
     AssertLockNotHeld(m_total_bytes_sent_mutex);
-    size_t nMessageSize = msg.data.size();
+    size_t nMessageSize = msg.Data().size();
     LogPrint(BCLog::NET, "sending %s (%d bytes) peer=%d\n", msg.m_type, nMessageSize, pnode->GetId());
     if (gArgs.GetBoolArg("-capturemessages", false)) {
-        CaptureMessage(pnode->addr, msg.m_type, msg.data, /*is_incoming=*/false);
+        CaptureMessage(pnode->addr, msg.m_type, msg.Data(), /*is_incoming=*/false);
     }
 
     TRACE6(net, outbound_message,
@@ -3763,8 +3963,8 @@ void CConnman::PushMessage(CNode* pnode, CSerializedNetMsg&& msg)
         pnode->m_addr_name.c_str(),
         pnode->ConnectionTypeAsString().c_str(),
         msg.m_type.c_str(),
-        msg.data.size(),
-        msg.data.data()
+        msg.Data().size(),
+        msg.Data().data()
     );
 
     size_t nBytesSent = 0;
@@ -3792,6 +3992,8 @@ void CConnman::PushMessage(CNode* pnode, CSerializedNetMsg&& msg)
         if (queue_was_empty && more) {
             std::tie(nBytesSent, std::ignore) = SocketSendData(*pnode);
         }
+        // Start waiting for the socket to become writable, if the above did not empty the queue.
+        if (queue_was_empty) pnode->m_sock_events_dirty = true;
     }
     if (nBytesSent) RecordBytesSent(nBytesSent);
 }
@@ -32,7 +32,10 @@
 #include <util/check.h>
 #include <util/sock.h>
 #include <util/threadinterrupt.h>
+#include <util/time.h>
 
+#include <algorithm>
+#include <array>
 #include <atomic>
 #include <condition_variable>
 #include <cstdint>
@@ -44,6 +47,7 @@
 #include <optional>
 #include <queue>
 #include <thread>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -97,6 +101,10 @@ static constexpr bool DEFAULT_DNSSEED{true};
 static constexpr bool DEFAULT_FIXEDSEEDS{true};
 static const size_t DEFAULT_MAXRECEIVEBUFFER = 5 * 1000;
 static const size_t DEFAULT_MAXSENDBUFFER    = 1 * 1000;
+/** Default number of threads serving the data requested by peers, 0 to do so from the message handler thread */
+static constexpr int DEFAULT_REQUEST_THREADS{0};
+/** Maximum number of threads serving the data requested by peers */
+static constexpr int MAX_REQUEST_THREADS{16};
 
 static constexpr bool DEFAULT_V2_TRANSPORT{true};
 
@@ -129,11 +137,17 @@ struct CSerializedNetMsg {
     {
         CSerializedNetMsg copy;
         copy.data = data;
+        copy.m_shared_data = m_shared_data;
         copy.m_type = m_type;
         return copy;
     }
 
+    /** The payload, from m_shared_data if set, otherwise from data. */
+    Span<const unsigned char> Data() const { return m_shared_data ? Span{*m_shared_data} : Span{data}; }
+
     std::vector<unsigned char> data;
+    /** Payload shared with others (e.g. a cached block) instead of copied into data. */
+    std::shared_ptr<const std::vector<unsigned char>> m_shared_data;
     std::string m_type;
 
     /** Compute total memory usage of this object (own memory + any dynamic memory). */
@@ -231,6 +245,41 @@ public:
 };
 
 
+/**
+ * Pool of buffers for received message payloads, shared by the transports of
+ * all connections.
+ *
+ * Transports borrow a buffer when they start receiving a message, and the
+ * buffer is given back once the message has been processed. Large messages
+ * then reuse memory that is already mapped, instead of allocating and
+ * faulting in several MB for every block or transaction batch.
+ *
+ * Only buffers of at least 64 KiB are pooled; smaller messages get a buffer
+ * of exactly their size, as before. Free buffers are kept in size classes,
+ * each twice as large as the previous one, up to the largest protocol
+ * message. The memory kept in each class is limited.
+ */
+class RecvBufferPool
+{
+public:
+    static constexpr size_t MIN_CLASS_SIZE{64 << 10};
+    static constexpr size_t NUM_CLASSES{7};
+    //! Limit on the capacity of the free buffers in each size class
+    static constexpr size_t MAX_CLASS_BYTES{8 << 20};
+
+    //! An empty buffer with room for at least size bytes. Below the smallest size class, exactly size bytes.
+    DataStream Get(size_t size) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    //! Give a buffer back for reuse. Buffers below the smallest size class are freed.
+    void Release(DataStream&& buffer) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    static constexpr size_t ClassSize(size_t cls) { return MIN_CLASS_SIZE << cls; }
+
+    Mutex m_mutex;
+    std::array<std::vector<DataStream>, NUM_CLASSES> m_free GUARDED_BY(m_mutex);
+    std::array<size_t, NUM_CLASSES> m_free_bytes GUARDED_BY(m_mutex){};
+};
+
 /** Transport protocol agnostic message container.
  * Ideally it should only contain receive time, payload,
  * type and size.
@@ -245,6 +294,10 @@ public:
     std::string m_type;
 
     explicit CNetMessage(DataStream&& recv_in) : m_recv(std::move(recv_in)) {}
+
+    /** Memory held by the message while it waits to be processed: its wire
+     * size, or the capacity of its (possibly pooled) buffer if that is larger. */
+    size_t GetQueuedSize() const { return std::max<size_t>(m_raw_message_size, m_recv.capacity()); }
     // Only one CNetMessage object will exist for the same message on either
     // the receive or processing queue. For performance reasons we therefore
     // delete the copy constructor and assignment operator to avoid the
@@ -374,6 +427,7 @@ class V1Transport final : public Transport
 private:
     const MessageStartChars m_magic_bytes;
     const NodeId m_node_id; // Only for logging
+    const std::shared_ptr<RecvBufferPool> m_recv_pool; // Where vRecv is borrowed from, if set
     mutable Mutex m_recv_mutex; //!< Lock for receive state
     mutable CHash256 hasher GUARDED_BY(m_recv_mutex);
     mutable uint256 data_hash GUARDED_BY(m_recv_mutex);
@@ -419,7 +473,7 @@ private:
     size_t m_bytes_sent GUARDED_BY(m_send_mutex) {0};
 
 public:
-    explicit V1Transport(const NodeId node_id) noexcept;
+    explicit V1Transport(const NodeId node_id, std::shared_ptr<RecvBufferPool> recv_pool = nullptr) noexcept;
 
     bool ReceivedMessageComplete() const override EXCLUSIVE_LOCKS_REQUIRED(!m_recv_mutex)
     {
@@ -585,6 +639,8 @@ private:
     const NodeId m_nodeid;
     /** Encapsulate a V1Transport to fall back to. */
     V1Transport m_v1_fallback;
+    /** Pool to borrow m_recv_decode_buffer from, if set. */
+    const std::shared_ptr<RecvBufferPool> m_recv_pool;
 
     /** Lock for receiver-side fields. */
     mutable Mutex m_recv_mutex ACQUIRED_BEFORE(m_send_mutex);
@@ -595,8 +651,8 @@ private:
     std::vector<uint8_t> m_recv_buffer GUARDED_BY(m_recv_mutex);
     /** AAD expected in next received packet (currently used only for garbage). */
     std::vector<uint8_t> m_recv_aad GUARDED_BY(m_recv_mutex);
-    /** Buffer to put decrypted contents in, for converting to CNetMessage. */
-    std::vector<uint8_t> m_recv_decode_buffer GUARDED_BY(m_recv_mutex);
+    /** Buffer to put decrypted contents in. It becomes the payload of the CNetMessage. */
+    DataStream m_recv_decode_buffer GUARDED_BY(m_recv_mutex);
     /** Current receiver state. */
     RecvState m_recv_state GUARDED_BY(m_recv_mutex);
 
@@ -634,6 +690,8 @@ private:
     bool ProcessReceivedGarbageBytes() noexcept EXCLUSIVE_LOCKS_REQUIRED(m_recv_mutex);
     /** Process bytes in m_recv_buffer, while in VERSION/APP state. */
     bool ProcessReceivedPacketBytes() noexcept EXCLUSIVE_LOCKS_REQUIRED(m_recv_mutex);
+    /** Give m_recv_decode_buffer back to the pool, or free it. */
+    void ReleaseRecvDecodeBuffer() noexcept EXCLUSIVE_LOCKS_REQUIRED(m_recv_mutex);
 
 public:
     static constexpr uint32_t MAX_GARBAGE_LEN = 4095;
@@ -643,10 +701,10 @@ public:
      * @param[in] nodeid      the node's NodeId (only for debug log output).
      * @param[in] initiating  whether we are the initiator side.
      */
-    V2Transport(NodeId nodeid, bool initiating) noexcept;
+    V2Transport(NodeId nodeid, bool initiating, std::shared_ptr<RecvBufferPool> recv_pool = nullptr) noexcept;
 
     /** Construct a V2 transport with specified keys and garbage (test use only). */
-    V2Transport(NodeId nodeid, bool initiating, const CKey& key, Span<const std::byte> ent32, std::vector<uint8_t> garbage) noexcept;
+    V2Transport(NodeId nodeid, bool initiating, const CKey& key, Span<const std::byte> ent32, std::vector<uint8_t> garbage, std::shared_ptr<RecvBufferPool> recv_pool = nullptr) noexcept;
 
     // Receive side functions.
     bool ReceivedMessageComplete() const noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_recv_mutex);
@@ -671,6 +729,7 @@ struct CNodeOptions
     bool prefer_evict = false;
     size_t recv_flood_size{DEFAULT_MAXRECEIVEBUFFER * 1000};
     bool use_v2transport = false;
+    std::shared_ptr<RecvBufferPool> recv_buffer_pool = nullptr;
 };
 
 /** Information about a peer */
@@ -741,6 +800,11 @@ public:
     const uint64_t nKeyedNetGroup;
     std::atomic_bool fPauseRecv{false};
     std::atomic_bool fPauseSend{false};
+    /**
+     * Set when what to wait for on m_sock may have changed (vSendMsg going empty or
+     * non-empty, fPauseRecv flipping), so that the socket handler updates its registration.
+     */
+    std::atomic_bool m_sock_events_dirty{true};
 
     const ConnectionType m_conn_type;
 
@@ -1029,6 +1093,17 @@ public:
     */
     virtual bool SendMessages(CNode* pnode) EXCLUSIVE_LOCKS_REQUIRED(g_msgproc_mutex) = 0;
 
+    /**
+    * Serve the data a given node requested (getdata), without affecting validation.
+    * Called from the request handler threads, concurrently with the above for other
+    * nodes. Each node is only ever served by one of these threads, in order.
+    *
+    * @param[in]   pnode           The node whose requests to serve.
+    * @param[in]   interrupt       Interrupt condition for processing threads
+    * @return                      True if there is more work to be done
+    */
+    virtual bool ProcessRequests(CNode* pnode, std::atomic<bool>& interrupt) = 0;
+
 
 protected:
     /**
@@ -1053,6 +1128,7 @@ public:
         unsigned int nReceiveFloodSize = 0;
         uint64_t nMaxOutboundLimit = 0;
         int64_t m_peer_connect_timeout = DEFAULT_PEER_CONNECT_TIMEOUT;
+        int m_request_threads = DEFAULT_REQUEST_THREADS;
         std::vector<std::string> vSeedNodes;
         std::vector<NetWhitelistPermissions> vWhitelistedRange;
         std::vector<NetWhitebindPermissions> vWhiteBinds;
@@ -1084,6 +1160,7 @@ public:
         nSendBufferMaxSize = connOptions.nSendBufferMaxSize;
         nReceiveFloodSize = connOptions.nReceiveFloodSize;
         m_peer_connect_timeout = std::chrono::seconds{connOptions.m_peer_connect_timeout};
+        m_request_threads = connOptions.m_request_threads;
         {
             LOCK(m_total_bytes_sent_mutex);
             nMaxOutboundLimit = connOptions.nMaxOutboundLimit;
@@ -1243,6 +1320,15 @@ public:
 
     void WakeMessageHandler() EXCLUSIVE_LOCKS_REQUIRED(!mutexMsgProc);
 
+    /** Whether the data requested by peers is served by the request handler threads, see -requestthreads. */
+    bool HasRequestHandlers() const { return m_request_threads > 0; }
+
+    /** Have the request handler threads look for requests to serve. */
+    void WakeRequestHandlers() EXCLUSIVE_LOCKS_REQUIRED(!mutexMsgProc);
+
+    /** Give the payload buffer of a processed message back for reuse by the transports. */
+    void ReleaseRecvBuffer(DataStream&& buffer) { m_recv_buffer_pool->Release(std::move(buffer)); }
+
     /** Return true if we should disconnect the peer for failing an inactivity check. */
     bool ShouldRunInactivityChecks(const CNode& node, std::chrono::seconds now) const;
 
@@ -1275,6 +1361,11 @@ private:
     void ProcessAddrFetch() EXCLUSIVE_LOCKS_REQUIRED(!m_addr_fetches_mutex, !m_unused_i2p_sessions_mutex);
     void ThreadOpenConnections(std::vector<std::string> connect) EXCLUSIVE_LOCKS_REQUIRED(!m_addr_fetches_mutex, !m_added_nodes_mutex, !m_nodes_mutex, !m_unused_i2p_sessions_mutex, !m_reconnections_mutex);
     void ThreadMessageHandler() EXCLUSIVE_LOCKS_REQUIRED(!mutexMsgProc);
+    /**
+     * Serve the requests of the nodes whose id modulo m_request_threads is `shard`,
+     * so that each node's requests are answered in order.
+     */
+    void ThreadRequestHandler(int shard) EXCLUSIVE_LOCKS_REQUIRED(!mutexMsgProc);
     void ThreadI2PAcceptIncoming();
     void AcceptConnection(const ListenSocket& hListenSocket);
 
@@ -1303,6 +1394,17 @@ private:
      */
     Sock::EventsPerSock GenerateWaitSockets(Span<CNode* const> nodes);
 
+    /** Return what to wait for on the socket of a node: receiving unless paused, sending if anything is queued. */
+    Sock::Event GetWaitEvents(CNode& node) const;
+
+    /**
+     * Pass the changes in what to wait for on the nodes' sockets on to `m_sock_events`.
+     * Only the nodes marked with `m_sock_events_dirty` are looked at. On failure, fall
+     * back to `GenerateWaitSockets()` for good.
+     * @param[in] nodes Register from these nodes' sockets.
+     */
+    void UpdateRegisteredSockets(Span<CNode* const> nodes);
+
     /**
      * Check connected and listening sockets for IO readiness and process them accordingly.
      */
@@ -1403,8 +1505,21 @@ private:
 
     unsigned int nSendBufferMaxSize{0};
     unsigned int nReceiveFloodSize{0};
+    /** Buffers the transports of all nodes receive message payloads into. */
+    const std::shared_ptr<RecvBufferPool> m_recv_buffer_pool{std::make_shared<RecvBufferPool>()};
 
     std::vector<ListenSocket> vhListenSocket;
+
+    /**
+     * Listening and connected sockets registered once to be waited on by the socket
+     * handler, if supported on this platform. Only used by the socket handler thread.
+     */
+    std::unique_ptr<SockEventRegistry> m_sock_events;
+    /** The nodes whose sockets are registered with `m_sock_events`. */
+    std::unordered_map<std::shared_ptr<const Sock>, CNode*, Sock::HashSharedPtrSock, Sock::EqualSharedPtrSock> m_registered_nodes;
+    /** When to next check all nodes for inactivity, if `m_sock_events` is used. */
+    SteadyClock::time_point m_next_inactivity_check{};
+
     std::atomic<bool> fNetworkActive{true};
     bool fAddressesInitialized{false};
     AddrMan& addrman;
@@ -1513,6 +1628,12 @@ private:
     Mutex mutexMsgProc;
     std::atomic<bool> flagInterruptMsgProc{false};
 
+    /** Number of request handler threads, 0 if requests are served by the message handler. */
+    int m_request_threads{0};
+    /** Bumped for waking the request handler threads. */
+    uint64_t m_request_wake_seq GUARDED_BY(mutexMsgProc){0};
+    std::condition_variable condRequestProc;
+
     /**
      * This is signaled when network activity should cease.
      * A pointer to it is saved in `m_i2p_sam_session`, so make sure that
@@ -1533,6 +1654,7 @@ private:
     std::thread threadOpenAddedConnections;
     std::thread threadOpenConnections;
     std::thread threadMessageHandler;
+    std::vector<std::thread> m_request_handler_threads;
     std::thread threadI2PAcceptIncoming;
 
     /** flag for deciding to connect to an extra outbound peer,
@@ -291,8 +291,9 @@ struct Peer {
          *  transaction announcements to this peer. */
         std::chrono::microseconds m_next_inv_send_time GUARDED_BY(m_tx_inventory_mutex){0};
         /** The mempool sequence num at which we sent the last `inv` message to this peer.
-         *  Can relay txs with lower sequence numbers than this (see CTxMempool::info_for_relay). */
-        uint64_t m_last_inv_sequence GUARDED_BY(NetEventsInterface::g_msgproc_mutex){1};
+         *  Can relay txs with lower sequence numbers than this (see CTxMempool::info_for_relay).
+         *  Atomic as getdata requests may be served outside of the message handler thread. */
+        std::atomic<uint64_t> m_last_inv_sequence{1};
 
         /** Minimum fee rate with which to filter transaction announcements to this node. See BIP133. */
         std::atomic<CAmount> m_fee_filter_received{0};
@@ -507,6 +508,8 @@ public:
         EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex, !m_recent_confirmed_transactions_mutex, !m_most_recent_block_mutex, !m_headers_presync_mutex, g_msgproc_mutex);
     bool SendMessages(CNode* pto) override
         EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex, !m_recent_confirmed_transactions_mutex, !m_most_recent_block_mutex, g_msgproc_mutex);
+    bool ProcessRequests(CNode* pfrom, std::atomic<bool>& interrupt) override
+        EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex, !m_most_recent_block_mutex);
 
     /** Implement PeerManager */
     void StartScheduledTasks(CScheduler& scheduler) override;
@@ -958,10 +961,11 @@ private:
 
     /** Determine whether or not a peer can request a transaction, and return it (or nullptr if not found or not allowed). */
     CTransactionRef FindTxForGetData(const Peer::TxRelay& tx_relay, const GenTxid& gtxid)
-        EXCLUSIVE_LOCKS_REQUIRED(!m_most_recent_block_mutex, NetEventsInterface::g_msgproc_mutex);
+        EXCLUSIVE_LOCKS_REQUIRED(!m_most_recent_block_mutex);
 
+    /** Serve the queued getdata requests of a peer. Does not need g_msgproc_mutex, see ProcessRequests(). */
     void ProcessGetData(CNode& pfrom, Peer& peer, const std::atomic<bool>& interruptMsgProc)
-        EXCLUSIVE_LOCKS_REQUIRED(!m_most_recent_block_mutex, peer.m_getdata_requests_mutex, NetEventsInterface::g_msgproc_mutex)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_most_recent_block_mutex, peer.m_getdata_requests_mutex)
         LOCKS_EXCLUDED(::cs_main);
 
     /** Process a new block. Perform any post-processing housekeeping */
@@ -2335,20 +2339,22 @@ void PeerManagerImpl::ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv&
         pblock = a_recent_block;
     } else if (inv.IsMsgWitnessBlk()) {
         // Fast-path: in this case it is possible to serve the block directly from disk,
-        // as the network format matches the format on disk
-        std::vector<uint8_t> block_data;
-        if (!m_chainman.m_blockman.ReadRawBlockFromDisk(block_data, pindex->GetBlockPos())) {
+        // as the network format matches the format on disk. The message shares the
+        // raw block with the cache instead of copying it.
+        CSerializedNetMsg msg;
+        msg.m_type = NetMsgType::BLOCK;
+        msg.m_shared_data = m_chainman.m_blockman.ReadRawBlockCached(*pindex);
+        if (!msg.m_shared_data) {
             assert(!"cannot load block from disk");
         }
-        MakeAndPushMessage(pfrom, NetMsgType::BLOCK, Span{block_data});
+        m_connman.PushMessage(&pfrom, std::move(msg));
         // Don't set pblock as we've sent the block
     } else {
-        // Send block from disk
-        std::shared_ptr<CBlock> pblockRead = std::make_shared<CBlock>();
-        if (!m_chainman.m_blockman.ReadBlockFromDisk(*pblockRead, *pindex)) {
+        // Send block from disk, or from the cache of recently served blocks
+        pblock = m_chainman.m_blockman.ReadBlockCached(*pindex);
+        if (!pblock) {
             assert(!"cannot load block from disk");
         }
-        pblock = pblockRead;
     }
     if (pblock) {
         if (inv.IsMsgBlk()) {
@@ -3997,8 +4003,9 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
         {
             LOCK(peer->m_getdata_requests_mutex);
             peer->m_getdata_requests.insert(peer->m_getdata_requests.end(), vInv.begin(), vInv.end());
-            ProcessGetData(pfrom, *peer, interruptMsgProc);
+            if (!m_connman.HasRequestHandlers()) ProcessGetData(pfrom, *peer, interruptMsgProc);
         }
+        m_connman.WakeRequestHandlers();
 
         return;
     }
@@ -4095,11 +4102,10 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
             }
 
             if (pindex->nHeight >= m_chainman.ActiveChain().Height() - MAX_BLOCKTXN_DEPTH) {
-                CBlock block;
-                const bool ret{m_chainman.m_blockman.ReadBlockFromDisk(block, *pindex)};
-                assert(ret);
+                const auto block{m_chainman.m_blockman.ReadBlockCached(*pindex)};
+                assert(block);
 
-                SendBlockTransactions(pfrom, *peer, block, req);
+                SendBlockTransactions(pfrom, *peer, *block, req);
                 return;
             }
         }
@@ -4114,7 +4120,9 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
         LogPrint(BCLog::NET, "Peer %d sent us a getblocktxn for a block > %i deep\n", pfrom.GetId(), MAX_BLOCKTXN_DEPTH);
         CInv inv{MSG_WITNESS_BLOCK, req.blockhash};
         WITH_LOCK(peer->m_getdata_requests_mutex, peer->m_getdata_requests.push_back(inv));
-        // The message processing loop will go around again (without pausing) and we'll respond then
+        // The message processing loop (or a request handler thread) will go around again
+        // (without pausing) and we'll respond then
+        m_connman.WakeRequestHandlers();
         return;
     }
 
@@ -5061,7 +5069,7 @@ bool PeerManagerImpl::ProcessMessages(CNode* pfrom, std::atomic<bool>& interrupt
     PeerRef peer = GetPeerRef(pfrom->GetId());
     if (peer == nullptr) return false;
 
-    {
+    if (!m_connman.HasRequestHandlers()) {
         LOCK(peer->m_getdata_requests_mutex);
         if (!peer->m_getdata_requests.empty()) {
             ProcessGetData(*pfrom, *peer, interruptMsgProc);
@@ -5077,9 +5085,10 @@ bool PeerManagerImpl::ProcessMessages(CNode* pfrom, std::atomic<bool>& interrupt
 
     // this maintains the order of responses
     // and prevents m_getdata_requests to grow unbounded
+    // (a request handler thread wakes us up once it has served them)
     {
         LOCK(peer->m_getdata_requests_mutex);
-        if (!peer->m_getdata_requests.empty()) return true;
+        if (!peer->m_getdata_requests.empty()) return !m_connman.HasRequestHandlers();
     }
 
     // Don't bother if send buffer is too full to respond anyway
@@ -5110,7 +5119,7 @@ bool PeerManagerImpl::ProcessMessages(CNode* pfrom, std::atomic<bool>& interrupt
     try {
         ProcessMessage(*pfrom, msg.m_type, msg.m_recv, msg.m_time, interruptMsgProc);
         if (interruptMsgProc) return false;
-        {
+        if (!m_connman.HasRequestHandlers()) {
             LOCK(peer->m_getdata_requests_mutex);
             if (!peer->m_getdata_requests.empty()) fMoreWork = true;
         }
@@ -5125,10 +5134,28 @@ bool PeerManagerImpl::ProcessMessages(CNode* pfrom, std::atomic<bool>& interrupt
     } catch (...) {
         LogPrint(BCLog::NET, "%s(%s, %u bytes): Unknown exception caught\n", __func__, SanitizeString(msg.m_type), msg.m_message_size);
     }
+    m_connman.ReleaseRecvBuffer(std::move(msg.m_recv));
 
     return fMoreWork;
 }
 
+bool PeerManagerImpl::ProcessRequests(CNode* pfrom, std::atomic<bool>& interruptMsgProc)
+{
+    PeerRef peer = GetPeerRef(pfrom->GetId());
+    if (peer == nullptr) return false;
+
+    // While these are pending, ProcessMessages() leaves the peer's further messages alone,
+    // which keeps our responses in order.
+    {
+        LOCK(peer->m_getdata_requests_mutex);
+        if (peer->m_getdata_requests.empty()) return false;
+        ProcessGetData(*pfrom, *peer, interruptMsgProc);
+        if (!peer->m_getdata_requests.empty()) return true;
+    }
+    m_connman.WakeMessageHandler();
+    return false;
+}
+
 void PeerManagerImpl::ConsiderEviction(CNode& pto, Peer& peer, std::chrono::seconds time_in_seconds)
 {
     AssertLockHeld(cs_main);
@@ -5713,10 +5740,9 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
                     if (cached_cmpctblock_msg.has_value()) {
                         PushMessage(*pto, std::move(cached_cmpctblock_msg.value()));
                     } else {
-                        CBlock block;
-                        const bool ret{m_chainman.m_blockman.ReadBlockFromDisk(block, *pBestIndex)};
-                        assert(ret);
-                        CBlockHeaderAndShortTxIDs cmpctblock{block};
+                        const auto block{m_chainman.m_blockman.ReadBlockCached(*pBestIndex)};
+                        assert(block);
+                        CBlockHeaderAndShortTxIDs cmpctblock{*block};
                         MakeAndPushMessage(*pto, NetMsgType::CMPCTBLOCK, cmpctblock);
                     }
                     state.pindexBestHeaderSent = pBestIndex;
@@ -12,7 +12,9 @@
 #include <util/translation.h>
 #include <validation.h>
 
+#include <algorithm>
 #include <cstdint>
+#include <limits>
 
 namespace node {
 util::Result<void> ApplyArgsManOptions(const ArgsManager& args, BlockManager::Options& opts)
@@ -34,6 +36,27 @@ util::Result<void> ApplyArgsManOptions(const ArgsManager& args, BlockManager::Op
 
     if (auto value{args.GetBoolArg("-fastprune")}) opts.fast_prune = *value;
 
+    if (auto value{args.GetBoolArg("-compactundo")}) opts.compact_undo = *value;
+
+    if (auto value{args.GetIntArg("-blockcachesize")}) {
+        if (*value < 0) {
+            return util::Error{_("Block cache cannot be configured with a negative size.")};
+        }
+        opts.block_cache_size = size_t(std::min<uint64_t>(*value, std::numeric_limits<size_t>::max() >> 20)) << 20;
+    }
+
+    if (auto value{args.GetArg("-checkpowonload")}) {
+        if (*value == "full") {
+            opts.check_pow_on_load = CheckPowOnLoad::FULL;
+        } else if (*value == "cached") {
+            opts.check_pow_on_load = CheckPowOnLoad::CACHED;
+        } else if (*value == "none") {
+            opts.check_pow_on_load = CheckPowOnLoad::NONE;
+        } else {
+            return util::Error{strprintf(_("Invalid -checkpowonload value '%s' (must be full, cached or none)."), *value)};
+        }
+    }
+
     return {};
 }
 } // namespace node
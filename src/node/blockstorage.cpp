@@ -9,6 +9,8 @@
 #include <chain.h>
 #include <consensus/params.h>
 #include <consensus/validation.h>
+#include <core_memusage.h>
+#include <crypto/common.h>
 #include <dbwrapper.h>
 #include <flatfile.h>
 #include <hash.h>
@@ -17,6 +19,7 @@
 #include <kernel/messagestartchars.h>
 #include <kernel/notifications_interface.h>
 #include <logging.h>
+#include <memusage.h>
 #include <pow.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
@@ -33,6 +36,7 @@
 #include <util/fs.h>
 #include <util/signalinterrupt.h>
 #include <util/strencodings.h>
+#include <util/thread.h>
 #include <util/translation.h>
 #include <validation.h>
 
@@ -102,7 +106,7 @@ bool BlockTreeDB::ReadFlag(const std::string& name, bool& fValue)
     return true;
 }
 
-bool BlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex, const util::SignalInterrupt& interrupt)
+bool BlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex, const util::SignalInterrupt& interrupt, CheckPowOnLoad check_pow)
 {
     AssertLockHeld(::cs_main);
     std::unique_ptr<CDBIterator> pcursor(NewIterator());
@@ -131,9 +135,28 @@ bool BlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams, s
                 pindexNew->nStatus        = diskindex.nStatus;
                 pindexNew->nTx            = diskindex.nTx;
 
-                if (!CheckProofOfWork(pindexNew->GetBlockHash(), pindexNew->nBits, consensusParams)) {
-                    return error("%s: CheckProofOfWork failed: %s", __func__, pindexNew->ToString());
-                }
+                switch (check_pow) {
+                case CheckPowOnLoad::NONE:
+                    break;
+                case CheckPowOnLoad::CACHED:
+                    // The stored BLOCK_POW_VERIFIED flags are not used here:
+                    // no mix is recomputed on load in this mode. They let
+                    // ConnectBlock() skip the mix of a flagged block, e.g.
+                    // on -reindex-chainstate.
+                    if (!CheckProofOfWork(pindexNew->GetBlockHash(), pindexNew->nBits, consensusParams)) {
+                        return error("%s: CheckProofOfWork failed: %s", __func__, pindexNew->ToString());
+                    }
+                    break;
+                case CheckPowOnLoad::FULL:
+                    if (!CheckProofOfWork(pindexNew->GetBlockHash(), pindexNew->nBits, consensusParams) ||
+                        !CheckProofOfWorkMix(pindexNew->GetBlockHeader(), consensusParams)) {
+                        return error("%s: CheckProofOfWorkMix failed: %s", __func__, pindexNew->ToString());
+                    }
+                    // Only kept in memory; the entry is rewritten with the
+                    // flag whenever it is next marked dirty.
+                    pindexNew->nStatus |= BLOCK_POW_VERIFIED;
+                    break;
+                } // no default case, so the compiler can warn about missing cases
 
                 pcursor->Next();
             } else {
@@ -244,6 +267,7 @@ void BlockManager::PruneOneBlockFile(const int fileNumber)
         if (pindex->nFile == fileNumber) {
             pindex->nStatus &= ~BLOCK_HAVE_DATA;
             pindex->nStatus &= ~BLOCK_HAVE_UNDO;
+            pindex->nStatus &= ~BLOCK_UNDO_COMPACT;
             pindex->nFile = 0;
             pindex->nDataPos = 0;
             pindex->nUndoPos = 0;
@@ -396,7 +420,7 @@ CBlockIndex* BlockManager::InsertBlockIndex(const uint256& hash)
 bool BlockManager::LoadBlockIndex(const std::optional<uint256>& snapshot_blockhash)
 {
     if (!m_block_tree_db->LoadBlockIndexGuts(
-            GetConsensus(), [this](const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main) { return this->InsertBlockIndex(hash); }, m_interrupt)) {
+            GetConsensus(), [this](const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main) { return this->InsertBlockIndex(hash); }, m_interrupt, m_opts.check_pow_on_load)) {
         return false;
     }
 
@@ -474,6 +498,10 @@ bool BlockManager::LoadBlockIndex(const std::optional<uint256>& snapshot_blockha
 bool BlockManager::WriteBlockIndexDB()
 {
     AssertLockHeld(::cs_main);
+    // Do not record undo positions before the undo data has been written.
+    if (!m_undo_writer.Wait()) {
+        return false;
+    }
     std::vector<std::pair<int, const CBlockFileInfo*>> vFiles;
     vFiles.reserve(m_dirty_fileinfo.size());
     for (std::set<int>::iterator it = m_dirty_fileinfo.begin(); it != m_dirty_fileinfo.end();) {
@@ -667,43 +695,206 @@ CBlockFileInfo* BlockManager::GetBlockFileInfo(size_t n)
     return &m_blockfile_info.at(n);
 }
 
-bool BlockManager::UndoWriteToDisk(const CBlockUndo& blockundo, FlatFilePos& pos, const uint256& hashBlock) const
+UndoWriter::~UndoWriter()
 {
-    // Open history file to append
-    AutoFile fileout{OpenUndoFile(pos)};
+    if (!m_thread.joinable()) return;
+    WITH_LOCK(m_mutex, m_stop = true);
+    m_cond.notify_all();
+    m_thread.join();
+}
+
+bool UndoWriter::Write(const FlatFilePos& pos, const uint256& prev_hash, std::vector<uint8_t>&& data)
+{
+    {
+        WAIT_LOCK(m_mutex, lock);
+        m_cond.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_failed || m_queued_bytes < MAX_QUEUED_BYTES; });
+        if (m_failed) return false;
+        m_queued_bytes += data.size();
+        m_queue.push_back(Job{pos, prev_hash, std::move(data)});
+    }
+    if (!m_thread.joinable()) {
+        m_thread = std::thread(&util::TraceThread, "undowriter", [this] { ThreadWrite(); });
+    }
+    m_cond.notify_all();
+    return true;
+}
+
+bool UndoWriter::Wait() const
+{
+    WAIT_LOCK(m_mutex, lock);
+    m_cond.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_queue.empty(); });
+    return !m_failed;
+}
+
+std::optional<std::vector<uint8_t>> UndoWriter::GetQueued(const FlatFilePos& pos) const
+{
+    LOCK(m_mutex);
+    for (const Job& job : m_queue) {
+        if (job.pos == pos) return job.data;
+    }
+    return std::nullopt;
+}
+
+void UndoWriter::ThreadWrite()
+{
+    WAIT_LOCK(m_mutex, lock);
+    while (true) {
+        m_cond.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_stop || !m_queue.empty(); });
+        if (m_queue.empty()) return;
+        // The front job is only removed by this thread, so it can be written
+        // without holding m_mutex.
+        const Job& job{m_queue.front()};
+        bool ok{!m_failed};
+        if (ok) {
+            REVERSE_LOCK(lock);
+            ok = WriteToDisk(job);
+            if (!ok) m_notifications.fatalError("Failed to write undo data");
+        }
+        m_failed = !ok;
+        m_queued_bytes -= job.data.size();
+        m_queue.pop_front();
+        m_cond.notify_all();
+    }
+}
+
+bool UndoWriter::WriteToDisk(const Job& job)
+{
+    const FlatFilePos header_pos{job.pos.nFile, job.pos.nPos - static_cast<unsigned int>(BLOCK_SERIALIZATION_HEADER_SIZE)};
+    AutoFile fileout{m_seq.Open(header_pos)};
     if (fileout.IsNull()) {
         return error("%s: OpenUndoFile failed", __func__);
     }
 
-    // Write index header
-    unsigned int nSize = GetSerializeSize(blockundo);
-    fileout << GetParams().MessageStart() << nSize;
+    try {
+        // Write index header and undo data
+        fileout << m_message_start << static_cast<unsigned int>(job.data.size());
+        fileout.write(MakeByteSpan(job.data));
+
+        // calculate & write checksum
+        HashWriter hasher{};
+        hasher << job.prev_hash;
+        hasher.write(MakeByteSpan(job.data));
+        fileout << hasher.GetHash();
+    } catch (const std::exception& e) {
+        return error("%s: I/O error - %s", __func__, e.what());
+    }
 
-    // Write undo data
-    long fileOutPos = ftell(fileout.Get());
-    if (fileOutPos < 0) {
-        return error("%s: ftell failed", __func__);
+    if (fileout.fclose() != 0) {
+        return error("%s: fclose failed", __func__);
     }
-    pos.nPos = (unsigned int)fileOutPos;
-    fileout << blockundo;
+    return true;
+}
 
-    // calculate & write checksum
-    HashWriter hasher{};
-    hasher << hashBlock;
-    hasher << blockundo;
-    fileout << hasher.GetHash();
+BlockCache::Shard& BlockCache::GetShard(const uint256& hash)
+{
+    // The shard's hash map uses the first 8 bytes, so pick the shard with other ones
+    return m_shards[ReadLE64(hash.begin() + 8) % SHARDS];
+}
 
-    return true;
+template <typename T>
+std::shared_ptr<const T> BlockCache::Get(const uint256& hash, std::shared_ptr<const T> Entry::*member)
+{
+    if (!Enabled()) return nullptr;
+    Shard& shard{GetShard(hash)};
+    std::shared_ptr<const T> value;
+    {
+        LOCK(shard.m_mutex);
+        const auto it{shard.m_entries.find(hash)};
+        if (it != shard.m_entries.end() && (*it->second).*member) {
+            shard.m_lru.splice(shard.m_lru.begin(), shard.m_lru, it->second);
+            value = (*it->second).*member;
+        }
+    }
+    ++(value ? m_hits : m_misses);
+    return value;
+}
+
+template <typename T>
+void BlockCache::Put(const uint256& hash, std::shared_ptr<const T> Entry::*member, std::shared_ptr<const T> value, size_t bytes)
+{
+    if (!Enabled() || !value || bytes > m_shard_max_bytes) return;
+    // Memory of the list node and the hash map node of an entry
+    static const size_t ENTRY_USAGE{memusage::MallocUsage(sizeof(Entry) + 2 * sizeof(void*)) +
+                                    memusage::MallocUsage(sizeof(std::pair<const uint256, std::list<Entry>::iterator>) + sizeof(void*))};
+    Shard& shard{GetShard(hash)};
+    LOCK(shard.m_mutex);
+    auto it{shard.m_entries.find(hash)};
+    if (it == shard.m_entries.end()) {
+        shard.m_lru.push_front(Entry{.hash = hash, .block = nullptr, .raw = nullptr, .bytes = ENTRY_USAGE});
+        it = shard.m_entries.emplace(hash, shard.m_lru.begin()).first;
+        shard.m_bytes += ENTRY_USAGE;
+    } else {
+        shard.m_lru.splice(shard.m_lru.begin(), shard.m_lru, it->second);
+    }
+    Entry& entry{*it->second};
+    if (entry.*member) return; // Added by another thread in the meantime
+    entry.*member = std::move(value);
+    entry.bytes += bytes;
+    shard.m_bytes += bytes;
+    while (shard.m_bytes > m_shard_max_bytes && &shard.m_lru.back() != &entry) {
+        const Entry& evict{shard.m_lru.back()};
+        shard.m_bytes -= evict.bytes;
+        shard.m_entries.erase(evict.hash);
+        shard.m_lru.pop_back();
+    }
+}
+
+std::shared_ptr<const CBlock> BlockCache::GetBlock(const uint256& hash)
+{
+    return Get(hash, &Entry::block);
+}
+
+std::shared_ptr<const std::vector<uint8_t>> BlockCache::GetRawBlock(const uint256& hash)
+{
+    return Get(hash, &Entry::raw);
+}
+
+void BlockCache::PutBlock(const uint256& hash, std::shared_ptr<const CBlock> block)
+{
+    const size_t bytes{RecursiveDynamicUsage(block)};
+    Put(hash, &Entry::block, std::move(block), bytes);
+}
+
+void BlockCache::PutRawBlock(const uint256& hash, std::shared_ptr<const std::vector<uint8_t>> block)
+{
+    const size_t bytes{block ? memusage::DynamicUsage(block) + memusage::DynamicUsage(*block) : 0};
+    Put(hash, &Entry::raw, std::move(block), bytes);
+}
+
+BlockCache::Stats BlockCache::GetStats() const
+{
+    Stats stats{.hits = m_hits, .misses = m_misses, .blocks = 0, .bytes = 0, .max_bytes = m_shard_max_bytes * SHARDS};
+    for (const Shard& shard : m_shards) {
+        LOCK(shard.m_mutex);
+        stats.blocks += shard.m_entries.size();
+        stats.bytes += shard.m_bytes;
+    }
+    return stats;
 }
 
 bool BlockManager::UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex& index) const
 {
-    const FlatFilePos pos{WITH_LOCK(::cs_main, return index.GetUndoPos())};
+    const auto [pos, compact]{WITH_LOCK(::cs_main, return std::make_pair(index.GetUndoPos(), (index.nStatus & BLOCK_UNDO_COMPACT) != 0))};
 
     if (pos.IsNull()) {
         return error("%s: no undo data available", __func__);
     }
 
+    // Undo data that is still being written is read from memory
+    if (auto queued{m_undo_writer.GetQueued(pos)}) {
+        DataStream stream{*queued};
+        try {
+            if (compact) {
+                stream >> CompactBlockUndo{blockundo, index.nHeight};
+            } else {
+                stream >> blockundo;
+            }
+        } catch (const std::exception& e) {
+            return error("%s: Deserialize error - %s", __func__, e.what());
+        }
+        return true;
+    }
+
     // Open history file to read
     AutoFile filein{OpenUndoFile(pos, true)};
     if (filein.IsNull()) {
@@ -715,7 +906,11 @@ bool BlockManager::UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex& in
     HashVerifier verifier{filein}; // Use HashVerifier as reserializing may lose data, c.f. commit d342424301013ec47dc146a4beb49d5c9319d80a
     try {
         verifier << index.pprev->GetBlockHash();
-        verifier >> blockundo;
+        if (compact) {
+            verifier >> CompactBlockUndo{blockundo, index.nHeight};
+        } else {
+            verifier >> blockundo;
+        }
         filein >> hashChecksum;
     } catch (const std::exception& e) {
         return error("%s: Deserialize or I/O error - %s", __func__, e.what());
@@ -731,6 +926,9 @@ bool BlockManager::UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex& in
 
 bool BlockManager::FlushUndoFile(int block_file, bool finalize)
 {
+    if (!m_undo_writer.Wait()) {
+        return false;
+    }
     FlatFilePos undo_pos_old(block_file, m_blockfile_info[block_file].nUndoSize);
     if (!UndoFileSeq().Flush(undo_pos_old, finalize)) {
         m_opts.notifications.flushError("Flushing undo file to disk failed. This is likely the result of an I/O error.");
@@ -803,6 +1001,8 @@ uint64_t BlockManager::CalculateCurrentUsage()
 
 void BlockManager::UnlinkPrunedFiles(const std::set<int>& setFilesToPrune) const
 {
+    // Do not let queued undo data recreate a removed file
+    m_undo_writer.Wait();
     std::error_code ec;
     for (std::set<int>::iterator it = setFilesToPrune.begin(); it != setFilesToPrune.end(); ++it) {
         FlatFilePos pos(*it, 0);
@@ -992,11 +1192,20 @@ bool BlockManager::WriteUndoDataForBlock(const CBlockUndo& blockundo, BlockValid
 
     // Write undo information to disk
     if (block.GetUndoPos().IsNull()) {
+        // Serialize here and leave the disk write to the undo writer
+        std::vector<uint8_t> undo_data;
+        if (m_opts.compact_undo) {
+            VectorWriter{undo_data, 0} << CompactBlockUndo{blockundo, block.nHeight};
+        } else {
+            undo_data.reserve(::GetSerializeSize(blockundo));
+            VectorWriter{undo_data, 0} << blockundo;
+        }
         FlatFilePos _pos;
-        if (!FindUndoPos(state, block.nFile, _pos, ::GetSerializeSize(blockundo) + 40)) {
+        if (!FindUndoPos(state, block.nFile, _pos, undo_data.size() + 40)) {
             return error("ConnectBlock(): FindUndoPos failed");
         }
-        if (!UndoWriteToDisk(blockundo, _pos, block.pprev->GetBlockHash())) {
+        _pos.nPos += BLOCK_SERIALIZATION_HEADER_SIZE;
+        if (!m_undo_writer.Write(_pos, block.pprev->GetBlockHash(), std::move(undo_data))) {
             return FatalError(m_opts.notifications, state, "Failed to write undo data");
         }
         // rev files are written in block height order, whereas blk files are written as blocks come in (often out of order)
@@ -1019,6 +1228,7 @@ bool BlockManager::WriteUndoDataForBlock(const CBlockUndo& blockundo, BlockValid
         // update nUndoPos in block index
         block.nUndoPos = _pos.nPos;
         block.nStatus |= BLOCK_HAVE_UNDO;
+        if (m_opts.compact_undo) block.nStatus |= BLOCK_UNDO_COMPACT;
         m_dirty_blockindex.insert(&block);
     }
 
@@ -1099,6 +1309,27 @@ bool BlockManager::ReadRawBlockFromDisk(std::vector<uint8_t>& block, const FlatF
     return true;
 }
 
+std::shared_ptr<const CBlock> BlockManager::ReadBlockCached(const CBlockIndex& index) const
+{
+    const uint256 hash{index.GetBlockHash()};
+    if (auto block{m_block_cache.GetBlock(hash)}) return block;
+    auto block{std::make_shared<CBlock>()};
+    if (!ReadBlockFromDisk(*block, index)) return nullptr;
+    m_block_cache.PutBlock(hash, block);
+    return block;
+}
+
+std::shared_ptr<const std::vector<uint8_t>> BlockManager::ReadRawBlockCached(const CBlockIndex& index) const
+{
+    const uint256 hash{index.GetBlockHash()};
+    if (auto block{m_block_cache.GetRawBlock(hash)}) return block;
+    const FlatFilePos block_pos{WITH_LOCK(cs_main, return index.GetBlockPos())};
+    auto block{std::make_shared<std::vector<uint8_t>>()};
+    if (!ReadRawBlockFromDisk(*block, block_pos)) return nullptr;
+    m_block_cache.PutRawBlock(hash, block);
+    return block;
+}
+
 FlatFilePos BlockManager::SaveBlockToDisk(const CBlock& block, int nHeight, const FlatFilePos* dbp)
 {
     unsigned int nBlockSize = ::GetSerializeSize(TX_WITH_WITNESS(block));
@@ -23,14 +23,18 @@
 
 #include <array>
 #include <atomic>
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
 #include <functional>
 #include <limits>
+#include <list>
 #include <map>
 #include <memory>
 #include <optional>
 #include <set>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -59,13 +63,14 @@ public:
     void ReadReindexing(bool& fReindexing);
     bool WriteFlag(const std::string& name, bool fValue);
     bool ReadFlag(const std::string& name, bool& fValue);
-    bool LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex, const util::SignalInterrupt& interrupt)
+    bool LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex, const util::SignalInterrupt& interrupt, CheckPowOnLoad check_pow = CheckPowOnLoad::CACHED)
         EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
 };
 } // namespace kernel
 
 namespace node {
 using kernel::BlockTreeDB;
+using kernel::CheckPowOnLoad;
 
 /** The pre-allocation chunk size for blk?????.dat files (since 0.8) */
 static const unsigned int BLOCKFILE_CHUNK_SIZE = 0x1000000; // 16 MiB
@@ -126,6 +131,136 @@ struct BlockfileCursor {
 
 std::ostream& operator<<(std::ostream& os, const BlockfileCursor& cursor);
 
+/**
+ * Writes undo data to rev?????.dat files on a background thread, so that
+ * connecting a block does not wait for the write.
+ *
+ * Undo data is serialized and its space in the undo file is allocated before
+ * it is queued. Queued undo data can be read back with GetQueued() until it
+ * has been written.
+ */
+class UndoWriter
+{
+public:
+    //! Limit on the undo data waiting to be written. Write() blocks while it is reached.
+    static constexpr size_t MAX_QUEUED_BYTES{32 << 20};
+
+    UndoWriter(FlatFileSeq seq, const MessageStartChars& message_start, kernel::Notifications& notifications)
+        : m_seq{std::move(seq)}, m_message_start{message_start}, m_notifications{notifications} {}
+    ~UndoWriter();
+
+    /**
+     * Queue serialized undo data to be written, with its header and checksum,
+     * to the space allocated in front of pos.
+     *
+     * @param[in] pos        Position of the undo data, after its header
+     * @param[in] prev_hash  Hash of the previous block, which is part of the checksum
+     * @param[in] data       Serialized undo data
+     * @returns false if an earlier write failed.
+     */
+    bool Write(const FlatFilePos& pos, const uint256& prev_hash, std::vector<uint8_t>&& data) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /**
+     * Wait for all queued undo data to be written.
+     *
+     * @returns false if a write failed.
+     */
+    bool Wait() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    //! The serialized undo data at pos, if it has not been written yet.
+    std::optional<std::vector<uint8_t>> GetQueued(const FlatFilePos& pos) const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    struct Job {
+        FlatFilePos pos;
+        uint256 prev_hash;
+        std::vector<uint8_t> data;
+    };
+
+    void ThreadWrite() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    bool WriteToDisk(const Job& job);
+
+    FlatFileSeq m_seq;
+    const MessageStartChars m_message_start;
+    kernel::Notifications& m_notifications;
+
+    mutable Mutex m_mutex;
+    mutable std::condition_variable m_cond;
+    //! Undo data waiting to be written. The front job stays queued while it is written.
+    std::deque<Job> m_queue GUARDED_BY(m_mutex);
+    size_t m_queued_bytes GUARDED_BY(m_mutex){0};
+    bool m_failed GUARDED_BY(m_mutex){false};
+    bool m_stop GUARDED_BY(m_mutex){false};
+    std::thread m_thread;
+};
+
+/**
+ * Size-bounded LRU cache of recently served blocks, both deserialized and in
+ * their serialized form, keyed by block hash.
+ *
+ * Peers syncing from us, REST and RPC clients and ZMQ subscribers tend to ask
+ * for the same recent blocks. The cache lets them share one disk read. It is
+ * split into shards by hash, each with its own lock and LRU order, so that
+ * concurrent lookups of different blocks rarely wait on each other. Blocks
+ * never change once stored, so entries don't need to be invalidated.
+ */
+class BlockCache
+{
+public:
+    static constexpr size_t SHARDS{8};
+
+    struct Stats {
+        uint64_t hits;
+        uint64_t misses;
+        size_t blocks;
+        size_t bytes;
+        size_t max_bytes;
+    };
+
+    explicit BlockCache(size_t max_bytes) : m_shard_max_bytes{max_bytes / SHARDS} {}
+
+    bool Enabled() const { return m_shard_max_bytes > 0; }
+
+    //! The cached block, or nullptr. Counts a hit or a miss.
+    std::shared_ptr<const CBlock> GetBlock(const uint256& hash);
+    //! The cached serialized block, or nullptr. Counts a hit or a miss.
+    std::shared_ptr<const std::vector<uint8_t>> GetRawBlock(const uint256& hash);
+
+    //! Add a block, evicting the least recently used ones of its shard to stay within the limit.
+    void PutBlock(const uint256& hash, std::shared_ptr<const CBlock> block);
+    //! Add a serialized block, evicting the least recently used ones of its shard to stay within the limit.
+    void PutRawBlock(const uint256& hash, std::shared_ptr<const std::vector<uint8_t>> block);
+
+    Stats GetStats() const;
+
+private:
+    struct Entry {
+        uint256 hash;
+        std::shared_ptr<const CBlock> block;
+        std::shared_ptr<const std::vector<uint8_t>> raw;
+        size_t bytes{0};
+    };
+
+    struct Shard {
+        mutable Mutex m_mutex;
+        //! Most recently used entry first
+        std::list<Entry> m_lru GUARDED_BY(m_mutex);
+        std::unordered_map<uint256, std::list<Entry>::iterator, BlockHasher> m_entries GUARDED_BY(m_mutex);
+        size_t m_bytes GUARDED_BY(m_mutex){0};
+    };
+
+    Shard& GetShard(const uint256& hash);
+    template <typename T>
+    std::shared_ptr<const T> Get(const uint256& hash, std::shared_ptr<const T> Entry::*member);
+    template <typename T>
+    void Put(const uint256& hash, std::shared_ptr<const T> Entry::*member, std::shared_ptr<const T> value, size_t bytes);
+
+    const size_t m_shard_max_bytes;
+    std::array<Shard, SHARDS> m_shards;
+    std::atomic<uint64_t> m_hits{0};
+    std::atomic<uint64_t> m_misses{0};
+};
+
 
 /**
  * Maintains a tree of blocks (stored in `m_block_index`) which is consulted
@@ -166,7 +301,6 @@ private:
     AutoFile OpenUndoFile(const FlatFilePos& pos, bool fReadOnly = false) const;
 
     bool WriteBlockToDisk(const CBlock& block, FlatFilePos& pos) const;
-    bool UndoWriteToDisk(const CBlockUndo& blockundo, FlatFilePos& pos, const uint256& hashBlock) const;
 
     /* Calculate the block/rev files to delete based on height specified by user with RPC command pruneblockchain */
     void FindFilesToPruneManual(
@@ -249,12 +383,21 @@ private:
 
     const kernel::BlockManagerOpts m_opts;
 
+    //! Writes undo data of connected blocks. Must be waited for before the
+    //! undo files are flushed or removed and before the block index is written.
+    UndoWriter m_undo_writer;
+
+    //! Recently served blocks
+    mutable BlockCache m_block_cache;
+
 public:
     using Options = kernel::BlockManagerOpts;
 
     explicit BlockManager(const util::SignalInterrupt& interrupt, Options opts)
         : m_prune_mode{opts.prune_target > 0},
           m_opts{std::move(opts)},
+          m_undo_writer{UndoFileSeq(), m_opts.chainparams.MessageStart(), m_opts.notifications},
+          m_block_cache{m_opts.block_cache_size},
           m_interrupt{interrupt} {};
 
     const util::SignalInterrupt& m_interrupt;
@@ -366,6 +509,19 @@ public:
     bool ReadBlockFromDisk(CBlock& block, const CBlockIndex& index) const;
     bool ReadRawBlockFromDisk(std::vector<uint8_t>& block, const FlatFilePos& pos) const;
 
+    /**
+     * Read a block through the block cache, for serving it to peers and
+     * clients. Validation and indexes read from disk directly, so that they
+     * don't push the blocks being served out of the cache.
+     *
+     * @returns nullptr if the block could not be read.
+     */
+    std::shared_ptr<const CBlock> ReadBlockCached(const CBlockIndex& index) const;
+    //! Like ReadBlockCached(), but for the block serialized as stored on disk.
+    std::shared_ptr<const std::vector<uint8_t>> ReadRawBlockCached(const CBlockIndex& index) const;
+
+    BlockCache::Stats GetBlockCacheStats() const { return m_block_cache.GetStats(); }
+
     bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex& index) const;
 
     void CleanupBlockRevFiles() const;
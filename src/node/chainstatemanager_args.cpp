@@ -20,6 +20,7 @@
 
 #include <algorithm>
 #include <chrono>
+#include <limits>
 #include <string>
 
 namespace node {
@@ -40,6 +41,17 @@ util::Result<void> ApplyArgsManOptions(const ArgsManager& args, ChainstateManage
 
     if (auto value{args.GetIntArg("-maxtipage")}) opts.max_tip_age = std::chrono::seconds{*value};
 
+    if (auto value{args.GetIntArg("-epochprefetch")}) {
+        if (*value < 0) {
+            return util::Error{strprintf(Untranslated("Invalid negative -epochprefetch value %d"), *value)};
+        }
+        opts.epoch_prefetch_blocks = static_cast<int>(std::min<int64_t>(*value, std::numeric_limits<int>::max()));
+    }
+
+    opts.background_flush = args.GetBoolArg("-backgroundflush", DEFAULT_BACKGROUND_FLUSH);
+    opts.partial_flush = args.GetBoolArg("-partialflush", DEFAULT_PARTIAL_FLUSH);
+    opts.pipelined_connect = args.GetBoolArg("-pipelinedconnect", DEFAULT_PIPELINED_CONNECT);
+
     ReadDatabaseArgs(args, opts.block_tree_db);
     ReadDatabaseArgs(args, opts.coins_db);
     ReadCoinsViewArgs(args, opts.coins_view);
@@ -20,6 +20,8 @@ static constexpr bool DEFAULT_PERSIST_MEMPOOL{true};
 
 bool ShouldPersistMempool(const ArgsManager& argsman);
 fs::path MempoolPath(const ArgsManager& argsman);
+/** Path of the signature and script-execution caches saved with the mempool. */
+fs::path ValidationCachePath(const ArgsManager& argsman);
 
 } // namespace node
 
@@ -10,22 +10,36 @@
 #include <chainparams.h>
 #include <coins.h>
 #include <common/args.h>
+#include <common/system.h>
 #include <consensus/amount.h>
 #include <consensus/consensus.h>
 #include <consensus/merkle.h>
 #include <consensus/tx_verify.h>
 #include <consensus/validation.h>
+#include <crypto/ethash/include/ethash/progpow.hpp>
 #include <deploymentstatus.h>
+#include <hash.h>
 #include <logging.h>
 #include <policy/feerate.h>
 #include <policy/policy.h>
 #include <pow.h>
 #include <primitives/transaction.h>
+#include <sync.h>
+#include <util/fs.h>
+#include <util/fs_helpers.h>
 #include <util/moneystr.h>
+#include <util/signalinterrupt.h>
+#include <util/strencodings.h>
+#include <util/thread.h>
+#include <util/threadnames.h>
 #include <util/time.h>
+#include <util/translation.h>
 #include <validation.h>
 
 #include <algorithm>
+#include <atomic>
+#include <limits>
+#include <thread>
 #include <utility>
 
 namespace node {
@@ -73,6 +87,138 @@ BlockAssembler::BlockAssembler(Chainstate& chainstate, const CTxMemPool* mempool
 {
 }
 
+/** Number of consecutive nonces a SolveBlock() worker claims at a time. */
+static constexpr uint64_t SOLVE_BATCH_SIZE{8};
+
+/** How many blocks before an epoch boundary SolveBlock() starts building the next epoch's dataset. */
+static constexpr int DATASET_PREPARE_BLOCKS{500};
+
+/** Hash rate of the last SolveBlock() call, negative if there was none. */
+static std::atomic<double> g_last_solve_hash_rate{-1.0};
+
+bool SolveBlock(CBlockHeader& block, const Consensus::Params& params, unsigned int threads, uint64_t& max_tries, const util::SignalInterrupt& interrupt)
+{
+    const uint64_t start_nonce{block.nNonce};
+    const uint64_t num_nonces{std::min(max_tries, std::numeric_limits<uint64_t>::max() - start_nonce)};
+
+    const auto boundary{GetProofOfWorkBoundary(block.nBits, params)};
+    if (!boundary) {
+        // No hash satisfies an invalid target.
+        max_tries -= num_nonces;
+        block.nNonce = start_nonce + num_nonces;
+        return false;
+    }
+
+    // The full dataset may fail to allocate, in which case the dataset items
+    // are computed from the light cache for every hash.
+    const int epoch_number{ethash::get_epoch_number(block.nHeight)};
+    if (block.nHeight % KAWPOW_EPOCH_LENGTH >= KAWPOW_EPOCH_LENGTH - DATASET_PREPARE_BLOCKS) {
+        ethash::prepare_global_epoch_context_full(epoch_number + 1);
+    }
+    const ethash::epoch_context_full* full_context{ethash_get_global_epoch_context_full(epoch_number)};
+    const ethash::epoch_context* light_context{full_context ? nullptr : &ethash::get_global_epoch_context(epoch_number)};
+
+    const ethash::hash256 header_hash{ToEthashHash(block.GetHeaderHash())};
+    const ethash::hash256 target{ToEthashHash(*boundary)};
+
+    // Workers claim nonces by their offset from start_nonce until a solution
+    // below the claimed offset is known, so every nonce below the returned
+    // solution has been tried.
+    std::atomic<uint64_t> next_offset{0};
+    std::atomic<uint64_t> solution_offset{num_nonces};
+    std::atomic<uint64_t> hashes{0};
+    Mutex solution_mutex;
+    ethash::hash256 solution_mix;
+
+    const auto worker = [&] {
+        while (!interrupt) {
+            const uint64_t offset{next_offset.fetch_add(SOLVE_BATCH_SIZE)};
+            if (offset >= solution_offset) break;
+            const uint64_t iterations{std::min(SOLVE_BATCH_SIZE, num_nonces - offset)};
+            const ethash::search_result result{full_context ?
+                progpow::search(*full_context, block.nHeight, header_hash, target, start_nonce + offset, iterations) :
+                progpow::search_light(*light_context, block.nHeight, header_hash, target, start_nonce + offset, iterations)};
+            if (!result.solution_found) {
+                hashes += iterations;
+                continue;
+            }
+            const uint64_t found_offset{result.nonce - start_nonce};
+            hashes += found_offset - offset + 1;
+            LOCK(solution_mutex);
+            if (found_offset < solution_offset) {
+                solution_offset = found_offset;
+                solution_mix = result.hashMix;
+            }
+            break;
+        }
+    };
+
+    const auto start_time{SteadyClock::now()};
+    if (threads <= 1) {
+        worker();
+    } else {
+        std::vector<std::thread> workers;
+        workers.reserve(threads);
+        for (unsigned int n = 0; n < threads; ++n) {
+            workers.emplace_back([&worker, n] {
+                util::ThreadRename(strprintf("miner.%i", n));
+                worker();
+            });
+        }
+        for (std::thread& t : workers) {
+            t.join();
+        }
+    }
+    const auto elapsed{Ticks<SecondsDouble>(SteadyClock::now() - start_time)};
+    if (elapsed > 0) {
+        g_last_solve_hash_rate = hashes / elapsed;
+        LogDebug(BCLog::BENCH, "Tried %u nonces in %.2fms (%.2f H/s, %u threads)\n",
+                 hashes.load(), elapsed * 1000, g_last_solve_hash_rate.load(), std::max(threads, 1U));
+    }
+
+    if (solution_offset < num_nonces) {
+        max_tries -= solution_offset;
+        block.nNonce = start_nonce + solution_offset;
+        LOCK(solution_mutex);
+        block.hashMix = FromEthashHash(solution_mix);
+        return true;
+    }
+
+    const uint64_t tried{std::min(next_offset.load(), num_nonces)};
+    max_tries -= tried;
+    block.nNonce = start_nonce + tried;
+    return false;
+}
+
+std::optional<double> GetLastSolveHashRate()
+{
+    const double rate{g_last_solve_hash_rate};
+    if (rate < 0) return std::nullopt;
+    return rate;
+}
+
+util::Result<void> ApplyDatasetOptions(const ArgsManager& args)
+{
+    const std::string mode{args.GetArg("-dag", DEFAULT_DAG_MODE)};
+    const unsigned int num_threads = std::max(GetNumCores(), 1);
+    if (mode == "lazy") {
+        ethash::set_global_full_dataset_options(ETHASH_FULL_DATASET_LAZY, nullptr, num_threads);
+    } else if (mode == "memory") {
+        ethash::set_global_full_dataset_options(ETHASH_FULL_DATASET_MEMORY, nullptr, num_threads);
+    } else if (mode == "file") {
+        const fs::path dir{args.GetDataDirNet() / "dag"};
+        try {
+            TryCreateDirectories(dir);
+        } catch (const fs::filesystem_error& e) {
+            return util::Error{strprintf(_("Unable to create the dataset directory %s: %s"), fs::quoted(fs::PathToString(dir)), e.what())};
+        }
+        ethash::set_global_full_dataset_options(ETHASH_FULL_DATASET_FILE, fs::PathToString(dir).c_str(), num_threads);
+    } else {
+        return util::Error{strprintf(_("Invalid -dag value '%s' (must be lazy, memory or file)."), mode)};
+    }
+    return {};
+}
+
 void ApplyArgsManOptions(const ArgsManager& args, BlockAssembler::Options& options)
 {
     // Block resource limits
@@ -171,9 +317,11 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     pblock->nNonce         = 0;
     pblocktemplate->vTxSigOpsCost[0] = WITNESS_SCALE_FACTOR * GetLegacySigOpCount(*pblock->vtx[0]);
 
+    // The transactions were selected from the mempool, so their scripts do not
+    // have to be checked again.
     BlockValidationState state;
     if (m_options.test_block_validity && !TestBlockValidity(state, chainparams, m_chainstate, *pblock, pindexPrev,
-                                                            /*fCheckPOW=*/false, /*fCheckMerkleRoot=*/false)) {
+                                                            /*fCheckPOW=*/false, /*fCheckMerkleRoot=*/false, m_mempool)) {
         throw std::runtime_error(strprintf("%s: TestBlockValidity failed: %s", __func__, state.ToString()));
     }
     const auto time_2{SteadyClock::now()};
@@ -10,6 +10,7 @@
 #include <policy/policy.h>
 #include <primitives/block.h>
 #include <txmempool.h>
+#include <util/result.h>
 
 #include <memory>
 #include <optional>
@@ -29,9 +30,16 @@ class Chainstate;
 class ChainstateManager;
 
 namespace Consensus { struct Params; };
+namespace util { class SignalInterrupt; };
 
 namespace node {
 static const bool DEFAULT_PRINTPRIORITY = false;
+/** Default for -minerthreads, the number of threads used to solve generated blocks */
+static const int DEFAULT_MINER_THREADS = 1;
+/** Maximum number of threads used to solve generated blocks */
+static const int MAX_MINER_THREADS = 64;
+/** Default for -dag, how the ProgPoW dataset used to solve blocks is built */
+static const char* const DEFAULT_DAG_MODE = "lazy";
 
 struct CBlockTemplate
 {
@@ -205,6 +213,37 @@ int64_t UpdateTime(CBlockHeader* pblock, const Consensus::Params& consensusParam
 /** Update an old GenerateCoinbaseCommitment from CreateNewBlock after the block txs have changed */
 void RegenerateCommitments(CBlock& block, ChainstateManager& chainman);
 
+/**
+ * Search for a nonce that satisfies the proof-of-work of a block, starting at
+ * its current nNonce.
+ *
+ * The search uses the full ProgPoW dataset of the block's epoch, which is
+ * shared between calls and built as configured by ApplyDatasetOptions().
+ * Near the end of an epoch, the dataset of the next one is built in the
+ * background. The nonces are handed out to
+ * `threads` worker threads in small groups. The lowest solving nonce is
+ * returned, so the result does not depend on the number of threads.
+ *
+ * At most max_tries nonces are tried, and the search stops early if
+ * interrupted. max_tries is decreased by the number of nonces tried before
+ * the solution.
+ *
+ * @returns true and sets nNonce and hashMix of the block if a solution was
+ *          found. Otherwise, nNonce is set past the last nonce tried.
+ */
+bool SolveBlock(CBlockHeader& block, const Consensus::Params& params, unsigned int threads, uint64_t& max_tries, const util::SignalInterrupt& interrupt);
+
+/** Hashes per second measured by the last SolveBlock() call, if any. */
+std::optional<double> GetLastSolveHashRate();
+
+/**
+ * Apply the -dag option to the global ProgPoW dataset: "lazy" generates the
+ * items when first hit, "memory" generates the whole dataset on all cores
+ * first, and "file" additionally keeps it in the "dag" directory of the
+ * datadir to be mapped by later runs and other processes.
+ */
+[[nodiscard]] util::Result<void> ApplyDatasetOptions(const ArgsManager& args);
+
 /** Apply -blockmintxfee and -blockmaxweight options from ArgsManager to BlockAssembler options. */
 void ApplyArgsManOptions(const ArgsManager& gArgs, BlockAssembler::Options& options);
 } // namespace node
@@ -0,0 +1 @@
+#define BUILD_GIT_COMMIT "df22a61bf294-dirty"
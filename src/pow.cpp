@@ -8,9 +8,12 @@
 
 #include <arith_uint256.h>
 #include <chain.h>
+#include <hash.h>
 #include <primitives/block.h>
 #include <uint256.h>
 
+#include <optional>
+
 unsigned int GetNextWorkRequired(const CBlockIndex* pindexLast, const CBlockHeader *pblock, const Consensus::Params& params)
 {
     assert(pindexLast != nullptr);
@@ -103,7 +106,8 @@ bool PermittedDifficultyTransition(const Consensus::Params& params, uint32_t old
     return true;
 }
 
-bool CheckProofOfWork(uint256 hash, unsigned int nBits, const Consensus::Params& params)
+/** Return the target specified by nBits, or nullopt if it is out of range. */
+static std::optional<arith_uint256> DeriveTarget(unsigned int nBits, const uint256& pow_limit)
 {
     bool fNegative;
     bool fOverflow;
@@ -112,12 +116,37 @@ bool CheckProofOfWork(uint256 hash, unsigned int nBits, const Consensus::Params&
     bnTarget.SetCompact(nBits, &fNegative, &fOverflow);
 
     // Check range
-    if (fNegative || bnTarget == 0 || fOverflow || bnTarget > UintToArith256(params.powLimit))
+    if (fNegative || bnTarget == 0 || fOverflow || bnTarget > UintToArith256(pow_limit))
+        return std::nullopt;
+
+    return bnTarget;
+}
+
+std::optional<uint256> GetProofOfWorkBoundary(unsigned int nBits, const Consensus::Params& params)
+{
+    const auto bnTarget{DeriveTarget(nBits, params.powLimit)};
+    if (!bnTarget) return std::nullopt;
+    return ArithToUint256(*bnTarget);
+}
+
+bool CheckProofOfWork(uint256 hash, unsigned int nBits, const Consensus::Params& params)
+{
+    const auto bnTarget{DeriveTarget(nBits, params.powLimit)};
+    if (!bnTarget)
         return false;
 
     // Check proof of work matches claimed amount
-    if (UintToArith256(hash) > bnTarget)
+    if (UintToArith256(hash) > *bnTarget)
         return false;
 
     return true;
 }
+
+bool CheckProofOfWorkMix(const CBlockHeader& block, const Consensus::Params& params)
+{
+    const auto bnTarget{DeriveTarget(block.nBits, params.powLimit)};
+    if (!bnTarget)
+        return false;
+
+    return ETHashVerify(block, ArithToUint256(*bnTarget));
+}
@@ -8,12 +8,13 @@
 #define GRIFFION_POW_H
 
 #include <consensus/params.h>
+#include <uint256.h>
 
+#include <optional>
 #include <stdint.h>
 
 class CBlockHeader;
 class CBlockIndex;
-class uint256;
 
 unsigned int GetNextWorkRequired(const CBlockIndex* pindexLast, const CBlockHeader *pblock, const Consensus::Params&);
 unsigned int CalculateNextWorkRequired(const CBlockIndex* pindexLast, const Consensus::Params& params);
@@ -21,6 +22,20 @@ unsigned int CalculateNextWorkRequired(const CBlockIndex* pindexLast, const Cons
 /** Check whether a block hash satisfies the proof-of-work requirement specified by nBits */
 bool CheckProofOfWork(uint256 hash, unsigned int nBits, const Consensus::Params&);
 
+/**
+ * Return the target specified by nBits as the largest hash that satisfies it,
+ * or nullopt if nBits is out of range.
+ */
+std::optional<uint256> GetProofOfWorkBoundary(unsigned int nBits, const Consensus::Params&);
+
+/**
+ * Check whether the claimed hashMix of a block header is correct and its final
+ * hash satisfies the proof-of-work requirement specified by nBits. Headers
+ * whose final hash misses the target are rejected before the ProgPoW mix is
+ * computed.
+ */
+bool CheckProofOfWorkMix(const CBlockHeader& block, const Consensus::Params&);
+
 /**
  * Return false if the proof-of-work requirement specified by new_nbits at a
  * given height is not possible, given the proof-of-work on the prior block as
@@ -226,6 +226,70 @@ bool XOnlyPubKey::VerifySchnorr(const uint256& msg, Span<const unsigned char> si
     return secp256k1_schnorrsig_verify(secp256k1_context_static, sigbytes.data(), msg.begin(), 32, &pubkey);
 }
 
+namespace {
+/** Scratch space for the multi-scalar multiplication of batch verification. */
+class SchnorrBatchScratch
+{
+    secp256k1_scratch_space* m_scratch;
+
+public:
+    //! Enough for Pippenger's algorithm on a full batch.
+    static constexpr size_t SIZE{1 << 20};
+
+    SchnorrBatchScratch() : m_scratch{secp256k1_scratch_space_create(secp256k1_context_static, SIZE)} {}
+    ~SchnorrBatchScratch() { secp256k1_scratch_space_destroy(secp256k1_context_static, m_scratch); }
+    SchnorrBatchScratch(const SchnorrBatchScratch&) = delete;
+    SchnorrBatchScratch& operator=(const SchnorrBatchScratch&) = delete;
+
+    secp256k1_scratch_space* get() const { return m_scratch; }
+};
+} // namespace
+
+void SchnorrSignatureBatch::Add(const XOnlyPubKey& pubkey, const uint256& msg, Span<const unsigned char> sig)
+{
+    assert(sig.size() == 64);
+    Entry& entry{m_entries.emplace_back(Entry{pubkey, msg, {}})};
+    std::copy(sig.begin(), sig.end(), entry.sig.begin());
+    if (m_entries.size() >= MAX_SIZE) {
+        m_valid = m_valid && VerifyEntries();
+        m_entries.clear();
+    }
+}
+
+bool SchnorrSignatureBatch::Verify()
+{
+    const bool valid{m_valid && VerifyEntries()};
+    m_entries.clear();
+    m_valid = true;
+    return valid;
+}
+
+bool SchnorrSignatureBatch::VerifyEntries() const
+{
+    if (m_entries.empty()) return true;
+    // The scratch space is reused by all batches verified on a thread.
+    thread_local SchnorrBatchScratch scratch;
+    std::vector<secp256k1_xonly_pubkey> pubkeys(m_entries.size());
+    std::vector<const secp256k1_xonly_pubkey*> pubkey_ptrs(m_entries.size());
+    std::vector<const unsigned char*> msg_ptrs(m_entries.size());
+    std::vector<const unsigned char*> sig_ptrs(m_entries.size());
+    for (size_t i = 0; i < m_entries.size(); ++i) {
+        if (!secp256k1_xonly_pubkey_parse(secp256k1_context_static, &pubkeys[i], m_entries[i].pubkey.data())) return false;
+        pubkey_ptrs[i] = &pubkeys[i];
+        msg_ptrs[i] = m_entries[i].msg.begin();
+        sig_ptrs[i] = m_entries[i].sig.data();
+    }
+    if (secp256k1_schnorrsig_verify_batch(secp256k1_context_static, scratch.get(), sig_ptrs.data(), msg_ptrs.data(), pubkey_ptrs.data(), m_entries.size())) {
+        return true;
+    }
+    // A failed batch only means that some signature is invalid. Verify them
+    // one by one, so that the outcome never differs from that of
+    // XOnlyPubKey::VerifySchnorr().
+    return std::all_of(m_entries.begin(), m_entries.end(), [](const Entry& entry) {
+        return entry.pubkey.VerifySchnorr(entry.msg, entry.sig);
+    });
+}
+
 static const HashWriter HASHER_TAPTWEAK{TaggedHash("TapTweak")};
 
 uint256 XOnlyPubKey::ComputeTapTweakHash(const uint256* merkle_root) const
@@ -13,6 +13,7 @@
 #include <span.h>
 #include <uint256.h>
 
+#include <array>
 #include <cstring>
 #include <optional>
 #include <vector>
@@ -301,6 +302,37 @@ public:
     SERIALIZE_METHODS(XOnlyPubKey, obj) { READWRITE(obj.m_keydata); }
 };
 
+/** Schnorr signatures that are verified together, which takes less time than
+ *  verifying them one by one. */
+class SchnorrSignatureBatch
+{
+private:
+    struct Entry {
+        XOnlyPubKey pubkey;
+        uint256 msg;
+        std::array<unsigned char, 64> sig;
+    };
+
+    std::vector<Entry> m_entries;
+    //! Whether the signatures verified so far were all valid.
+    bool m_valid{true};
+
+    bool VerifyEntries() const;
+
+public:
+    //! Number of signatures after which the batch is verified right away, to bound its memory.
+    static constexpr size_t MAX_SIZE{1024};
+
+    /** Add a signature to verify against pubkey. sig must be exactly 64 bytes. */
+    void Add(const XOnlyPubKey& pubkey, const uint256& msg, Span<const unsigned char> sig);
+
+    /** Verify the signatures added since the last call, and return whether
+     *  they were all valid. Leaves the batch empty. */
+    bool Verify();
+
+    size_t size() const { return m_entries.size(); }
+};
+
 /** An ElligatorSwift-encoded public key. */
 struct EllSwiftPubKey
 {
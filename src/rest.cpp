@@ -296,7 +296,6 @@ static bool rest_block(const std::any& context,
     if (!ParseHashStr(hashStr, hash))
         return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + hashStr);
 
-    CBlock block;
     const CBlockIndex* pblockindex = nullptr;
     const CBlockIndex* tip = nullptr;
     ChainstateManager* maybe_chainman = GetChainman(context, req);
@@ -314,31 +313,36 @@ static bool rest_block(const std::any& context,
         }
     }
 
-    if (!chainman.m_blockman.ReadBlockFromDisk(block, *pblockindex)) {
-        return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
-    }
-
     switch (rf) {
     case RESTResponseFormat::BINARY: {
-        DataStream ssBlock;
-        ssBlock << TX_WITH_WITNESS(block);
-        std::string binaryBlock = ssBlock.str();
+        // The serialization on disk is what is asked for, so there is no need to
+        // deserialize the block and serialize it again.
+        auto block_data{chainman.m_blockman.ReadRawBlockCached(*pblockindex)};
+        if (!block_data) {
+            return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+        }
         req->WriteHeader("Content-Type", "application/octet-stream");
-        req->WriteReply(HTTP_OK, binaryBlock);
+        req->WriteReply(HTTP_OK, std::move(block_data));
         return true;
     }
 
     case RESTResponseFormat::HEX: {
-        DataStream ssBlock;
-        ssBlock << TX_WITH_WITNESS(block);
-        std::string strHex = HexStr(ssBlock) + "\n";
+        const auto block_data{chainman.m_blockman.ReadRawBlockCached(*pblockindex)};
+        if (!block_data) {
+            return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+        }
+        std::string strHex = HexStr(*block_data) + "\n";
         req->WriteHeader("Content-Type", "text/plain");
         req->WriteReply(HTTP_OK, strHex);
         return true;
     }
 
     case RESTResponseFormat::JSON: {
-        UniValue objBlock = blockToJSON(chainman.m_blockman, block, *tip, *pblockindex, tx_verbosity);
+        const auto block{chainman.m_blockman.ReadBlockCached(*pblockindex)};
+        if (!block) {
+            return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+        }
+        UniValue objBlock = blockToJSON(chainman.m_blockman, *block, *tip, *pblockindex, tx_verbosity);
         std::string strJSON = objBlock.write() + "\n";
         req->WriteHeader("Content-Type", "application/json");
         req->WriteReply(HTTP_OK, strJSON);
@@ -734,15 +734,24 @@ static RPCHelpMan getblock()
         if (!pblockindex) {
             throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
         }
+        if (chainman.m_blockman.IsBlockPruned(*pblockindex)) {
+            throw JSONRPCError(RPC_MISC_ERROR, "Block not available (pruned data)");
+        }
     }
 
-    const CBlock block{GetBlockChecked(chainman.m_blockman, *pblockindex)};
-
+    // Read through the cache of recently served blocks, like peers and REST
+    // clients do. The errors are the same as in GetBlockChecked().
     if (verbosity <= 0) {
-        DataStream ssBlock;
-        ssBlock << TX_WITH_WITNESS(block);
-        std::string strHex = HexStr(ssBlock);
-        return strHex;
+        const auto block_data{chainman.m_blockman.ReadRawBlockCached(*pblockindex)};
+        if (!block_data) {
+            throw JSONRPCError(RPC_MISC_ERROR, "Block not found on disk");
+        }
+        return HexStr(*block_data);
+    }
+
+    const auto block{chainman.m_blockman.ReadBlockCached(*pblockindex)};
+    if (!block) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Block not found on disk");
     }
 
     TxVerbosity tx_verbosity;
@@ -754,7 +763,7 @@ static RPCHelpMan getblock()
         tx_verbosity = TxVerbosity::SHOW_DETAILS_AND_PREVOUT;
     }
 
-    return blockToJSON(chainman.m_blockman, block, *tip, *pblockindex, tx_verbosity);
+    return blockToJSON(chainman.m_blockman, *block, *tip, *pblockindex, tx_verbosity);
 },
     };
 }
@@ -35,8 +35,10 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "utxoupdatepsbt", 1, "descriptors" },
     { "generatetoaddress", 0, "nblocks" },
     { "generatetoaddress", 2, "maxtries" },
+    { "generatetoaddress", 3, "threads" },
     { "generatetodescriptor", 0, "num_blocks" },
     { "generatetodescriptor", 2, "maxtries" },
+    { "generatetodescriptor", 3, "threads" },
     { "generateblock", 1, "transactions" },
     { "generateblock", 2, "submit" },
     { "getnetworkhashps", 0, "nblocks" },
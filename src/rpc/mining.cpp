@@ -10,6 +10,7 @@
 
 #include <chain.h>
 #include <chainparams.h>
+#include <common/args.h>
 #include <common/system.h>
 #include <consensus/amount.h>
 #include <consensus/consensus.h>
@@ -48,7 +49,11 @@
 using node::BlockAssembler;
 using node::CBlockTemplate;
 using node::NodeContext;
+using node::DEFAULT_MINER_THREADS;
+using node::MAX_MINER_THREADS;
+using node::GetLastSolveHashRate;
 using node::RegenerateCommitments;
+using node::SolveBlock;
 using node::UpdateTime;
 
 /**
@@ -128,24 +133,30 @@ static RPCHelpMan getnetworkhashps()
     };
 }
 
-static bool GenerateBlock(ChainstateManager& chainman, CBlock& block, uint64_t& max_tries, std::shared_ptr<const CBlock>& block_out, bool process_new_block)
+/** Return the number of threads to solve blocks with, from the RPC parameter or -minerthreads. */
+static unsigned int GetMinerThreads(const ArgsManager& args, const UniValue& param)
+{
+    const int64_t threads{param.isNull() ? args.GetIntArg("-minerthreads", DEFAULT_MINER_THREADS) : param.getInt<int64_t>()};
+    if (threads < 0) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid threads. Must be 0 (one per core) or a positive number.");
+    }
+    if (threads == 0) return std::max(GetNumCores(), 1);
+    return static_cast<unsigned int>(std::min<int64_t>(threads, MAX_MINER_THREADS));
+}
+
+static bool GenerateBlock(ChainstateManager& chainman, CBlock& block, uint64_t& max_tries, std::shared_ptr<const CBlock>& block_out, bool process_new_block, unsigned int threads)
 {
     block_out.reset();
     block.hashMerkleRoot = BlockMerkleRoot(block);
 
-    uint256 hashMix;
-    while (max_tries > 0 && block.nNonce < std::numeric_limits<uint64_t>::max() && !CheckProofOfWork(block.GetHash(hashMix), block.nBits, chainman.GetConsensus()) && !chainman.m_interrupt) {
-        ++block.nNonce;
-        --max_tries;
-    }
-    if (max_tries == 0 || chainman.m_interrupt) {
-        return false;
-    }
-    if (block.nNonce == std::numeric_limits<uint64_t>::max()) {
+    if (!SolveBlock(block, chainman.GetConsensus(), threads, max_tries, chainman.m_interrupt)) {
+        if (max_tries == 0 || chainman.m_interrupt) {
+            return false;
+        }
+        // The nonce space is exhausted
         return true;
     }
 
-    block.hashMix = hashMix;
     block_out = std::make_shared<const CBlock>(block);
 
     if (!process_new_block) return true;
@@ -157,7 +168,7 @@ static bool GenerateBlock(ChainstateManager& chainman, CBlock& block, uint64_t&
     return true;
 }
 
-static UniValue generateBlocks(ChainstateManager& chainman, const CTxMemPool& mempool, const CScript& coinbase_script, int nGenerate, uint64_t nMaxTries)
+static UniValue generateBlocks(ChainstateManager& chainman, const CTxMemPool& mempool, const CScript& coinbase_script, int nGenerate, uint64_t nMaxTries, unsigned int threads)
 {
     UniValue blockHashes(UniValue::VARR);
     while (nGenerate > 0 && !chainman.m_interrupt) {
@@ -166,7 +177,7 @@ static UniValue generateBlocks(ChainstateManager& chainman, const CTxMemPool& me
             throw JSONRPCError(RPC_INTERNAL_ERROR, "Couldn't create new block");
 
         std::shared_ptr<const CBlock> block_out;
-        if (!GenerateBlock(chainman, pblocktemplate->block, nMaxTries, block_out, /*process_new_block=*/true)) {
+        if (!GenerateBlock(chainman, pblocktemplate->block, nMaxTries, block_out, /*process_new_block=*/true, threads)) {
             break;
         }
 
@@ -221,6 +232,7 @@ static RPCHelpMan generatetodescriptor()
             {"num_blocks", RPCArg::Type::NUM, RPCArg::Optional::NO, "How many blocks are generated."},
             {"descriptor", RPCArg::Type::STR, RPCArg::Optional::NO, "The descriptor to send the newly generated griffion to."},
             {"maxtries", RPCArg::Type::NUM, RPCArg::Default{DEFAULT_MAX_TRIES}, "How many iterations to try."},
+            {"threads", RPCArg::Type::NUM, RPCArg::DefaultHint{"the -minerthreads value"}, "How many threads to solve each block with, 0 for one per core."},
         },
         RPCResult{
             RPCResult::Type::ARR, "", "hashes of blocks generated",
@@ -234,6 +246,7 @@ static RPCHelpMan generatetodescriptor()
 {
     const auto num_blocks{self.Arg<int>(0)};
     const auto max_tries{self.Arg<uint64_t>(2)};
+    const unsigned int threads{GetMinerThreads(EnsureAnyArgsman(request.context), request.params[3])};
 
     CScript coinbase_script;
     std::string error;
@@ -245,7 +258,7 @@ static RPCHelpMan generatetodescriptor()
     const CTxMemPool& mempool = EnsureMemPool(node);
     ChainstateManager& chainman = EnsureChainman(node);
 
-    return generateBlocks(chainman, mempool, coinbase_script, num_blocks, max_tries);
+    return generateBlocks(chainman, mempool, coinbase_script, num_blocks, max_tries, threads);
 },
     };
 }
@@ -265,6 +278,7 @@ static RPCHelpMan generatetoaddress()
              {"nblocks", RPCArg::Type::NUM, RPCArg::Optional::NO, "How many blocks are generated."},
              {"address", RPCArg::Type::STR, RPCArg::Optional::NO, "The address to send the newly generated griffion to."},
              {"maxtries", RPCArg::Type::NUM, RPCArg::Default{DEFAULT_MAX_TRIES}, "How many iterations to try."},
+             {"threads", RPCArg::Type::NUM, RPCArg::DefaultHint{"the -minerthreads value"}, "How many threads to solve each block with, 0 for one per core."},
          },
          RPCResult{
              RPCResult::Type::ARR, "", "hashes of blocks generated",
@@ -281,6 +295,7 @@ static RPCHelpMan generatetoaddress()
 {
     const int num_blocks{request.params[0].getInt<int>()};
     const uint64_t max_tries{request.params[2].isNull() ? DEFAULT_MAX_TRIES : request.params[2].getInt<int>()};
+    const unsigned int threads{GetMinerThreads(EnsureAnyArgsman(request.context), request.params[3])};
 
     CTxDestination destination = DecodeDestination(request.params[1].get_str());
     if (!IsValidDestination(destination)) {
@@ -293,7 +308,7 @@ static RPCHelpMan generatetoaddress()
 
     CScript coinbase_script = GetScriptForDestination(destination);
 
-    return generateBlocks(chainman, mempool, coinbase_script, num_blocks, max_tries);
+    return generateBlocks(chainman, mempool, coinbase_script, num_blocks, max_tries, threads);
 },
     };
 }
@@ -398,7 +413,7 @@ static RPCHelpMan generateblock()
     std::shared_ptr<const CBlock> block_out;
     uint64_t max_tries{DEFAULT_MAX_TRIES};
 
-    if (!GenerateBlock(chainman, block, max_tries, block_out, process_new_block) || !block_out) {
+    if (!GenerateBlock(chainman, block, max_tries, block_out, process_new_block, GetMinerThreads(EnsureAnyArgsman(request.context), NullUniValue)) || !block_out) {
         throw JSONRPCError(RPC_MISC_ERROR, "Failed to make block.");
     }
 
@@ -427,6 +442,7 @@ static RPCHelpMan getmininginfo()
                         {RPCResult::Type::NUM, "currentblocktx", /*optional=*/true, "The number of block transactions of the last assembled block (only present if a block was ever assembled)"},
                         {RPCResult::Type::NUM, "difficulty", "The current difficulty"},
                         {RPCResult::Type::NUM, "networkhashps", "The network hashes per second"},
+                        {RPCResult::Type::NUM, "localhashps", /*optional=*/true, "The hashes per second of the last block generated by this node (only present if a block was ever generated)"},
                         {RPCResult::Type::NUM, "pooledtx", "The size of the mempool"},
                         {RPCResult::Type::STR, "chain", "current network name (main, test, regtest)"},
                         {RPCResult::Type::STR, "warnings", "any network and blockchain warnings"},
@@ -449,6 +465,7 @@ static RPCHelpMan getmininginfo()
     if (BlockAssembler::m_last_block_num_txs) obj.pushKV("currentblocktx", *BlockAssembler::m_last_block_num_txs);
     obj.pushKV("difficulty", GetDifficulty(*CHECK_NONFATAL(active_chain.Tip())));
     obj.pushKV("networkhashps",    getnetworkhashps().HandleRequest(request));
+    if (const auto hash_rate{GetLastSolveHashRate()}) obj.pushKV("localhashps", *hash_rate);
     obj.pushKV("pooledtx",         (uint64_t)mempool.size());
     obj.pushKV("chain", chainman.GetParams().GetChainTypeString());
     obj.pushKV("warnings",         GetWarnings(false).original);
@@ -702,8 +719,10 @@ static RPCHelpMan getblocktemplate()
             // TestBlockValidity only supports blocks built on the current Tip
             if (block.hashPrevBlock != pindexPrev->GetBlockHash())
                 return "inconclusive-not-best-prevblk";
+            // Proposals are usually built from the transactions of our own
+            // mempool, whose scripts have been checked already.
             BlockValidationState state;
-            TestBlockValidity(state, chainman.GetParams(), active_chainstate, block, pindexPrev, false, true);
+            TestBlockValidity(state, chainman.GetParams(), active_chainstate, block, pindexPrev, false, true, active_chainstate.GetMempool());
             return BIP22ValidationResult(state);
         }
 
@@ -15,6 +15,7 @@
 #include <net_processing.h>
 #include <net_types.h> // For banmap_t
 #include <netbase.h>
+#include <node/blockstorage.h>
 #include <node/context.h>
 #include <node/protocol_version.h>
 #include <policy/settings.h>
@@ -567,6 +568,14 @@ static RPCHelpMan getnettotals()
                            {RPCResult::Type::NUM, "bytes_left_in_cycle", "Bytes left in current time cycle"},
                            {RPCResult::Type::NUM, "time_left_in_cycle", "Seconds left in current time cycle"},
                         }},
+                       {RPCResult::Type::OBJ, "blockcache", /*optional=*/true, "Cache of recently served blocks, shared by peers, REST, getblock and ZMQ (see -blockcachesize)",
+                       {
+                           {RPCResult::Type::NUM, "hits", "Number of blocks served from the cache"},
+                           {RPCResult::Type::NUM, "misses", "Number of blocks read from disk because they were not cached"},
+                           {RPCResult::Type::NUM, "blocks", "Number of blocks in the cache"},
+                           {RPCResult::Type::NUM, "bytes", "Memory used by the cache in bytes"},
+                           {RPCResult::Type::NUM, "max_bytes", "Size limit of the cache in bytes"},
+                        }},
                     }
                 },
                 RPCExamples{
@@ -591,6 +600,17 @@ static RPCHelpMan getnettotals()
     outboundLimit.pushKV("bytes_left_in_cycle", connman.GetOutboundTargetBytesLeft());
     outboundLimit.pushKV("time_left_in_cycle", count_seconds(connman.GetMaxOutboundTimeLeftInCycle()));
     obj.pushKV("uploadtarget", outboundLimit);
+
+    if (node.chainman) {
+        const auto stats{node.chainman->m_blockman.GetBlockCacheStats()};
+        UniValue block_cache(UniValue::VOBJ);
+        block_cache.pushKV("hits", stats.hits);
+        block_cache.pushKV("misses", stats.misses);
+        block_cache.pushKV("blocks", uint64_t(stats.blocks));
+        block_cache.pushKV("bytes", uint64_t(stats.bytes));
+        block_cache.pushKV("max_bytes", uint64_t(stats.max_bytes));
+        obj.pushKV("blockcache", block_cache);
+    }
     return obj;
 },
     };
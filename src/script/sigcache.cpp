@@ -30,6 +30,7 @@ class CSignatureCache
 {
 private:
      //! Entries are SHA256(nonce || 'E' or 'S' || 31 zero bytes || signature hash || public key || signature):
+    uint256 m_nonce;
     CSHA256 m_salted_hasher_ecdsa;
     CSHA256 m_salted_hasher_schnorr;
     typedef CuckooCache::cache<uint256, SignatureCacheHasher> map_type;
@@ -39,19 +40,29 @@ private:
 public:
     CSignatureCache()
     {
-        uint256 nonce = GetRandHash();
+        SetNonce(GetRandHash());
+    }
+
+    //! Not thread safe with the other methods.
+    void SetNonce(const uint256& nonce)
+    {
         // We want the nonce to be 64 bytes long to force the hasher to process
         // this chunk, which makes later hash computations more efficient. We
         // just write our 32-byte entropy, and then pad with 'E' for ECDSA and
         // 'S' for Schnorr (followed by 0 bytes).
         static constexpr unsigned char PADDING_ECDSA[32] = {'E'};
         static constexpr unsigned char PADDING_SCHNORR[32] = {'S'};
+        m_nonce = nonce;
+        m_salted_hasher_ecdsa.Reset();
         m_salted_hasher_ecdsa.Write(nonce.begin(), 32);
         m_salted_hasher_ecdsa.Write(PADDING_ECDSA, 32);
+        m_salted_hasher_schnorr.Reset();
         m_salted_hasher_schnorr.Write(nonce.begin(), 32);
         m_salted_hasher_schnorr.Write(PADDING_SCHNORR, 32);
     }
 
+    const uint256& GetNonce() const { return m_nonce; }
+
     void
     ComputeEntryECDSA(uint256& entry, const uint256 &hash, const std::vector<unsigned char>& vchSig, const CPubKey& pubkey) const
     {
@@ -82,6 +93,14 @@ public:
     {
         return setValid.setup_bytes(n);
     }
+
+    std::vector<uint256> GetEntries()
+    {
+        std::unique_lock<std::shared_mutex> lock(cs_sigcache);
+        std::vector<uint256> entries;
+        setValid.for_each([&](const uint256& entry) { entries.push_back(entry); });
+        return entries;
+    }
 };
 
 /* In previous versions of this code, signatureCache was a local static variable
@@ -106,6 +125,19 @@ bool InitSignatureCache(size_t max_size_bytes)
     return true;
 }
 
+SaltedCacheEntries GetSignatureCacheEntries()
+{
+    return {signatureCache.GetNonce(), signatureCache.GetEntries()};
+}
+
+void LoadSignatureCacheEntries(const SaltedCacheEntries& cache)
+{
+    signatureCache.SetNonce(cache.salt);
+    for (const uint256& entry : cache.entries) {
+        signatureCache.Set(entry);
+    }
+}
+
 bool CachingTransactionSignatureChecker::VerifyECDSASignature(const std::vector<unsigned char>& vchSig, const CPubKey& pubkey, const uint256& sighash) const
 {
     uint256 entry;
@@ -124,6 +156,11 @@ bool CachingTransactionSignatureChecker::VerifySchnorrSignature(Span<const unsig
     uint256 entry;
     signatureCache.ComputeEntrySchnorr(entry, sighash, sig, pubkey);
     if (signatureCache.Get(entry, !store)) return true;
+    // The script is only valid once the batch is, so the signature is assumed valid here.
+    if (m_schnorr_batch && !store) {
+        m_schnorr_batch->Add(pubkey, sighash, sig);
+        return true;
+    }
     if (!TransactionSignatureChecker::VerifySchnorrSignature(sig, pubkey, sighash)) return false;
     if (store) signatureCache.Set(entry);
     return true;
@@ -8,26 +8,39 @@
 #define GRIFFION_SCRIPT_SIGCACHE_H
 
 #include <script/interpreter.h>
+#include <serialize.h>
 #include <span.h>
+#include <uint256.h>
 #include <util/hasher.h>
 
 #include <optional>
 #include <vector>
 
+/** The salt of a cache of salted hashes, and the hashes it holds. */
+struct SaltedCacheEntries {
+    uint256 salt;
+    std::vector<uint256> entries;
+
+    SERIALIZE_METHODS(SaltedCacheEntries, obj) { READWRITE(obj.salt, obj.entries); }
+};
+
 // DoS prevention: limit cache size to 32MiB (over 1000000 entries on 64-bit
 // systems). Due to how we count cache size, actual memory usage is slightly
 // more (~32.25 MiB)
 static constexpr size_t DEFAULT_MAX_SIG_CACHE_BYTES{32 << 20};
 
 class CPubKey;
+class SchnorrSignatureBatch;
 
 class CachingTransactionSignatureChecker : public TransactionSignatureChecker
 {
 private:
     bool store;
+    //! If set, Schnorr signatures that are not stored in the cache are added to it instead of verified.
+    SchnorrSignatureBatch* m_schnorr_batch;
 
 public:
-    CachingTransactionSignatureChecker(const CTransaction* txToIn, unsigned int nInIn, const CAmount& amountIn, bool storeIn, PrecomputedTransactionData& txdataIn) : TransactionSignatureChecker(txToIn, nInIn, amountIn, txdataIn, MissingDataBehavior::ASSERT_FAIL), store(storeIn) {}
+    CachingTransactionSignatureChecker(const CTransaction* txToIn, unsigned int nInIn, const CAmount& amountIn, bool storeIn, PrecomputedTransactionData& txdataIn, SchnorrSignatureBatch* schnorr_batch = nullptr) : TransactionSignatureChecker(txToIn, nInIn, amountIn, txdataIn, MissingDataBehavior::ASSERT_FAIL), store(storeIn), m_schnorr_batch(schnorr_batch) {}
 
     bool VerifyECDSASignature(const std::vector<unsigned char>& vchSig, const CPubKey& vchPubKey, const uint256& sighash) const override;
     bool VerifySchnorrSignature(Span<const unsigned char> sig, const XOnlyPubKey& pubkey, const uint256& sighash) const override;
@@ -35,4 +48,14 @@ public:
 
 [[nodiscard]] bool InitSignatureCache(size_t max_size_bytes);
 
+/** Get the salt and the entries of the signature cache, to save them. */
+SaltedCacheEntries GetSignatureCacheEntries();
+
+/**
+ * Switch the signature cache to the salt of saved entries and add them to it.
+ * Entries computed with the previous salt can no longer be found, so this
+ * should be called before the cache is used.
+ */
+void LoadSignatureCacheEntries(const SaltedCacheEntries& cache);
+
 #endif // GRIFFION_SCRIPT_SIGCACHE_H
@@ -181,6 +181,33 @@ SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_schnorrsig_verify(
     const secp256k1_xonly_pubkey *pubkey
 ) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(5);
 
+/** Verify a batch of Schnorr signatures of 32-byte messages.
+ *
+ *  Checks all signatures with a single multi-scalar multiplication, which is
+ *  faster than calling secp256k1_schnorrsig_verify for each of them. An
+ *  incorrect signature makes the whole batch fail, without telling which one
+ *  it is.
+ *
+ *  Returns: 1: all signatures are correct (or n_sigs is 0)
+ *           0: at least one signature is incorrect
+ *  Args:    ctx: a secp256k1 context object.
+ *       scratch: scratch space used for the multi-scalar multiplication. If
+ *                NULL, the points are multiplied one by one.
+ *  In:    sig64: array of pointers to the 64-byte signatures to verify.
+ *         msg32: array of pointers to the 32-byte messages being verified.
+ *       pubkeys: array of pointers to the x-only public keys to verify with.
+ *        n_sigs: number of signatures in the arrays. The arrays can only be
+ *                NULL if n_sigs is 0.
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_schnorrsig_verify_batch(
+    const secp256k1_context *ctx,
+    secp256k1_scratch_space *scratch,
+    const unsigned char *const *sig64,
+    const unsigned char *const *msg32,
+    const secp256k1_xonly_pubkey *const *pubkeys,
+    size_t n_sigs
+) SECP256K1_ARG_NONNULL(1);
+
 #ifdef __cplusplus
 }
 #endif
@@ -264,4 +264,141 @@ int secp256k1_schnorrsig_verify(const secp256k1_context* ctx, const unsigned cha
            secp256k1_fe_equal(&rx, &r.x);
 }
 
+/* Initializes SHA256 with fixed midstate. This midstate was computed by applying
+ * SHA256 to SHA256("BIP0340/batch")||SHA256("BIP0340/batch"). */
+static void secp256k1_schnorrsig_sha256_tagged_batch(secp256k1_sha256 *sha) {
+    secp256k1_sha256_initialize(sha);
+    sha->s[0] = 0x79e3e0d2ul;
+    sha->s[1] = 0x12284f32ul;
+    sha->s[2] = 0xd7d89e1cul;
+    sha->s[3] = 0x6491ea9aul;
+    sha->s[4] = 0xad823b2ful;
+    sha->s[5] = 0xfacfe0b6ul;
+    sha->s[6] = 0x342b78baul;
+    sha->s[7] = 0x12ece87cul;
+    sha->bytes = 64;
+}
+
+/* Sets the randomizer of the i'th signature of a batch to 1 for the first
+ * signature and to the tagged hash of the seed and i for the others. */
+static void secp256k1_schnorrsig_verify_batch_randomizer(secp256k1_scalar *a, const unsigned char *seed32, size_t i) {
+    unsigned char buf[32];
+    secp256k1_sha256 sha;
+    int j;
+
+    if (i == 0) {
+        secp256k1_scalar_set_int(a, 1);
+        return;
+    }
+    for (j = 0; j < 8; j++) {
+        buf[j] = (unsigned char)(((uint64_t)i) >> (8 * j));
+    }
+    secp256k1_sha256_initialize(&sha);
+    secp256k1_sha256_write(&sha, seed32, 32);
+    secp256k1_sha256_write(&sha, buf, 8);
+    secp256k1_sha256_finalize(&sha, buf);
+    secp256k1_scalar_set_b32(a, buf, NULL);
+}
+
+typedef struct {
+    const secp256k1_context *ctx;
+    unsigned char seed[32];
+    const unsigned char *const *sig64;
+    const unsigned char *const *msg32;
+    const secp256k1_xonly_pubkey *const *pubkeys;
+} secp256k1_schnorrsig_verify_batch_ecmult_data;
+
+/* Returns the points of the batch equation, a_i*R_i for even and
+ * a_i*e_i*P_i for odd indices. */
+static int secp256k1_schnorrsig_verify_batch_ecmult_callback(secp256k1_scalar *sc, secp256k1_ge *pt, size_t idx, void *data) {
+    const secp256k1_schnorrsig_verify_batch_ecmult_data *ecmult_data = (const secp256k1_schnorrsig_verify_batch_ecmult_data *) data;
+    const size_t i = idx / 2;
+
+    secp256k1_schnorrsig_verify_batch_randomizer(sc, ecmult_data->seed, i);
+    if (idx % 2 == 0) {
+        secp256k1_fe rx;
+        if (!secp256k1_fe_set_b32_limit(&rx, &ecmult_data->sig64[i][0])) {
+            return 0;
+        }
+        /* R_i is the point with x coordinate r_i and an even y coordinate. */
+        return secp256k1_ge_set_xo_var(pt, &rx, 0);
+    } else {
+        secp256k1_scalar e;
+        unsigned char buf[32];
+        if (!secp256k1_xonly_pubkey_load(ecmult_data->ctx, pt, ecmult_data->pubkeys[i])) {
+            return 0;
+        }
+        secp256k1_fe_get_b32(buf, &pt->x);
+        secp256k1_schnorrsig_challenge(&e, &ecmult_data->sig64[i][0], ecmult_data->msg32[i], 32, buf);
+        secp256k1_scalar_mul(sc, sc, &e);
+        return 1;
+    }
+}
+
+int secp256k1_schnorrsig_verify_batch(const secp256k1_context *ctx, secp256k1_scratch_space *scratch, const unsigned char *const *sig64, const unsigned char *const *msg32, const secp256k1_xonly_pubkey *const *pubkeys, size_t n_sigs) {
+    secp256k1_schnorrsig_verify_batch_ecmult_data ecmult_data;
+    secp256k1_sha256 sha;
+    secp256k1_scalar s;
+    secp256k1_scalar a;
+    secp256k1_scalar sum;
+    secp256k1_ge pk;
+    secp256k1_gej rj;
+    unsigned char buf[32];
+    size_t i;
+    int overflow;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(n_sigs == 0 || sig64 != NULL);
+    ARG_CHECK(n_sigs == 0 || msg32 != NULL);
+    ARG_CHECK(n_sigs == 0 || pubkeys != NULL);
+    /* The points of the batch are indexed by 2*i and 2*i+1. */
+    ARG_CHECK(n_sigs <= SIZE_MAX / 2);
+
+    if (n_sigs == 0) {
+        return 1;
+    }
+
+    /* The randomizers are derived from all signatures, messages and public
+     * keys of the batch, so that none of them can be chosen knowing the
+     * randomizers. */
+    secp256k1_schnorrsig_sha256_tagged_batch(&sha);
+    for (i = 0; i < n_sigs; i++) {
+        ARG_CHECK(sig64[i] != NULL);
+        ARG_CHECK(msg32[i] != NULL);
+        ARG_CHECK(pubkeys[i] != NULL);
+        if (!secp256k1_xonly_pubkey_load(ctx, &pk, pubkeys[i])) {
+            return 0;
+        }
+        secp256k1_fe_get_b32(buf, &pk.x);
+        secp256k1_sha256_write(&sha, sig64[i], 64);
+        secp256k1_sha256_write(&sha, msg32[i], 32);
+        secp256k1_sha256_write(&sha, buf, 32);
+    }
+    secp256k1_sha256_finalize(&sha, ecmult_data.seed);
+
+    /* Compute sum = a_0*s_0 + ... + a_(n-1)*s_(n-1). */
+    secp256k1_scalar_set_int(&sum, 0);
+    for (i = 0; i < n_sigs; i++) {
+        secp256k1_scalar_set_b32(&s, &sig64[i][32], &overflow);
+        if (overflow) {
+            return 0;
+        }
+        secp256k1_schnorrsig_verify_batch_randomizer(&a, ecmult_data.seed, i);
+        secp256k1_scalar_mul(&s, &s, &a);
+        secp256k1_scalar_add(&sum, &sum, &s);
+    }
+
+    /* All signatures are valid (except with negligible probability) if and
+     * only if -sum*G + a_0*R_0 + a_0*e_0*P_0 + ... is the point at infinity. */
+    secp256k1_scalar_negate(&sum, &sum);
+    ecmult_data.ctx = ctx;
+    ecmult_data.sig64 = sig64;
+    ecmult_data.msg32 = msg32;
+    ecmult_data.pubkeys = pubkeys;
+    if (!secp256k1_ecmult_multi_var(&ctx->error_callback, scratch, &rj, &sum, secp256k1_schnorrsig_verify_batch_ecmult_callback, (void *) &ecmult_data, 2 * n_sigs)) {
+        return 0;
+    }
+    return secp256k1_gej_is_infinity(&rj);
+}
+
 #endif
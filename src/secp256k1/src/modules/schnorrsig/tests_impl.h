@@ -928,6 +928,93 @@ static void test_schnorrsig_sign_verify(void) {
 }
 #undef N_SIGS
 
+/* Enough signatures for the multi-scalar multiplication to use Pippenger's
+ * algorithm with a large scratch space. */
+#define N_SIGS 50
+static void test_schnorrsig_verify_batch(void) {
+    unsigned char sk[32];
+    unsigned char msg[N_SIGS][32];
+    unsigned char sig[N_SIGS][64];
+    secp256k1_keypair keypair;
+    secp256k1_xonly_pubkey pk[N_SIGS];
+    const unsigned char *sig_ptr[N_SIGS];
+    const unsigned char *msg_ptr[N_SIGS];
+    const secp256k1_xonly_pubkey *pk_ptr[N_SIGS];
+    secp256k1_scratch_space *scratch = secp256k1_scratch_space_create(CTX, 1024 * 1024);
+    secp256k1_scratch_space *small_scratch = secp256k1_scratch_space_create(CTX, 1024);
+    secp256k1_scalar s;
+    size_t i;
+
+    for (i = 0; i < N_SIGS; i++) {
+        secp256k1_testrand256(sk);
+        CHECK(secp256k1_keypair_create(CTX, &keypair, sk));
+        CHECK(secp256k1_keypair_xonly_pub(CTX, &pk[i], NULL, &keypair));
+        secp256k1_testrand256(msg[i]);
+        CHECK(secp256k1_schnorrsig_sign32(CTX, sig[i], msg[i], &keypair, NULL));
+        sig_ptr[i] = sig[i];
+        msg_ptr[i] = msg[i];
+        pk_ptr[i] = &pk[i];
+    }
+
+    /* Valid batches of all sizes verify, with and without scratch space */
+    CHECK(secp256k1_schnorrsig_verify_batch(CTX, scratch, NULL, NULL, NULL, 0) == 1);
+    for (i = 1; i <= N_SIGS; i += 7) {
+        CHECK(secp256k1_schnorrsig_verify_batch(CTX, scratch, sig_ptr, msg_ptr, pk_ptr, i) == 1);
+    }
+    CHECK(secp256k1_schnorrsig_verify_batch(CTX, NULL, sig_ptr, msg_ptr, pk_ptr, N_SIGS) == 1);
+    CHECK(secp256k1_schnorrsig_verify_batch(CTX, small_scratch, sig_ptr, msg_ptr, pk_ptr, N_SIGS) == 1);
+
+    {
+        /* A single flipped bit in any signature, message or public key
+         * fails the batch */
+        size_t sig_idx = secp256k1_testrand_int(N_SIGS);
+        size_t byte_idx = secp256k1_testrand_bits(5);
+        unsigned char xorbyte = secp256k1_testrand_int(254)+1;
+        sig[sig_idx][byte_idx] ^= xorbyte;
+        CHECK(secp256k1_schnorrsig_verify_batch(CTX, scratch, sig_ptr, msg_ptr, pk_ptr, N_SIGS) == 0);
+        sig[sig_idx][byte_idx] ^= xorbyte;
+
+        byte_idx = secp256k1_testrand_bits(5);
+        sig[sig_idx][32+byte_idx] ^= xorbyte;
+        CHECK(secp256k1_schnorrsig_verify_batch(CTX, scratch, sig_ptr, msg_ptr, pk_ptr, N_SIGS) == 0);
+        sig[sig_idx][32+byte_idx] ^= xorbyte;
+
+        byte_idx = secp256k1_testrand_bits(5);
+        msg[sig_idx][byte_idx] ^= xorbyte;
+        CHECK(secp256k1_schnorrsig_verify_batch(CTX, scratch, sig_ptr, msg_ptr, pk_ptr, N_SIGS) == 0);
+        msg[sig_idx][byte_idx] ^= xorbyte;
+
+        /* Signatures of another key don't verify */
+        pk_ptr[sig_idx] = &pk[(sig_idx + 1) % N_SIGS];
+        CHECK(secp256k1_schnorrsig_verify_batch(CTX, scratch, sig_ptr, msg_ptr, pk_ptr, N_SIGS) == 0);
+        pk_ptr[sig_idx] = &pk[sig_idx];
+
+        CHECK(secp256k1_schnorrsig_verify_batch(CTX, scratch, sig_ptr, msg_ptr, pk_ptr, N_SIGS) == 1);
+    }
+
+    /* Overflowing s and negated s fail the batch */
+    memset(&sig[N_SIGS - 1][32], 0xFF, 32);
+    CHECK(secp256k1_schnorrsig_verify_batch(CTX, scratch, sig_ptr, msg_ptr, pk_ptr, N_SIGS) == 0);
+    CHECK(secp256k1_schnorrsig_sign32(CTX, sig[N_SIGS - 1], msg[N_SIGS - 1], &keypair, NULL));
+    CHECK(secp256k1_schnorrsig_verify_batch(CTX, scratch, sig_ptr, msg_ptr, pk_ptr, N_SIGS) == 1);
+    secp256k1_scalar_set_b32(&s, &sig[N_SIGS - 1][32], NULL);
+    secp256k1_scalar_negate(&s, &s);
+    secp256k1_scalar_get_b32(&sig[N_SIGS - 1][32], &s);
+    CHECK(secp256k1_schnorrsig_verify_batch(CTX, scratch, sig_ptr, msg_ptr, pk_ptr, N_SIGS) == 0);
+
+    /* An r that is not a valid x coordinate fails the batch */
+    memset(&sig[0][0], 0xFF, 32);
+    CHECK(secp256k1_schnorrsig_verify_batch(CTX, scratch, sig_ptr, msg_ptr, pk_ptr, 1) == 0);
+
+    CHECK_ILLEGAL(CTX, secp256k1_schnorrsig_verify_batch(CTX, scratch, NULL, msg_ptr, pk_ptr, 1));
+    CHECK_ILLEGAL(CTX, secp256k1_schnorrsig_verify_batch(CTX, scratch, sig_ptr, NULL, pk_ptr, 1));
+    CHECK_ILLEGAL(CTX, secp256k1_schnorrsig_verify_batch(CTX, scratch, sig_ptr, msg_ptr, NULL, 1));
+
+    secp256k1_scratch_space_destroy(CTX, small_scratch);
+    secp256k1_scratch_space_destroy(CTX, scratch);
+}
+#undef N_SIGS
+
 static void test_schnorrsig_taproot(void) {
     unsigned char sk[32];
     secp256k1_keypair keypair;
@@ -974,6 +1061,7 @@ static void run_schnorrsig_tests(void) {
     for (i = 0; i < COUNT; i++) {
         test_schnorrsig_sign();
         test_schnorrsig_sign_verify();
+        test_schnorrsig_verify_batch();
     }
     test_schnorrsig_taproot();
 }
@@ -8,17 +8,23 @@
 #include <node/blockstorage.h>
 #include <node/context.h>
 #include <node/kernel_notifications.h>
+#include <pow.h>
 #include <script/solver.h>
 #include <primitives/block.h>
+#include <undo.h>
 #include <util/chaintype.h>
 #include <validation.h>
 
 #include <boost/test/unit_test.hpp>
 #include <test/util/logging.h>
+#include <test/util/random.h>
 #include <test/util/setup_common.h>
 
 using node::BLOCK_SERIALIZATION_HEADER_SIZE;
+using node::BlockCache;
 using node::BlockManager;
+using node::BlockTreeDB;
+using node::CheckPowOnLoad;
 using node::KernelNotifications;
 using node::MAX_BLOCKFILE_SIZE;
 
@@ -202,4 +208,189 @@ BOOST_AUTO_TEST_CASE(blockmanager_flush_block_file)
     BOOST_CHECK_EQUAL(read_block.nVersion, 2);
 }
 
+BOOST_AUTO_TEST_CASE(blockmanager_undo_write_read)
+{
+    KernelNotifications notifications{*Assert(m_node.shutdown), m_node.exit_status};
+
+    CBlockUndo blockundo;
+    blockundo.vtxundo.emplace_back().vprevout.emplace_back(CTxOut{CAmount{50000}, CScript() << OP_0 << std::vector<uint8_t>(20, 1)}, 99, /*fCoinBaseIn=*/true);
+    blockundo.vtxundo.emplace_back().vprevout.emplace_back(CTxOut{CAmount{70000}, CScript() << OP_TRUE}, 7, /*fCoinBaseIn=*/false);
+
+    const auto check_undo{[&](const BlockManager& blockman, const CBlockIndex& index) {
+        CBlockUndo read_undo;
+        BOOST_REQUIRE(blockman.UndoReadFromDisk(read_undo, index));
+        BOOST_REQUIRE_EQUAL(read_undo.vtxundo.size(), blockundo.vtxundo.size());
+        for (size_t i = 0; i < blockundo.vtxundo.size(); ++i) {
+            const Coin& coin{blockundo.vtxundo[i].vprevout.at(0)};
+            const Coin& read_coin{read_undo.vtxundo[i].vprevout.at(0)};
+            BOOST_CHECK(read_coin.out == coin.out);
+            BOOST_CHECK_EQUAL(read_coin.nHeight, coin.nHeight);
+            BOOST_CHECK_EQUAL(read_coin.fCoinBase, coin.fCoinBase);
+        }
+    }};
+
+    for (const bool compact_undo : {false, true}) {
+        const node::BlockManager::Options blockman_opts{
+            .chainparams = Params(),
+            .compact_undo = compact_undo,
+            .blocks_dir = m_args.GetBlocksDirPath(),
+            .notifications = notifications,
+        };
+        const uint256 prev_hash{uint256::ONE};
+        CBlockIndex prev;
+        prev.phashBlock = &prev_hash;
+        CBlockIndex index;
+        index.pprev = &prev;
+        index.nHeight = 100;
+        {
+            BlockManager blockman{*Assert(m_node.shutdown), blockman_opts};
+            index.nFile = blockman.SaveBlockToDisk(CBlock{}, index.nHeight, /*dbp=*/nullptr).nFile;
+
+            LOCK(cs_main);
+            BlockValidationState state;
+            BOOST_REQUIRE(blockman.WriteUndoDataForBlock(blockundo, state, index));
+            BOOST_CHECK(index.nStatus & BLOCK_HAVE_UNDO);
+            BOOST_CHECK_EQUAL((index.nStatus & BLOCK_UNDO_COMPACT) != 0, compact_undo);
+            BOOST_CHECK_EQUAL(index.nUndoPos, BLOCK_SERIALIZATION_HEADER_SIZE);
+            // The undo data can be read whether or not it has been written yet
+            check_undo(blockman, index);
+        }
+        // Destroying the block manager waits for the undo data to be written
+        BlockManager blockman{*Assert(m_node.shutdown), blockman_opts};
+        check_undo(blockman, index);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(blockmanager_block_cache_eviction)
+{
+    // Room for three of the blocks below in each shard
+    BlockCache cache{BlockCache::SHARDS * 4000};
+    const auto make_hash{[](uint8_t n) {
+        // Same bytes 8 to 15, so all blocks land in the same shard
+        uint256 hash;
+        hash.data()[0] = n;
+        return hash;
+    }};
+    const auto make_block{[] { return std::make_shared<const std::vector<uint8_t>>(1000); }};
+
+    for (uint8_t n = 1; n <= 3; ++n) cache.PutRawBlock(make_hash(n), make_block());
+    BOOST_CHECK_EQUAL(cache.GetStats().blocks, 3U);
+    BOOST_CHECK(!cache.GetBlock(make_hash(1)));
+    BOOST_CHECK(cache.GetRawBlock(make_hash(1)));
+    BOOST_CHECK_EQUAL(cache.GetStats().hits, 1U);
+    BOOST_CHECK_EQUAL(cache.GetStats().misses, 1U);
+
+    // Block 1 was just used, so block 2 is evicted
+    cache.PutRawBlock(make_hash(4), make_block());
+    BOOST_CHECK(cache.GetRawBlock(make_hash(1)));
+    BOOST_CHECK(!cache.GetRawBlock(make_hash(2)));
+    BOOST_CHECK(cache.GetRawBlock(make_hash(3)));
+    BOOST_CHECK(cache.GetRawBlock(make_hash(4)));
+    const auto stats{cache.GetStats()};
+    BOOST_CHECK_EQUAL(stats.blocks, 3U);
+    BOOST_CHECK_LE(stats.bytes, stats.max_bytes / BlockCache::SHARDS);
+
+    // Blocks larger than a shard are not cached
+    cache.PutRawBlock(make_hash(5), std::make_shared<const std::vector<uint8_t>>(5000));
+    BOOST_CHECK(!cache.GetRawBlock(make_hash(5)));
+    BOOST_CHECK(cache.GetRawBlock(make_hash(1)));
+
+    BlockCache disabled{0};
+    disabled.PutRawBlock(make_hash(1), make_block());
+    BOOST_CHECK(!disabled.GetRawBlock(make_hash(1)));
+    BOOST_CHECK_EQUAL(disabled.GetStats().misses, 0U);
+}
+
+BOOST_FIXTURE_TEST_CASE(blockmanager_read_block_cached, TestChain100Setup)
+{
+    auto& blockman{m_node.chainman->m_blockman};
+    const CBlockIndex& index{*Assert(WITH_LOCK(::cs_main, return m_node.chainman->ActiveChain()[50]))};
+    const auto hits{blockman.GetBlockCacheStats().hits};
+    const auto misses{blockman.GetBlockCacheStats().misses};
+
+    CBlock block;
+    BOOST_REQUIRE(blockman.ReadBlockFromDisk(block, index));
+    const auto cached_block{blockman.ReadBlockCached(index)};
+    BOOST_REQUIRE(cached_block);
+    BOOST_CHECK_EQUAL(cached_block->GetHash(), block.GetHash());
+    BOOST_CHECK(blockman.ReadBlockCached(index) == cached_block);
+
+    const auto raw_block{blockman.ReadRawBlockCached(index)};
+    BOOST_REQUIRE(raw_block);
+    DataStream ss;
+    ss << TX_WITH_WITNESS(block);
+    BOOST_CHECK(MakeUCharSpan(ss) == Span<const uint8_t>{*raw_block});
+    BOOST_CHECK(blockman.ReadRawBlockCached(index) == raw_block);
+
+    const auto stats{blockman.GetBlockCacheStats()};
+    BOOST_CHECK_EQUAL(stats.hits - hits, 2U);
+    BOOST_CHECK_EQUAL(stats.misses - misses, 2U);
+    BOOST_CHECK_EQUAL(stats.blocks, 1U);
+}
+
+BOOST_FIXTURE_TEST_CASE(blockmanager_check_pow_on_load, TestChain100Setup)
+{
+    LOCK(::cs_main);
+    const Consensus::Params& consensus{m_node.chainman->GetConsensus()};
+    const CBlockIndex* tip{m_node.chainman->ActiveChain().Tip()};
+    const CBlockIndex* prev{tip->pprev};
+    BOOST_CHECK(tip->nStatus & BLOCK_POW_VERIFIED);
+    BOOST_CHECK(prev->nStatus & BLOCK_POW_VERIFIED);
+
+    // Store the tip without the flag, its parent with it, and the genesis
+    // block, whose mix is verified like any other
+    const uint256 tip_hash{tip->GetBlockHash()};
+    CBlockIndex unflagged{tip->GetBlockHeader()};
+    unflagged.phashBlock = &tip_hash;
+    unflagged.pprev = tip->pprev;
+    unflagged.nHeight = tip->nHeight;
+    unflagged.nStatus = tip->nStatus & ~BLOCK_POW_VERIFIED;
+
+    BlockTreeDB db{DBParams{.path = m_args.GetDataDirNet() / "check_pow_index", .cache_bytes = 1 << 20, .memory_only = true}};
+    BOOST_REQUIRE(db.WriteBatchSync({}, 0, {m_node.chainman->ActiveChain().Genesis(), prev, &unflagged}));
+
+    std::map<uint256, CBlockIndex> index;
+    auto load = [&](CheckPowOnLoad check_pow) EXCLUSIVE_LOCKS_REQUIRED(::cs_main) {
+        index.clear();
+        return db.LoadBlockIndexGuts(consensus, [&](const uint256& hash) {
+            auto [it, inserted]{index.try_emplace(hash)};
+            it->second.phashBlock = &it->first;
+            return &it->second;
+        }, *Assert(m_node.shutdown), check_pow);
+    };
+
+    // The stored flags are kept as they are unless the mix is recomputed
+    BOOST_CHECK(load(CheckPowOnLoad::CACHED));
+    BOOST_CHECK(index.at(prev->GetBlockHash()).nStatus & BLOCK_POW_VERIFIED);
+    BOOST_CHECK(!(index.at(tip->GetBlockHash()).nStatus & BLOCK_POW_VERIFIED));
+    BOOST_CHECK(load(CheckPowOnLoad::NONE));
+    BOOST_CHECK(!(index.at(tip->GetBlockHash()).nStatus & BLOCK_POW_VERIFIED));
+    BOOST_CHECK(load(CheckPowOnLoad::FULL));
+    BOOST_CHECK(index.at(consensus.hashGenesisBlock).nStatus & BLOCK_POW_VERIFIED);
+    BOOST_CHECK(index.at(prev->GetBlockHash()).nStatus & BLOCK_POW_VERIFIED);
+    BOOST_CHECK(index.at(tip->GetBlockHash()).nStatus & BLOCK_POW_VERIFIED);
+
+    // A flagged entry whose hash meets its target but whose mix is wrong is
+    // only caught when the mix is recomputed
+    CBlockHeader header{tip->GetBlockHeader()};
+    header.hashPrevBlock = tip->GetBlockHash();
+    header.nHeight = tip->nHeight + 1;
+    do {
+        header.hashMix = InsecureRand256();
+    } while (!CheckProofOfWork(header.GetHash(), header.nBits, consensus));
+    BOOST_REQUIRE(!CheckProofOfWorkMix(header, consensus));
+    const uint256 forged_hash{header.GetHash()};
+    CBlockIndex forged{header};
+    forged.phashBlock = &forged_hash;
+    forged.pprev = &unflagged;
+    forged.nHeight = header.nHeight;
+    forged.nStatus = BLOCK_VALID_TREE | BLOCK_POW_VERIFIED;
+    BOOST_REQUIRE(db.WriteBatchSync({}, 0, {&forged}));
+
+    BOOST_CHECK(load(CheckPowOnLoad::CACHED));
+    BOOST_CHECK(index.at(forged_hash).nStatus & BLOCK_POW_VERIFIED);
+    BOOST_CHECK(load(CheckPowOnLoad::NONE));
+    BOOST_CHECK(!load(CheckPowOnLoad::FULL));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
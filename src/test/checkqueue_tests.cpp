@@ -65,6 +65,33 @@ struct FailingCheck {
     }
 };
 
+/** Check that leaves whether it fails to its batch. */
+struct BatchedCheck {
+    struct Batch {
+        static std::atomic<size_t> n_verified;
+        size_t m_size{0};
+        bool m_fails{false};
+
+        bool Verify()
+        {
+            n_verified.fetch_add(m_size, std::memory_order_relaxed);
+            const bool ok{!m_fails};
+            m_size = 0;
+            m_fails = false;
+            return ok;
+        }
+    };
+
+    bool fails;
+    BatchedCheck(bool _fails) : fails(_fails){};
+    bool operator()(Batch& batch) const
+    {
+        ++batch.m_size;
+        batch.m_fails |= fails;
+        return true;
+    }
+};
+
 struct UniqueCheck {
     static Mutex m;
     static std::unordered_multiset<size_t> results GUARDED_BY(m);
@@ -144,6 +171,7 @@ Mutex UniqueCheck::m;
 std::unordered_multiset<size_t> UniqueCheck::results;
 std::atomic<size_t> FakeCheckCheckCompletion::n_calls{0};
 std::atomic<size_t> MemoryCheck::fake_allocated_memory{0};
+std::atomic<size_t> BatchedCheck::Batch::n_verified{0};
 
 // Queue Typedefs
 typedef CCheckQueue<FakeCheckCheckCompletion> Correct_Queue;
@@ -152,6 +180,7 @@ typedef CCheckQueue<FailingCheck> Failing_Queue;
 typedef CCheckQueue<UniqueCheck> Unique_Queue;
 typedef CCheckQueue<MemoryCheck> Memory_Queue;
 typedef CCheckQueue<FrozenCleanupCheck> FrozenCleanup_Queue;
+typedef CCheckQueue<BatchedCheck> Batched_Queue;
 
 
 /** This test case checks that the CCheckQueue works properly
@@ -258,6 +287,54 @@ BOOST_AUTO_TEST_CASE(test_CheckQueue_Recovers_From_Failure)
     }
 }
 
+// Test that the checks of a batchable type are all verified through their
+// batches before the result is returned, and that their failures are caught.
+BOOST_AUTO_TEST_CASE(test_CheckQueue_Batched)
+{
+    static_assert(BatchableCheck<BatchedCheck>);
+    static_assert(!BatchableCheck<FailingCheck>);
+    auto batched_queue = std::make_unique<Batched_Queue>(QUEUE_BATCH_SIZE, SCRIPT_CHECK_THREADS);
+    for (size_t i = 0; i < 1001; i += 1 + InsecureRandRange(10)) {
+        BatchedCheck::Batch::n_verified = 0;
+        const size_t fail_at{InsecureRandBool() ? InsecureRandRange(i + 1) : i};
+        CCheckQueueControl<BatchedCheck> control(batched_queue.get());
+        size_t added{0};
+        while (added < i) {
+            std::vector<BatchedCheck> vChecks;
+            for (size_t r = InsecureRandRange(10); r > 0 && added < i; --r, ++added) {
+                vChecks.emplace_back(added == fail_at);
+            }
+            control.Add(std::move(vChecks));
+        }
+        const bool success{control.Wait()};
+        BOOST_REQUIRE_EQUAL(success, fail_at == i);
+        if (success) BOOST_REQUIRE_EQUAL(BatchedCheck::Batch::n_verified, i);
+    }
+}
+
+// Test that checks of another type added with AddTasks() are run exactly once
+// along with the regular checks, and that their failures are caught.
+BOOST_AUTO_TEST_CASE(test_CheckQueue_Tasks)
+{
+    auto fail_queue = std::make_unique<Failing_Queue>(QUEUE_BATCH_SIZE, SCRIPT_CHECK_THREADS);
+    for (size_t count : {0, 1, 10, 100, 1000}) {
+        for (bool fail : {false, true}) {
+            std::vector<std::atomic<int>> runs(count);
+            CCheckQueueControl<FailingCheck> control(fail_queue.get());
+            control.Add(std::vector<FailingCheck>(100, FailingCheck{false}));
+            control.AddTasks(count, [&](size_t i) {
+                runs[i].fetch_add(1, std::memory_order_relaxed);
+                return !fail || i != count / 2;
+            });
+            control.Add(std::vector<FailingCheck>(100, FailingCheck{false}));
+            BOOST_REQUIRE_EQUAL(control.Wait(), !fail || count == 0);
+            if (!fail) {
+                for (const auto& run : runs) BOOST_REQUIRE_EQUAL(run.load(), 1);
+            }
+        }
+    }
+}
+
 // Test that unique checks are actually all called individually, rather than
 // just one check being called repeatedly. Test that checks are not called
 // more than once as well
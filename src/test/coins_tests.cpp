@@ -14,6 +14,7 @@
 #include <uint256.h>
 #include <undo.h>
 #include <util/strencodings.h>
+#include <validation.h>
 
 #include <map>
 #include <vector>
@@ -553,6 +554,58 @@ BOOST_AUTO_TEST_CASE(ccoins_serialization)
     }
 }
 
+BOOST_AUTO_TEST_CASE(compact_block_undo_serialization)
+{
+    const uint160 hash160{ParseHex("816115944e077fe7c803cfa57f29b36bf87c1d35")};
+    const uint256 hash256{uint256S("8c988f1a4a4de2161e0f50aac7f17e7f9555caa48c988f1a4a4de2161e0f50aa")};
+    const std::vector<CScript> scripts{
+        GetScriptForDestination(PKHash(hash160)),
+        GetScriptForDestination(ScriptHash(hash160)),
+        GetScriptForDestination(WitnessV0KeyHash(hash160)),
+        GetScriptForDestination(WitnessV0ScriptHash(hash256)),
+        GetScriptForDestination(WitnessV1Taproot(XOnlyPubKey(hash256))),
+        CScript() << OP_RETURN << ToByteVector(hash256),
+        CScript(),
+    };
+    const uint32_t height{203998};
+
+    CBlockUndo blockundo;
+    for (size_t i = 0; i < scripts.size(); ++i) {
+        CTxUndo& txundo{blockundo.vtxundo.emplace_back()};
+        // Coins created in the block's parent, long ago, at genesis and as coinbase
+        txundo.vprevout.emplace_back(CTxOut{CAmount(i) * 100000, scripts[i]}, height - 1, /*fCoinBaseIn=*/false);
+        txundo.vprevout.emplace_back(CTxOut{CAmount{60000000000}, scripts[i]}, 120891, /*fCoinBaseIn=*/false);
+        txundo.vprevout.emplace_back(CTxOut{CAmount{110397}, scripts[i]}, 0, /*fCoinBaseIn=*/true);
+    }
+
+    DataStream compact{};
+    compact << CompactBlockUndo{blockundo, height};
+    DataStream full{};
+    full << blockundo;
+    BOOST_CHECK_LT(compact.size(), full.size());
+
+    CBlockUndo read_undo;
+    compact >> CompactBlockUndo{read_undo, height};
+    BOOST_CHECK(compact.empty());
+    BOOST_REQUIRE_EQUAL(read_undo.vtxundo.size(), blockundo.vtxundo.size());
+    for (size_t i = 0; i < blockundo.vtxundo.size(); ++i) {
+        const auto& coins{blockundo.vtxundo[i].vprevout};
+        const auto& read_coins{read_undo.vtxundo[i].vprevout};
+        BOOST_REQUIRE_EQUAL(read_coins.size(), coins.size());
+        for (size_t j = 0; j < coins.size(); ++j) {
+            BOOST_CHECK(read_coins[j].out == coins[j].out);
+            BOOST_CHECK_EQUAL(read_coins[j].nHeight, coins[j].nHeight);
+            BOOST_CHECK_EQUAL(read_coins[j].fCoinBase, coins[j].fCoinBase);
+        }
+    }
+
+    // A coin can not be created after the block spending it
+    DataStream invalid{};
+    BOOST_CHECK_THROW(invalid << CompactBlockUndo(blockundo, 120890), std::ios_base::failure);
+    invalid << CompactBlockUndo{blockundo, height};
+    BOOST_CHECK_THROW(invalid >> CompactBlockUndo(read_undo, 120890), std::ios_base::failure);
+}
+
 const static COutPoint OUTPOINT;
 const static CAmount SPENT = -1;
 const static CAmount ABSENT = -2;
@@ -1085,6 +1138,168 @@ BOOST_AUTO_TEST_CASE(ccoins_flush_behavior)
     }
 }
 
+BOOST_AUTO_TEST_CASE(ccoins_cache_fetched)
+{
+    CCoinsViewDB base{{.path = "test", .cache_bytes = 1 << 23, .memory_only = true}, {}};
+    const COutPoint present{Txid::FromUint256(InsecureRand256()), 0};
+    const COutPoint missing{Txid::FromUint256(InsecureRand256()), 1};
+    {
+        CCoinsViewCache writer{&base};
+        writer.AddCoin(present, Coin{CTxOut{1 * COIN, CScript{} << OP_TRUE}, 1, false}, false);
+        writer.SetBestBlock(InsecureRand256());
+        BOOST_REQUIRE(writer.Flush());
+    }
+
+    // Read the coins from the database like the worker threads do
+    const std::vector<COutPoint> outpoints{present, missing};
+    std::vector<Coin> coins(outpoints.size());
+    BOOST_CHECK(CCoinsFetch(base, outpoints, coins)());
+    BOOST_CHECK(!coins[0].IsSpent());
+    BOOST_CHECK(coins[1].IsSpent());
+
+    CCoinsViewCacheTest cache{&base};
+    cache.CacheCoin(present, Coin{coins[0]});
+    BOOST_CHECK(cache.HaveCoinInCache(present));
+    BOOST_CHECK(cache.AccessCoin(present).out == coins[0].out);
+    cache.SelfTest();
+
+    // A cached coin is not replaced, and a fetched coin is not dirty
+    cache.SpendCoin(present);
+    cache.CacheCoin(present, Coin{coins[0]});
+    BOOST_CHECK(!cache.HaveCoinInCache(present));
+    CCoinsViewCacheTest clean{&base};
+    clean.CacheCoin(present, Coin{coins[0]});
+    BOOST_CHECK(!(clean.map().at(present).flags & CCoinsCacheEntry::DIRTY));
+}
+
+BOOST_AUTO_TEST_CASE(ccoins_background_flush)
+{
+    CCoinsViewDB base{{.path = "test", .cache_bytes = 1 << 23, .memory_only = true}, {}};
+    const COutPoint spent{Txid::FromUint256(InsecureRand256()), 0};
+    const COutPoint added{Txid::FromUint256(InsecureRand256()), 1};
+    const uint256 old_block{InsecureRand256()};
+    const uint256 new_block{InsecureRand256()};
+    {
+        CCoinsViewCache writer{&base};
+        writer.AddCoin(spent, Coin{CTxOut{1 * COIN, CScript{} << OP_TRUE}, 1, false}, false);
+        writer.SetBestBlock(old_block);
+        BOOST_REQUIRE(writer.Flush());
+    }
+
+    CCoinsViewBackgroundFlush flush_view{&base};
+    CCoinsViewCacheTest cache{&flush_view};
+    cache.SpendCoin(spent);
+    cache.AddCoin(added, Coin{CTxOut{2 * COIN, CScript{} << OP_TRUE}, 2, false}, false);
+    cache.SetBestBlock(new_block);
+    BOOST_REQUIRE(flush_view.FlushInBackground(cache));
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 0U);
+
+    // Whether or not the write has completed, the cache sees the flushed state
+    BOOST_CHECK(!cache.HaveCoin(spent));
+    BOOST_CHECK(cache.HaveCoin(added));
+    BOOST_CHECK(cache.GetBestBlock() == new_block);
+    cache.SelfTest();
+
+    BOOST_CHECK(flush_view.Wait());
+    BOOST_CHECK(!flush_view.IsWriting());
+    BOOST_CHECK_EQUAL(flush_view.DynamicMemoryUsage(), 0U);
+    BOOST_CHECK(!base.HaveCoin(spent));
+    BOOST_CHECK(base.HaveCoin(added));
+    BOOST_CHECK(base.GetBestBlock() == new_block);
+    BOOST_CHECK(base.GetHeadBlocks().empty());
+
+    // A synchronous flush still goes through to the database
+    cache.SpendCoin(added);
+    BOOST_CHECK(cache.Flush());
+    BOOST_CHECK(!base.HaveCoin(added));
+}
+
+BOOST_AUTO_TEST_CASE(ccoins_flush_oldest)
+{
+    CCoinsViewDB base{{.path = "test", .cache_bytes = 1 << 23, .memory_only = true}, {}};
+    std::vector<COutPoint> outpoints;
+    for (uint32_t i = 0; i < 8; ++i) {
+        outpoints.emplace_back(Txid::FromUint256(InsecureRand256()), i);
+    }
+    const auto make_coin{[](uint32_t i) { return Coin{CTxOut{(i + 1) * COIN, CScript{} << OP_TRUE}, 1, false}; }};
+    const uint256 old_block{InsecureRand256()};
+    {
+        CCoinsViewCache writer{&base};
+        writer.AddCoin(outpoints[0], make_coin(0), false);
+        writer.SetBestBlock(old_block);
+        BOOST_REQUIRE(writer.Flush());
+    }
+
+    // Fetch the first coin, add the others, then spend the first one, which
+    // makes it the most recently modified
+    CCoinsViewCacheTest cache{&base};
+    cache.TrackUseOrder();
+    BOOST_CHECK(cache.HaveCoin(outpoints[0]));
+    for (uint32_t i = 1; i < outpoints.size(); ++i) {
+        cache.AddCoin(outpoints[i], make_coin(i), false);
+    }
+    BOOST_CHECK(cache.SpendCoin(outpoints[0]));
+    const uint256 new_block{InsecureRand256()};
+    cache.SetBestBlock(new_block);
+
+    // Stop after writing two modified coins
+    BOOST_CHECK(cache.FlushOldest(/*target_size=*/0, /*max_dirty=*/2));
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 6U);
+    BOOST_CHECK(!cache.HaveCoinInCache(outpoints[1]) && !cache.HaveCoinInCache(outpoints[2]));
+    BOOST_CHECK(base.HaveCoin(outpoints[1]) && base.HaveCoin(outpoints[2]) && !base.HaveCoin(outpoints[3]));
+    BOOST_CHECK(cache.HaveCoin(outpoints[1]));
+    cache.SelfTest();
+
+    // The database is left in a transition to the cache's best block
+    BOOST_CHECK(base.GetBestBlock().IsNull());
+    BOOST_CHECK(base.GetHeadBlocks() == std::vector<uint256>({new_block, old_block}));
+
+    // Stop at the target size. The entry fetched back above and the one read
+    // now are the most recently used.
+    BOOST_CHECK(!cache.AccessCoin(outpoints[3]).IsSpent());
+    BOOST_CHECK(cache.FlushOldest(/*target_size=*/5, /*max_dirty=*/100));
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 5U);
+    BOOST_CHECK(base.HaveCoin(outpoints[4]) && base.HaveCoin(outpoints[5]));
+    BOOST_CHECK(cache.HaveCoinInCache(outpoints[3]) && !base.HaveCoin(outpoints[3]));
+    BOOST_CHECK(base.HaveCoin(outpoints[0]));
+    cache.SelfTest();
+
+    // A full flush completes the transition
+    BOOST_CHECK(cache.Flush());
+    BOOST_CHECK(base.GetBestBlock() == new_block);
+    BOOST_CHECK(base.GetHeadBlocks().empty());
+    BOOST_CHECK(!base.HaveCoin(outpoints[0]));
+    for (uint32_t i = 1; i < outpoints.size(); ++i) {
+        BOOST_CHECK(base.HaveCoin(outpoints[i]));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ccoins_reset)
+{
+    CCoinsViewTest base;
+    CCoinsViewCache tip{&base, /*deterministic=*/true};
+    const COutPoint outpoint{Txid::FromUint256(InsecureRand256()), 0};
+    tip.AddCoin(outpoint, Coin{CTxOut{CAmount{1}, CScript{}}, 1, false}, false);
+    tip.SetBestBlock(InsecureRand256());
+
+    // Changes to the overlay stay in it until it is reset
+    CCoinsViewCache overlay{&tip, /*deterministic=*/true};
+    BOOST_CHECK(overlay.SpendCoin(outpoint));
+    const COutPoint added{Txid::FromUint256(InsecureRand256()), 0};
+    overlay.AddCoin(added, Coin{CTxOut{CAmount{2}, CScript{}}, 2, false}, false);
+    overlay.SetBestBlock(InsecureRand256());
+    BOOST_CHECK(!overlay.HaveCoin(outpoint));
+    BOOST_CHECK(tip.HaveCoin(outpoint));
+
+    overlay.Reset();
+    BOOST_CHECK_EQUAL(overlay.GetCacheSize(), 0U);
+    BOOST_CHECK(overlay.GetBestBlock() == tip.GetBestBlock());
+    BOOST_CHECK(overlay.HaveCoin(outpoint));
+    BOOST_CHECK(!overlay.HaveCoin(added));
+    BOOST_CHECK(!tip.HaveCoin(added));
+    overlay.SanityCheck();
+}
+
 BOOST_AUTO_TEST_CASE(coins_resource_is_used)
 {
     CCoinsMapMemoryResource resource;
@@ -13,6 +13,7 @@
 
 #include <deque>
 #include <mutex>
+#include <set>
 #include <shared_mutex>
 #include <thread>
 #include <vector>
@@ -50,6 +51,40 @@ BOOST_AUTO_TEST_CASE(test_cuckoocache_no_fakes)
     }
 };
 
+/* Test that for_each visits exactly the elements that can still be found.
+ */
+BOOST_AUTO_TEST_CASE(cuckoocache_for_each)
+{
+    SeedInsecureRand(SeedRand::ZEROS);
+    CuckooCache::cache<uint256, SignatureCacheHasher> cc{};
+    cc.setup(1000);
+    std::vector<uint256> inserted;
+    for (int x = 0; x < 500; ++x) {
+        inserted.push_back(InsecureRand256());
+        cc.insert(inserted.back());
+    }
+    // Elements allowed to be erased are not visited, even though they are
+    // only overwritten by later inserts.
+    for (int x = 0; x < 100; ++x) {
+        BOOST_CHECK(cc.contains(inserted[x], /*erase=*/true));
+    }
+    std::set<uint256> visited;
+    cc.for_each([&](const uint256& e) { BOOST_CHECK(visited.insert(e).second); });
+    for (int x = 0; x < 100; ++x) {
+        BOOST_CHECK_EQUAL(visited.count(inserted[x]), 0U);
+    }
+    for (int x = 100; x < 500; ++x) {
+        BOOST_CHECK_EQUAL(visited.count(inserted[x]), cc.contains(inserted[x], false));
+    }
+    for (const uint256& e : visited) {
+        BOOST_CHECK(cc.contains(e, false));
+    }
+
+    // After a reset nothing is visited
+    cc.setup(1000);
+    cc.for_each([&](const uint256&) { BOOST_ERROR("element visited after setup"); });
+};
+
 /** This helper returns the hit rate when megabytes*load worth of entries are
  * inserted into a megabytes sized cache
  */
@@ -0,0 +1,10 @@
+static unsigned const char asmap_raw[] = {
+0xfb, 0x03, 0xec, 0x0f, 0xb0, 0x3f, 0xc0, 0xfe, 
+0x00, 0xfb, 0x03, 0xec, 0x0f, 0xb0, 0x3f, 0xc0, 
+0xfe, 0x00, 0xfb, 0x03, 0xec, 0x0f, 0xb0, 0xff, 
+0xff, 0xfe, 0xff, 0xed, 0xb0, 0xff, 0xd4, 0x86, 
+0xe6, 0x28, 0x29, 0x00, 0x00, 0x40, 0x00, 0x00, 
+0x40, 0x00, 0x40, 0x99, 0x01, 0x00, 0x80, 0x01, 
+0x80, 0x04, 0x00, 0x00, 0x05, 0x00, 0x06, 0x00, 
+0x1c, 0xf0, 0x39, 
+};
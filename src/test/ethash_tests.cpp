@@ -4,15 +4,27 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <boost/test/unit_test.hpp>
+#include <test/util/random.h>
 #include <test/util/setup_common.h>
 
 #include <crypto/ethash/lib/ethash/endianness.hpp>
+#include <crypto/ethash/include/ethash/keccak.h>
 #include <crypto/ethash/include/ethash/progpow.hpp>
 
 #include <crypto/ethash/helpers.hpp>
 #include <crypto/ethash/ethash_test_vectors.hpp>
+#include <hash.h>
+#include <primitives/block.h>
+#include <uint256.h>
 
 #include <array>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
 
 BOOST_FIXTURE_TEST_SUITE(ethash_tests, TestingSetup)
 
@@ -136,6 +148,186 @@ BOOST_AUTO_TEST_CASE(ethash_search)
     auto r = progpow::hash(ctx, 0, {}, 395);
     BOOST_CHECK(sr.final_hash == r.final_hash);
     BOOST_CHECK(sr.hashMix == r.hashMix);
+
+    // A range running past the top of the nonce space stops at UINT64_MAX
+    const uint64_t max_nonce = std::numeric_limits<uint64_t>::max();
+    sr = progpow::search_light(ctxl, 0, {}, ethash::hash256{}, max_nonce - 2, 100);
+    BOOST_CHECK(sr.final_hash == ethash::hash256{});
+    BOOST_CHECK(sr.nonce == 0x0);
+
+    const auto any_boundary = to_hash256("ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
+    sr = progpow::search_light(ctxl, 0, {}, any_boundary, max_nonce, 100);
+    BOOST_CHECK(sr.nonce == max_nonce);
+    BOOST_CHECK(sr.final_hash == progpow::hash(ctx, 0, {}, max_nonce).final_hash);
+}
+
+BOOST_AUTO_TEST_CASE(ethash_uint256_conversion)
+{
+    const uint256 value = uint256S("ffeeddccbbaa9988776655443322110000112233445566778899aabbccddeeff");
+    const auto hash = ToEthashHash(value);
+
+    // Must match the hex round-trip previously used by ETHash()
+    BOOST_CHECK(hash == to_hash256(value.GetHex()));
+    BOOST_CHECK_EQUAL(to_hex(hash), value.GetHex());
+    BOOST_CHECK(FromEthashHash(hash) == value);
+    BOOST_CHECK(FromEthashHash(hash) == uint256S(to_hex(hash)));
+
+    for (auto& t : ethash_hash_test_cases) {
+        const auto header_hash = to_hash256(t.headerHash);
+        BOOST_CHECK(ToEthashHash(FromEthashHash(header_hash)) == header_hash);
+        BOOST_CHECK_EQUAL(FromEthashHash(header_hash).GetHex(), t.headerHash);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ethash_global_context_cache)
+{
+    const auto before = ethash::get_global_epoch_context_cache_stats();
+
+    // Threads alternating between two epochs must not rebuild the contexts
+    constexpr int num_threads = 4;
+    constexpr int num_lookups = 10;
+    std::atomic<bool> mismatch{false};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([t, &mismatch] {
+            for (int i = 0; i < num_lookups; ++i) {
+                const int epoch = (i + t) % 2;
+                if (ethash::get_global_epoch_context(epoch).epoch_number != epoch) mismatch = true;
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    BOOST_CHECK(!mismatch);
+
+    const auto after = ethash::get_global_epoch_context_cache_stats();
+    BOOST_CHECK(after.builds - before.builds <= 2);
+    BOOST_CHECK_EQUAL((after.hits + after.misses) - (before.hits + before.misses), uint64_t{num_threads * num_lookups});
+    BOOST_CHECK(after.cached_epochs >= 2);
+    BOOST_CHECK(after.cached_epochs <= after.capacity);
+}
+
+BOOST_AUTO_TEST_CASE(ethash_prepare_global_context)
+{
+    const auto before = ethash::get_global_epoch_context_cache_stats();
+
+    // A lookup racing the background build does not build the context again
+    ethash::prepare_global_epoch_context(2);
+    BOOST_CHECK_EQUAL(ethash::get_global_epoch_context(2).epoch_number, 2);
+    const auto after = ethash::get_global_epoch_context_cache_stats();
+    BOOST_CHECK_EQUAL(after.builds - before.builds, 1U);
+
+    // Preparing a cached epoch does nothing
+    ethash::prepare_global_epoch_context(2);
+    BOOST_CHECK_EQUAL(ethash::get_global_epoch_context(2).epoch_number, 2);
+    BOOST_CHECK_EQUAL(ethash::get_global_epoch_context_cache_stats().builds, after.builds);
+}
+
+BOOST_AUTO_TEST_CASE(ethash_keccakf800_8way_matches_scalar)
+{
+    // The context has already selected an implementation, this checks it
+    // against the scalar permutation on inputs other than the self-test's.
+    uint32_t states[8][25];
+    uint32_t expected[8][25];
+    for (uint32_t i = 0; i < 8; ++i) {
+        for (uint32_t j = 0; j < 25; ++j) {
+            states[i][j] = expected[i][j] = InsecureRand32();
+        }
+        ethash_keccakf800(expected[i]);
+    }
+    ethash_keccakf800_8way(states);
+    BOOST_CHECK(memcmp(states, expected, sizeof(states)) == 0);
+}
+
+BOOST_AUTO_TEST_CASE(ethash_hash_no_verify_8way_matches_scalar)
+{
+    ethash::hash256 header_hashes[8];
+    ethash::hash256 hash_mixes[8];
+    uint64_t nonces[8];
+    for (int i = 0; i < 8; ++i) {
+        header_hashes[i] = ToEthashHash(InsecureRand256());
+        hash_mixes[i] = ToEthashHash(InsecureRand256());
+        nonces[i] = InsecureRandBits(64);
+    }
+
+    ethash::hash256 final_hashes[8];
+    progpow::hash_no_verify_8way(header_hashes, hash_mixes, nonces, final_hashes);
+    for (int i = 0; i < 8; ++i) {
+        BOOST_CHECK(final_hashes[i] == progpow::hash_no_verify(0, header_hashes[i], hash_mixes[i], nonces[i]));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ethash_batch_hash)
+{
+    // Cover a full group of eight and a partial one
+    std::vector<CBlockHeader> headers(11);
+    for (auto& header : headers) {
+        header.nVersion = InsecureRand32();
+        header.hashPrevBlock = InsecureRand256();
+        header.hashMerkleRoot = InsecureRand256();
+        header.nTime = InsecureRand32();
+        header.nBits = InsecureRand32();
+        header.nHeight = InsecureRandRange(100000);
+        header.nNonce = InsecureRandBits(64);
+        header.hashMix = InsecureRand256();
+    }
+
+    const std::vector<uint256> hashes{ETHash(headers)};
+    BOOST_REQUIRE_EQUAL(hashes.size(), headers.size());
+    for (size_t i = 0; i < headers.size(); ++i) {
+        BOOST_CHECK_EQUAL(hashes[i], headers[i].GetHash());
+    }
+    BOOST_CHECK(ETHash(std::vector<CBlockHeader>{}).empty());
+}
+
+BOOST_AUTO_TEST_CASE(ethash_full_context_with_dataset)
+{
+    // A dataset provided by the caller is filled in when hit, like an owned one
+    const int num_items = ethash::calculate_full_dataset_num_items(0);
+    std::unique_ptr<ethash::hash1024, decltype(&std::free)> dataset{
+        static_cast<ethash::hash1024*>(std::calloc(num_items, sizeof(ethash::hash1024))), &std::free};
+    BOOST_REQUIRE(dataset);
+    ethash::epoch_context_full_ptr context{ethash_create_epoch_context_full_with_dataset(0, dataset.get()),
+                                           ethash_destroy_epoch_context_full};
+    BOOST_REQUIRE(context);
+
+    const auto& light_context = get_ethash_epoch_context_0();
+    const auto header_hash = to_hash256(ethash_hash_test_cases[0].headerHash);
+    for (uint64_t nonce = 0; nonce < 4; ++nonce) {
+        const auto r = progpow::hash(*context, 0, header_hash, nonce);
+        const auto r_light = progpow::hash(light_context, 0, header_hash, nonce);
+        BOOST_CHECK(r.final_hash == r_light.final_hash);
+        BOOST_CHECK(r.hashMix == r_light.hashMix);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ethash_full_context_lazy_threads)
+{
+    // Threads filling in the same items of a lazy dataset all see complete items
+    const auto context = ethash::create_epoch_context_full(0);
+    BOOST_REQUIRE(context);
+    const auto& light_context = get_ethash_epoch_context_0();
+    const auto header_hash = to_hash256(ethash_hash_test_cases[0].headerHash);
+
+    constexpr int num_threads{4};
+    constexpr uint64_t num_nonces{8};
+    std::vector<std::vector<progpow::result>> results(num_threads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&, t] {
+            for (uint64_t nonce = 0; nonce < num_nonces; ++nonce) {
+                results[t].push_back(progpow::hash(*context, 0, header_hash, nonce));
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    for (uint64_t nonce = 0; nonce < num_nonces; ++nonce) {
+        const auto r_light = progpow::hash(light_context, 0, header_hash, nonce);
+        for (const auto& thread_results : results) {
+            BOOST_CHECK(thread_results[nonce].final_hash == r_light.final_hash);
+            BOOST_CHECK(thread_results[nonce].hashMix == r_light.hashMix);
+        }
+    }
 }
 
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
@@ -0,0 +1,127 @@
+// Copyright (c) 2024 The Griffion Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <flatnodemap.h>
+
+#include <test/util/random.h>
+#include <test/util/setup_common.h>
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+/** Hasher with few distinct values, so that lookups have to probe past full groups. */
+struct CollidingHasher {
+    size_t operator()(uint64_t key) const { return (key % 37) * 0x9e3779b97f4a7c15; }
+};
+
+template <typename Hash>
+using TestMap = FlatNodeMap<uint64_t, uint64_t, Hash, std::equal_to<uint64_t>, std::allocator<std::pair<const uint64_t, uint64_t>>>;
+
+template <typename Hash>
+void CheckEqual(const TestMap<Hash>& map, const std::map<uint64_t, uint64_t>& expected)
+{
+    BOOST_REQUIRE_EQUAL(map.size(), expected.size());
+    size_t count{0};
+    for (const auto& [key, value] : map) {
+        const auto it{expected.find(key)};
+        BOOST_REQUIRE(it != expected.end());
+        BOOST_CHECK_EQUAL(value, it->second);
+        ++count;
+    }
+    BOOST_CHECK_EQUAL(count, expected.size());
+}
+
+template <typename Hash>
+void RandomOperations(FastRandomContext& rng, uint64_t key_range)
+{
+    TestMap<Hash> map{0};
+    std::map<uint64_t, uint64_t> expected;
+    for (int i = 0; i < 20000; ++i) {
+        const uint64_t key{rng.randrange(key_range)};
+        switch (rng.randrange(4)) {
+        case 0:
+        case 1: {
+            const uint64_t value{rng.rand64()};
+            const auto [it, inserted]{map.try_emplace(key, value)};
+            const auto [expected_it, expected_inserted]{expected.try_emplace(key, value)};
+            BOOST_CHECK_EQUAL(inserted, expected_inserted);
+            BOOST_CHECK_EQUAL(it->second, expected_it->second);
+            break;
+        }
+        case 2:
+            BOOST_CHECK_EQUAL(map.erase(key), expected.erase(key));
+            break;
+        case 3: {
+            const auto it{map.find(key)};
+            const auto expected_it{expected.find(key)};
+            BOOST_REQUIRE_EQUAL(it == map.end(), expected_it == expected.end());
+            if (it != map.end()) BOOST_CHECK_EQUAL(it->second, expected_it->second);
+            break;
+        }
+        }
+    }
+    CheckEqual(map, expected);
+}
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(flatnodemap_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(flatnodemap_random)
+{
+    FastRandomContext rng{/*fDeterministic=*/true};
+    RandomOperations<std::hash<uint64_t>>(rng, 1000);
+    RandomOperations<std::hash<uint64_t>>(rng, 100000);
+    RandomOperations<CollidingHasher>(rng, 1000);
+}
+
+BOOST_AUTO_TEST_CASE(flatnodemap_erase_while_iterating)
+{
+    TestMap<CollidingHasher> map{0};
+    std::map<uint64_t, uint64_t> expected;
+    for (uint64_t key = 0; key < 1000; ++key) {
+        map.try_emplace(key, key * 2);
+        expected.emplace(key, key * 2);
+    }
+    for (auto it = map.begin(); it != map.end();) {
+        if (it->first % 3 == 0) {
+            expected.erase(it->first);
+            it = map.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    CheckEqual(map, expected);
+
+    map.clear();
+    BOOST_CHECK(map.empty());
+    BOOST_CHECK(map.begin() == map.end());
+}
+
+BOOST_AUTO_TEST_CASE(flatnodemap_stable_references)
+{
+    TestMap<std::hash<uint64_t>> map{0};
+    const uint64_t* value{&map[7]};
+    for (uint64_t key = 100; key < 10000; ++key) {
+        map[key] = key;
+    }
+    BOOST_CHECK(value == &map.at(7));
+    BOOST_CHECK_THROW(map.at(8), std::out_of_range);
+
+    // Reserving up front avoids growing the index while inserting
+    TestMap<std::hash<uint64_t>> reserved{1000};
+    const size_t bucket_count{reserved.bucket_count()};
+    for (uint64_t key = 0; key < 1000; ++key) {
+        reserved[key] = key;
+    }
+    BOOST_CHECK_EQUAL(reserved.bucket_count(), bucket_count);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
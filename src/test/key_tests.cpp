@@ -345,6 +345,54 @@ BOOST_AUTO_TEST_CASE(bip340_test_vectors)
     }
 }
 
+BOOST_AUTO_TEST_CASE(schnorr_signature_batch)
+{
+    std::vector<CKey> keys(8);
+    for (CKey& key : keys) key.MakeNewKey(true);
+    const auto sign{[&](const CKey& key, const uint256& msg) {
+        std::vector<unsigned char> sig(64);
+        BOOST_REQUIRE(key.SignSchnorr(msg, sig, nullptr, InsecureRand256()));
+        return sig;
+    }};
+
+    SchnorrSignatureBatch batch;
+    BOOST_CHECK(batch.Verify());
+    for (int i = 0; i < 20; ++i) {
+        const CKey& key{keys[i % keys.size()]};
+        const uint256 msg{InsecureRand256()};
+        batch.Add(XOnlyPubKey{key.GetPubKey()}, msg, sign(key, msg));
+    }
+    BOOST_CHECK_EQUAL(batch.size(), 20U);
+    BOOST_CHECK(batch.Verify());
+    BOOST_CHECK_EQUAL(batch.size(), 0U);
+
+    // A single invalid signature fails the batch, and only that batch
+    const uint256 msg{InsecureRand256()};
+    std::vector<unsigned char> sig{sign(keys[0], msg)};
+    batch.Add(XOnlyPubKey{keys[0].GetPubKey()}, msg, sig);
+    batch.Add(XOnlyPubKey{keys[1].GetPubKey()}, msg, sig);
+    BOOST_CHECK(!batch.Verify());
+    batch.Add(XOnlyPubKey{keys[0].GetPubKey()}, msg, sig);
+    BOOST_CHECK(batch.Verify());
+    sig[10] ^= 1;
+    batch.Add(XOnlyPubKey{keys[0].GetPubKey()}, msg, sig);
+    BOOST_CHECK(!batch.Verify());
+
+    // So does a public key that is not on the curve
+    const std::vector<unsigned char> not_on_curve(32, 0xff);
+    batch.Add(XOnlyPubKey{not_on_curve}, msg, sign(keys[0], msg));
+    BOOST_CHECK(!batch.Verify());
+
+    // Batches that outgrow MAX_SIZE are verified in parts, and remember earlier failures
+    for (size_t i = 0; i < SchnorrSignatureBatch::MAX_SIZE + 5; ++i) {
+        const CKey& key{keys[i % keys.size()]};
+        const uint256 msg{InsecureRand256()};
+        batch.Add(XOnlyPubKey{key.GetPubKey()}, i == 3 ? InsecureRand256() : msg, sign(key, msg));
+    }
+    BOOST_CHECK_EQUAL(batch.size(), 5U);
+    BOOST_CHECK(!batch.Verify());
+}
+
 BOOST_AUTO_TEST_CASE(key_ellswift)
 {
     for (const auto& secret : {strSecret1, strSecret2, strSecret1C, strSecret2C}) {
@@ -4,6 +4,8 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <addresstype.h>
+#include <arith_uint256.h>
+#include <chainparams.h>
 #include <coins.h>
 #include <common/system.h>
 #include <consensus/consensus.h>
@@ -15,6 +17,7 @@
 #include <test/util/txmempool.h>
 #include <txmempool.h>
 #include <uint256.h>
+#include <util/signalinterrupt.h>
 #include <util/strencodings.h>
 #include <util/time.h>
 #include <validation.h>
@@ -392,8 +395,32 @@ void MinerTestingSetup::TestBasicMining(const CScript& scriptPubKey, const std::
         tx.vout[0].nValue -= LOWFEE;
         hash = tx.GetHash();
         tx_mempool.addUnchecked(entry.Fee(LOWFEE).Time(Now<NodeSeconds>()).SpendsCoinbase(false).FromTx(tx));
-        // Should throw block-validation-failed
-        BOOST_CHECK_EXCEPTION(AssemblerForTest(tx_mempool).CreateNewBlock(scriptPubKey), std::runtime_error, HasReason("block-validation-failed"));
+        // The scripts of transactions in the mempool are not checked again when
+        // the template is created, so only checking the template without
+        // trusting the mempool finds the invalid one
+        const auto invalid_template{AssemblerForTest(tx_mempool).CreateNewBlock(scriptPubKey)};
+        BOOST_REQUIRE(invalid_template);
+        BlockValidationState state;
+        BOOST_CHECK(!TestBlockValidity(state, m_node.chainman->GetParams(), m_node.chainman->ActiveChainstate(), invalid_template->block,
+                                       m_node.chainman->ActiveChain().Tip(), /*fCheckPOW=*/false, /*fCheckMerkleRoot=*/false));
+        BOOST_CHECK_EQUAL(state.GetRejectReason(), "block-validation-failed");
+        // The mempool is only trusted for the transactions it holds, so a block
+        // with another invalid spend of the same output is still rejected
+        CBlock other_block{invalid_template->block};
+        bool replaced{false};
+        for (CTransactionRef& block_tx : other_block.vtx) {
+            if (block_tx->GetHash() != hash) continue;
+            CMutableTransaction other_tx{*block_tx};
+            other_tx.vin[0].scriptSig = CScript() << OP_0 << std::vector<unsigned char>(script.begin(), script.end());
+            BOOST_REQUIRE(!tx_mempool.exists(GenTxid::Txid(other_tx.GetHash())));
+            block_tx = MakeTransactionRef(std::move(other_tx));
+            replaced = true;
+        }
+        BOOST_REQUIRE(replaced);
+        state = BlockValidationState{};
+        BOOST_CHECK(!TestBlockValidity(state, m_node.chainman->GetParams(), m_node.chainman->ActiveChainstate(), other_block,
+                                       m_node.chainman->ActiveChain().Tip(), /*fCheckPOW=*/false, /*fCheckMerkleRoot=*/false, &tx_mempool));
+        BOOST_CHECK_EQUAL(state.GetRejectReason(), "block-validation-failed");
 
         // Delete the dummy blocks again.
         while (m_node.chainman->ActiveChain().Tip()->nHeight > nHeight) {
@@ -661,4 +688,52 @@ BOOST_AUTO_TEST_CASE(CreateNewBlock_validity)
     TestPrioritisedMining(scriptPubKey, txFirst);
 }
 
+BOOST_AUTO_TEST_CASE(SolveBlock_threads)
+{
+    const auto consensus = CreateChainParams(ChainType::REGTEST)->GetConsensus();
+    util::SignalInterrupt interrupt;
+
+    CBlockHeader header;
+    header.nVersion = VERSIONBITS_TOP_BITS;
+    header.hashPrevBlock = InsecureRand256();
+    header.hashMerkleRoot = InsecureRand256();
+    header.nTime = 1700000000;
+    header.nBits = UintToArith256(consensus.powLimit).GetCompact();
+    header.nHeight = 1;
+
+    // The lowest solution is found regardless of the number of threads
+    CBlockHeader solved_single{header};
+    uint64_t tries_single{1000};
+    BOOST_REQUIRE(node::SolveBlock(solved_single, consensus, /*threads=*/1, tries_single, interrupt));
+    BOOST_CHECK(CheckProofOfWork(solved_single.GetHash(), solved_single.nBits, consensus));
+    BOOST_CHECK(CheckProofOfWorkMix(solved_single, consensus));
+    BOOST_CHECK_EQUAL(tries_single, 1000 - solved_single.nNonce);
+    for (uint64_t nonce = 0; nonce < solved_single.nNonce; ++nonce) {
+        CBlockHeader unsolved{header};
+        unsolved.nNonce = nonce;
+        uint256 hash_mix;
+        BOOST_CHECK(!CheckProofOfWork(unsolved.GetHash(hash_mix), unsolved.nBits, consensus));
+    }
+
+    CBlockHeader solved_multi{header};
+    uint64_t tries_multi{1000};
+    BOOST_REQUIRE(node::SolveBlock(solved_multi, consensus, /*threads=*/4, tries_multi, interrupt));
+    BOOST_CHECK_EQUAL(solved_multi.nNonce, solved_single.nNonce);
+    BOOST_CHECK_EQUAL(solved_multi.hashMix, solved_single.hashMix);
+    BOOST_CHECK_EQUAL(tries_multi, tries_single);
+    BOOST_CHECK(node::GetLastSolveHashRate().has_value());
+
+    // Nothing is tried without tries left or once interrupted
+    CBlockHeader unsolved{header};
+    uint64_t no_tries{0};
+    BOOST_CHECK(!node::SolveBlock(unsolved, consensus, /*threads=*/4, no_tries, interrupt));
+    BOOST_CHECK_EQUAL(unsolved.nNonce, 0U);
+
+    uint64_t tries{1000};
+    BOOST_REQUIRE(interrupt());
+    BOOST_CHECK(!node::SolveBlock(unsolved, consensus, /*threads=*/4, tries, interrupt));
+    BOOST_CHECK_EQUAL(tries, 1000U);
+    BOOST_CHECK_EQUAL(unsolved.nNonce, 0U);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
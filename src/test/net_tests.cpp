@@ -31,7 +31,9 @@
 #include <ios>
 #include <memory>
 #include <optional>
+#include <set>
 #include <string>
+#include <vector>
 
 using namespace std::literals;
 
@@ -1047,8 +1049,8 @@ class V2TransportTester
 
 public:
     /** Construct a tester object. test_initiator: whether the tested transport is initiator. */
-    explicit V2TransportTester(bool test_initiator)
-        : m_transport{0, test_initiator},
+    explicit V2TransportTester(bool test_initiator, std::shared_ptr<RecvBufferPool> recv_pool = nullptr)
+        : m_transport{0, test_initiator, std::move(recv_pool)},
           m_cipher{GenerateRandomTestKey(), MakeByteSpan(InsecureRand256())},
           m_test_initiator(test_initiator) {}
 
@@ -1350,7 +1352,7 @@ BOOST_AUTO_TEST_CASE(v2transport_test)
 {
     // A mostly normal scenario, testing a transport in initiator mode.
     for (int i = 0; i < 10; ++i) {
-        V2TransportTester tester(true);
+        V2TransportTester tester(true, i % 2 ? std::make_shared<RecvBufferPool>() : nullptr);
         auto ret = tester.Interact();
         BOOST_REQUIRE(ret && ret->empty());
         tester.SendKey();
@@ -1391,7 +1393,7 @@ BOOST_AUTO_TEST_CASE(v2transport_test)
 
     // Normal scenario, with a transport in responder node.
     for (int i = 0; i < 10; ++i) {
-        V2TransportTester tester(false);
+        V2TransportTester tester(false, i % 2 ? std::make_shared<RecvBufferPool>() : nullptr);
         tester.SendKey();
         tester.SendGarbage();
         auto ret = tester.Interact();
@@ -1565,4 +1567,140 @@ BOOST_AUTO_TEST_CASE(v2transport_test)
     }
 }
 
+BOOST_AUTO_TEST_CASE(recv_buffer_pool_test)
+{
+    RecvBufferPool pool;
+    DataStream buffer{pool.Get(100000)};
+    BOOST_CHECK_GE(buffer.capacity(), 100000U);
+    buffer.resize(100000);
+    const auto* data{buffer.data()};
+    pool.Release(std::move(buffer));
+
+    // A released buffer is handed out, empty, for any size of its class
+    DataStream reused{pool.Get(70000)};
+    BOOST_CHECK(reused.empty());
+    BOOST_CHECK(reused.data() == data);
+    BOOST_CHECK(pool.Get(70000).data() != data);
+
+    // Buffers below the smallest size class are not rounded up or pooled
+    DataStream small{pool.Get(100)};
+    BOOST_CHECK_LT(small.capacity(), RecvBufferPool::MIN_CLASS_SIZE);
+
+    // The free buffers kept per class are limited, so only the first two of
+    // these are kept and the third is freed
+    std::vector<DataStream> large(3);
+    std::set<const std::byte*> kept_data;
+    for (auto& buffer : large) buffer = pool.Get(MAX_PROTOCOL_MESSAGE_LENGTH);
+    for (size_t i = 0; i < RecvBufferPool::MAX_CLASS_BYTES / (4 << 20); ++i) kept_data.insert(large[i].data());
+    for (auto& buffer : large) pool.Release(std::move(buffer));
+    size_t reused_count{0};
+    for (auto& buffer : large) {
+        buffer = pool.Get(MAX_PROTOCOL_MESSAGE_LENGTH);
+        reused_count += kept_data.count(buffer.data());
+    }
+    BOOST_CHECK_EQUAL(reused_count, kept_data.size());
+
+    // A V1 transport receives into pooled buffers, growing them as more of a message arrives
+    const auto recv_pool{std::make_shared<RecvBufferPool>()};
+    V1Transport sender{0};
+    V1Transport receiver{0, recv_pool};
+    for (const size_t size : {300000, 10, 0, 1000000}) {
+        const auto payload{g_insecure_rand_ctx.randbytes<uint8_t>(size)};
+        CSerializedNetMsg msg;
+        msg.m_type = NetMsgType::BLOCK;
+        msg.data = payload;
+        BOOST_REQUIRE(sender.SetMessageToSend(msg));
+        std::vector<uint8_t> wire;
+        while (true) {
+            const auto& [bytes, more, msg_type]{sender.GetBytesToSend(/*have_next_message=*/false)};
+            if (bytes.empty()) break;
+            wire.insert(wire.end(), bytes.begin(), bytes.end());
+            sender.MarkBytesSent(bytes.size());
+        }
+        Span<const uint8_t> remaining{wire};
+        while (!remaining.empty()) {
+            Span<const uint8_t> chunk{remaining.first(std::min<size_t>(remaining.size(), 50000))};
+            const size_t chunk_size{chunk.size()};
+            BOOST_REQUIRE(receiver.ReceivedBytes(chunk));
+            remaining = remaining.subspan(chunk_size - chunk.size());
+        }
+        BOOST_REQUIRE(receiver.ReceivedMessageComplete());
+        bool reject_message{true};
+        CNetMessage received{receiver.GetReceivedMessage(0us, reject_message)};
+        BOOST_CHECK(!reject_message);
+        BOOST_CHECK_EQUAL(received.m_type, NetMsgType::BLOCK);
+        BOOST_CHECK(MakeUCharSpan(received.m_recv) == Span<const uint8_t>{payload});
+        recv_pool->Release(std::move(received.m_recv));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(recv_flood_size_test)
+{
+    // Messages waiting to be processed are counted with the buffers holding
+    // them, so neither many small messages nor one message in a rounded up
+    // pooled buffer can hold much more than the receive flood size.
+    const size_t flood_size{100000};
+    const auto recv_pool{std::make_shared<RecvBufferPool>()};
+    const auto make_node{[&] {
+        return std::make_unique<CNode>(/*id=*/0,
+                                       /*sock=*/nullptr,
+                                       CAddress{},
+                                       /*nKeyedNetGroupIn=*/0,
+                                       /*nLocalHostNonceIn=*/0,
+                                       CAddress{},
+                                       /*pszDest=*/std::string{},
+                                       ConnectionType::INBOUND,
+                                       /*inbound_onion=*/false,
+                                       CNodeOptions{.recv_flood_size = flood_size, .recv_buffer_pool = recv_pool});
+    }};
+    const auto serialize{[](size_t payload_size) {
+        V1Transport sender{0};
+        CSerializedNetMsg msg;
+        msg.m_type = NetMsgType::PING;
+        msg.data.resize(payload_size);
+        BOOST_REQUIRE(sender.SetMessageToSend(msg));
+        std::vector<uint8_t> wire;
+        while (true) {
+            const auto& [bytes, more, msg_type]{sender.GetBytesToSend(/*have_next_message=*/false)};
+            if (bytes.empty()) break;
+            wire.insert(wire.end(), bytes.begin(), bytes.end());
+            sender.MarkBytesSent(bytes.size());
+        }
+        return wire;
+    }};
+
+    // Many tiny messages pause receiving once their wire size exceeds the flood size
+    {
+        auto node{make_node()};
+        const auto wire{serialize(8)};
+        size_t received{0};
+        while (!node->fPauseRecv) {
+            bool complete{false};
+            BOOST_REQUIRE(node->ReceiveMsgBytes(wire, complete));
+            BOOST_REQUIRE(complete);
+            node->MarkReceivedMsgsForProcessing();
+            ++received;
+            BOOST_REQUIRE_LE((received - 1) * wire.size(), flood_size);
+        }
+        BOOST_CHECK_GT(received * wire.size(), flood_size);
+        // Processing the queued messages resumes receiving
+        while (node->PollMessage()) {}
+        BOOST_CHECK(!node->fPauseRecv);
+    }
+
+    // A single message below the flood size, but in a larger pooled buffer, pauses receiving
+    {
+        auto node{make_node()};
+        bool complete{false};
+        BOOST_REQUIRE(node->ReceiveMsgBytes(serialize(70000), complete));
+        BOOST_REQUIRE(complete);
+        node->MarkReceivedMsgsForProcessing();
+        BOOST_CHECK(node->fPauseRecv);
+        auto msg{node->PollMessage()};
+        BOOST_REQUIRE(msg);
+        BOOST_CHECK_GT(msg->first.m_recv.capacity(), flood_size);
+        BOOST_CHECK(!node->fPauseRecv);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -3,12 +3,21 @@
 // file COPYING or https://www.opensource.org/licenses/mit-license.php.
 
 #include <chainparams.h>
+#include <common/args.h>
+#include <net.h>
+#include <node/blockstorage.h>
 #include <node/miner.h>
 #include <net_processing.h>
+#include <netmessagemaker.h>
 #include <pow.h>
+#include <protocol.h>
+#include <streams.h>
+#include <test/util/net.h>
 #include <test/util/setup_common.h>
 #include <validation.h>
 
+#include <vector>
+
 #include <boost/test/unit_test.hpp>
 
 BOOST_FIXTURE_TEST_SUITE(peerman_tests, RegTestingSetup)
@@ -75,4 +84,128 @@ BOOST_AUTO_TEST_CASE(connections_desirable_service_flags)
     BOOST_CHECK(peerman->GetDesirableServiceFlags(peer_flags) == ServiceFlags(NODE_NETWORK | NODE_WITNESS));
 }
 
+// Blocks requested with getdata are read through the cache of recently served blocks
+BOOST_FIXTURE_TEST_CASE(getdata_block_cache, TestChain100Setup)
+{
+    LOCK(NetEventsInterface::g_msgproc_mutex);
+    auto& connman{static_cast<ConnmanTestMsg&>(*m_node.connman)};
+    auto& blockman{m_node.chainman->m_blockman};
+
+    CNode peer{/*id=*/0,
+               /*sock=*/nullptr,
+               CAddress{},
+               /*nKeyedNetGroupIn=*/0,
+               /*nLocalHostNonceIn=*/0,
+               CAddress{},
+               /*addrNameIn=*/"",
+               ConnectionType::INBOUND,
+               /*inbound_onion=*/false};
+    connman.Handshake(peer,
+                      /*successfully_connected=*/true,
+                      /*remote_services=*/ServiceFlags(NODE_NETWORK | NODE_WITNESS),
+                      /*local_services=*/ServiceFlags(NODE_NETWORK | NODE_WITNESS),
+                      /*version=*/PROTOCOL_VERSION,
+                      /*relay_txs=*/true);
+    connman.FlushSendBuffer(peer);
+    peer.fPauseSend = false;
+
+    std::vector<std::vector<unsigned char>> sent_blocks;
+    m_node.args->ForceSetArg("-capturemessages", "1");
+    const auto CaptureMessageOrig = CaptureMessage;
+    CaptureMessage = [&sent_blocks](const CAddress& addr, const std::string& msg_type, Span<const unsigned char> data, bool is_incoming) {
+        if (!is_incoming && msg_type == NetMsgType::BLOCK) sent_blocks.emplace_back(data.begin(), data.end());
+    };
+
+    // Not the tip, which is served from memory
+    const CBlockIndex& index{*Assert(WITH_LOCK(::cs_main, return m_node.chainman->ActiveChain()[50]))};
+    CBlock block;
+    BOOST_REQUIRE(blockman.ReadBlockFromDisk(block, index));
+    DataStream witness_block, block_no_witness;
+    witness_block << TX_WITH_WITNESS(block);
+    block_no_witness << TX_NO_WITNESS(block);
+
+    // The raw block is sent to peers asking for witness blocks, others get the
+    // deserialized block, which is cached separately in the same entry. Only
+    // the first request of each is a miss.
+    for (const auto& [type, expected] : {std::make_pair(MSG_WITNESS_BLOCK, &witness_block), std::make_pair(MSG_BLOCK, &block_no_witness)}) {
+        for (int i = 0; i < 2; ++i) {
+            const auto stats{blockman.GetBlockCacheStats()};
+            sent_blocks.clear();
+            (void)connman.ReceiveMsgFrom(peer, NetMsg::Make(NetMsgType::GETDATA, std::vector<CInv>{CInv(type, index.GetBlockHash())}));
+            connman.ProcessMessagesOnce(peer);
+            connman.FlushSendBuffer(peer);
+            peer.fPauseSend = false;
+            BOOST_REQUIRE_EQUAL(sent_blocks.size(), 1U);
+            BOOST_CHECK(Span<const unsigned char>{sent_blocks[0]} == MakeUCharSpan(*expected));
+            const auto new_stats{blockman.GetBlockCacheStats()};
+            BOOST_CHECK_EQUAL(new_stats.hits - stats.hits, i == 0 ? 0U : 1U);
+            BOOST_CHECK_EQUAL(new_stats.misses - stats.misses, i == 0 ? 1U : 0U);
+        }
+    }
+    BOOST_CHECK_EQUAL(blockman.GetBlockCacheStats().blocks, 1U);
+
+    CaptureMessage = CaptureMessageOrig;
+    m_node.args->ForceSetArg("-capturemessages", "0");
+    m_node.peerman->FinalizeNode(peer);
+}
+
+// With -requestthreads, getdata is served by a request handler thread, and the
+// peer's further messages wait until it has been served
+BOOST_FIXTURE_TEST_CASE(getdata_request_threads, TestChain100Setup)
+{
+    LOCK(NetEventsInterface::g_msgproc_mutex);
+    auto& connman{static_cast<ConnmanTestMsg&>(*m_node.connman)};
+    connman.SetRequestThreads(1);
+
+    CNode peer{/*id=*/0,
+               /*sock=*/nullptr,
+               CAddress{},
+               /*nKeyedNetGroupIn=*/0,
+               /*nLocalHostNonceIn=*/0,
+               CAddress{},
+               /*addrNameIn=*/"",
+               ConnectionType::INBOUND,
+               /*inbound_onion=*/false};
+    connman.Handshake(peer,
+                      /*successfully_connected=*/true,
+                      /*remote_services=*/ServiceFlags(NODE_NETWORK | NODE_WITNESS),
+                      /*local_services=*/ServiceFlags(NODE_NETWORK | NODE_WITNESS),
+                      /*version=*/PROTOCOL_VERSION,
+                      /*relay_txs=*/true);
+    connman.FlushSendBuffer(peer);
+    peer.fPauseSend = false;
+
+    std::vector<std::string> sent;
+    m_node.args->ForceSetArg("-capturemessages", "1");
+    const auto CaptureMessageOrig = CaptureMessage;
+    CaptureMessage = [&sent](const CAddress& addr, const std::string& msg_type, Span<const unsigned char> data, bool is_incoming) {
+        if (!is_incoming) sent.push_back(msg_type);
+    };
+
+    const uint256 block_hash{WITH_LOCK(::cs_main, return m_node.chainman->ActiveChain()[50]->GetBlockHash())};
+    (void)connman.ReceiveMsgFrom(peer, NetMsg::Make(NetMsgType::GETDATA, std::vector<CInv>{CInv(MSG_WITNESS_BLOCK, block_hash)}));
+    (void)connman.ReceiveMsgFrom(peer, NetMsg::Make(NetMsgType::PING, uint64_t{42}));
+
+    // The message handler only queues the request, and leaves the ping alone
+    // while the request is pending
+    connman.ProcessMessagesOnce(peer);
+    BOOST_CHECK(!connman.ProcessMessagesOnce(peer));
+    BOOST_CHECK(sent.empty());
+
+    // The request thread serves it, then the ping is answered
+    BOOST_CHECK(!connman.ProcessRequestsOnce(peer));
+    BOOST_CHECK(sent == std::vector<std::string>{NetMsgType::BLOCK});
+    BOOST_CHECK(!connman.ProcessRequestsOnce(peer));
+    connman.FlushSendBuffer(peer);
+    peer.fPauseSend = false;
+    connman.ProcessMessagesOnce(peer);
+    BOOST_CHECK((sent == std::vector<std::string>{NetMsgType::BLOCK, NetMsgType::PONG}));
+
+    CaptureMessage = CaptureMessageOrig;
+    m_node.args->ForceSetArg("-capturemessages", "0");
+    connman.FlushSendBuffer(peer);
+    m_node.peerman->FinalizeNode(peer);
+    connman.SetRequestThreads(0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -126,6 +126,37 @@ BOOST_AUTO_TEST_CASE(CheckProofOfWork_test_zero_target)
     BOOST_CHECK(!CheckProofOfWork(hash, nBits, consensus));
 }
 
+BOOST_AUTO_TEST_CASE(CheckProofOfWorkMix_test)
+{
+    const auto consensus = CreateChainParams(ChainType::REGTEST)->GetConsensus();
+    CBlockHeader header;
+    header.nVersion = 4;
+    header.nHeight = 1;
+    header.nTime = 1712232000;
+    header.nBits = UintToArith256(consensus.powLimit).GetCompact();
+    uint256 hashMix;
+    while (!CheckProofOfWork(header.GetHash(hashMix), header.nBits, consensus)) ++header.nNonce;
+    header.hashMix = hashMix;
+    BOOST_CHECK(CheckProofOfWorkMix(header, consensus));
+
+    // Target out of range
+    CBlockHeader bad_bits{header};
+    bad_bits.nBits = 0;
+    BOOST_CHECK(!CheckProofOfWorkMix(bad_bits, consensus));
+
+    // Final hash computed from the claimed mix misses the target
+    CBlockHeader high_hash{header};
+    high_hash.nBits = UintToArith256(uint256S("0x0000000000000000000000000000000000000000000000000000000000000001")).GetCompact();
+    BOOST_CHECK(!CheckProofOfWorkMix(high_hash, consensus));
+
+    // Wrong mix whose final hash still meets the target
+    CBlockHeader bad_mix{header};
+    do {
+        bad_mix.hashMix = InsecureRand256();
+    } while (!CheckProofOfWork(bad_mix.GetHash(), bad_mix.nBits, consensus));
+    BOOST_CHECK(!CheckProofOfWorkMix(bad_mix, consensus));
+}
+
 BOOST_AUTO_TEST_CASE(GetBlockProofEquivalentTime_test)
 {
     const auto chainParams = CreateChainParams(ChainType::MAIN);
@@ -12,6 +12,7 @@
 #include <boost/test/unit_test.hpp>
 
 #include <cassert>
+#include <memory>
 #include <thread>
 
 using namespace std::chrono_literals;
@@ -141,6 +142,53 @@ BOOST_AUTO_TEST_CASE(wait)
     waiter.join();
 }
 
+BOOST_AUTO_TEST_CASE(event_registry)
+{
+    const auto registry{SockEventRegistry::Make()};
+#ifdef USE_EPOLL
+    BOOST_REQUIRE(registry);
+#endif
+    if (!registry) return;
+
+    int s[2];
+    CreateSocketPair(s);
+
+    const auto sock0{std::make_shared<const Sock>(s[0])};
+    const auto sock1{std::make_shared<const Sock>(s[1])};
+    Sock::EventsPerSock events_per_sock;
+
+    BOOST_REQUIRE(registry->Set(sock0, Sock::RECV));
+    BOOST_CHECK_EQUAL(registry->Size(), 1U);
+    BOOST_REQUIRE(registry->Wait(0ms, events_per_sock));
+    BOOST_CHECK(events_per_sock.empty());
+
+    BOOST_REQUIRE_EQUAL(sock1->Send("a", 1, 0), 1);
+    BOOST_REQUIRE(registry->Wait(1min, events_per_sock));
+    BOOST_REQUIRE_EQUAL(events_per_sock.size(), 1U);
+    BOOST_CHECK(events_per_sock.begin()->first == sock0);
+    BOOST_CHECK(events_per_sock.begin()->second.requested == Sock::RECV);
+    BOOST_CHECK(events_per_sock.begin()->second.occurred == Sock::RECV);
+
+    // Changing what to wait for on one socket leaves the other one alone.
+    BOOST_REQUIRE(registry->Set(sock1, Sock::SEND));
+    BOOST_REQUIRE(registry->Set(sock0, Sock::SEND));
+    BOOST_CHECK_EQUAL(registry->Size(), 2U);
+    BOOST_REQUIRE(registry->Wait(1min, events_per_sock));
+    BOOST_CHECK_EQUAL(events_per_sock.size(), 2U);
+    for (const auto& [sock, events] : events_per_sock) {
+        BOOST_CHECK(events.requested == Sock::SEND);
+        BOOST_CHECK(events.occurred == Sock::SEND);
+    }
+
+    // Unregistered sockets are not reported anymore, even though sock0 is still readable.
+    BOOST_REQUIRE(registry->Set(sock0, 0));
+    BOOST_REQUIRE(registry->Set(sock1, 0));
+    BOOST_REQUIRE(registry->Set(sock1, 0));
+    BOOST_CHECK_EQUAL(registry->Size(), 0U);
+    BOOST_REQUIRE(registry->Wait(0ms, events_per_sock));
+    BOOST_CHECK(events_per_sock.empty());
+}
+
 BOOST_AUTO_TEST_CASE(recv_until_terminator_limit)
 {
     constexpr auto timeout = 1min; // High enough so that it is never hit.
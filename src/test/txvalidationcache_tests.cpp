@@ -3,18 +3,29 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <clientversion.h>
 #include <consensus/validation.h>
+#include <crypto/common.h>
+#include <hash.h>
 #include <key.h>
+#include <kernel/validation_cache_persist.h>
 #include <random.h>
+#include <script/sigcache.h>
 #include <script/sign.h>
 #include <script/signingprovider.h>
+#include <test/util/logging.h>
+#include <test/util/random.h>
 #include <test/util/setup_common.h>
+#include <test/util/txmempool.h>
 #include <txmempool.h>
 #include <util/chaintype.h>
 #include <validation.h>
 
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
+#include <cstdio>
+
 struct Dersig100Setup : public TestChain100Setup {
     Dersig100Setup()
         : TestChain100Setup{ChainType::REGTEST, {}} {}
@@ -108,6 +119,37 @@ BOOST_FIXTURE_TEST_CASE(tx_mempool_block_doublespend, Dersig100Setup)
     BOOST_CHECK_EQUAL(m_node.mempool->size(), 0U);
 }
 
+BOOST_FIXTURE_TEST_CASE(test_block_validity_verified_pool, Dersig100Setup)
+{
+    // Spend a mature coinbase with a signature that does not verify
+    CScript scriptPubKey = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    CMutableTransaction spend;
+    spend.nVersion = 2;
+    spend.vin.emplace_back(COutPoint{m_coinbase_txns[0]->GetHash(), 0}, CScript() << OP_0);
+    spend.vout.emplace_back(11 * CENT, scriptPubKey);
+    const CBlock block{CreateBlock({spend}, scriptPubKey, m_node.chainman->ActiveChainstate())};
+
+    LOCK(cs_main);
+    Chainstate& chainstate{m_node.chainman->ActiveChainstate()};
+    CBlockIndex* tip{chainstate.m_chain.Tip()};
+    BlockValidationState state;
+    BOOST_CHECK(!TestBlockValidity(state, chainstate.m_chainman.GetParams(), chainstate, block, tip, /*fCheckPOW=*/false, /*fCheckMerkleRoot=*/true, m_node.mempool.get()));
+    BOOST_CHECK_EQUAL(state.GetRejectReason(), "block-validation-failed");
+
+    // Transactions in the mempool are trusted to have valid scripts. Add the
+    // spend without checking it, to see that its scripts are not checked again.
+    WITH_LOCK(m_node.mempool->cs, m_node.mempool->addUnchecked(TestMemPoolEntryHelper{}.FromTx(spend)));
+    state = BlockValidationState{};
+    BOOST_CHECK(TestBlockValidity(state, chainstate.m_chainman.GetParams(), chainstate, block, tip, /*fCheckPOW=*/false, /*fCheckMerkleRoot=*/true, m_node.mempool.get()));
+    state = BlockValidationState{};
+    BOOST_CHECK(!TestBlockValidity(state, chainstate.m_chainman.GetParams(), chainstate, block, tip, /*fCheckPOW=*/false, /*fCheckMerkleRoot=*/true));
+
+    // The checks do not change the coins tip
+    BOOST_CHECK(chainstate.CoinsTip().GetBestBlock() == tip->GetBlockHash());
+    BOOST_CHECK(chainstate.CoinsTip().HaveCoin(spend.vin[0].prevout));
+    BOOST_CHECK(!chainstate.CoinsTip().HaveCoin(COutPoint{spend.GetHash(), 0}));
+}
+
 // Run CheckInputScripts (using CoinsTip()) on the given transaction, for all script
 // flags.  Test that CheckInputScripts passes for all flags that don't overlap with
 // the failing_flags argument, but otherwise fails.
@@ -371,4 +413,114 @@ BOOST_FIXTURE_TEST_CASE(checkinputs_test, Dersig100Setup)
     }
 }
 
+BOOST_FIXTURE_TEST_CASE(validation_caches_persist, Dersig100Setup)
+{
+    const CScript script_pub_key{CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG};
+    CMutableTransaction spend;
+    spend.nVersion = 2;
+    spend.vin.resize(1);
+    spend.vin[0].prevout = COutPoint{m_coinbase_txns[0]->GetHash(), 0};
+    spend.vout.resize(1);
+    // Differ from the spends of other tests, whose signatures may still be
+    // found in the caches but are not saved.
+    spend.vout[0].nValue = 11 * CENT + InsecureRandRange(CENT);
+    spend.vout[0].scriptPubKey = script_pub_key;
+    std::vector<unsigned char> sig;
+    BOOST_CHECK(coinbaseKey.Sign(SignatureHash(script_pub_key, spend, 0, SIGHASH_ALL, 0, SigVersion::BASE), sig));
+    sig.push_back((unsigned char)SIGHASH_ALL);
+    spend.vin[0].scriptSig << sig;
+    const CTransaction tx{spend};
+
+    const CCoinsViewCache& coins_tip{*WITH_LOCK(cs_main, return &m_node.chainman->ActiveChainstate().CoinsTip())};
+    const auto sorted_entries{[](SaltedCacheEntries cache) {
+        std::sort(cache.entries.begin(), cache.entries.end());
+        return cache;
+    }};
+    // Whether the script of tx is in the script execution cache, without
+    // allowing it to be erased
+    const auto cached{[&] {
+        LOCK(cs_main);
+        TxValidationState state;
+        PrecomputedTransactionData txdata;
+        std::vector<CScriptCheck> checks;
+        BOOST_CHECK(CheckInputScripts(tx, state, coins_tip, SCRIPT_VERIFY_P2SH, true, true, txdata, &checks));
+        return checks.empty();
+    }};
+
+    {
+        LOCK(cs_main);
+        TxValidationState state;
+        PrecomputedTransactionData txdata;
+        BOOST_CHECK(CheckInputScripts(tx, state, coins_tip, SCRIPT_VERIFY_P2SH, true, true, txdata, nullptr));
+    }
+    BOOST_CHECK(cached());
+    const SaltedCacheEntries signature_cache{sorted_entries(GetSignatureCacheEntries())};
+    const SaltedCacheEntries script_execution_cache{sorted_entries(WITH_LOCK(cs_main, return GetScriptExecutionCacheEntries()))};
+    BOOST_CHECK_EQUAL(signature_cache.entries.size(), 1U);
+    BOOST_CHECK_EQUAL(script_execution_cache.entries.size(), 1U);
+
+    const fs::path path{m_path_root / "validationcache.dat"};
+    BOOST_CHECK(kernel::DumpValidationCaches(path, fsbridge::fopen, /*skip_file_commit=*/true));
+
+    // Caches set up anew have a different salt and don't know tx
+    BOOST_CHECK(InitSignatureCache(DEFAULT_MAX_SIG_CACHE_BYTES / 2));
+    BOOST_CHECK(InitScriptExecutionCache(DEFAULT_MAX_SIG_CACHE_BYTES / 2));
+    BOOST_CHECK(GetSignatureCacheEntries().entries.empty());
+    BOOST_CHECK(WITH_LOCK(cs_main, return GetScriptExecutionCacheEntries()).salt != script_execution_cache.salt);
+    BOOST_CHECK(!cached());
+
+    BOOST_CHECK(kernel::LoadValidationCaches(path));
+    BOOST_CHECK(cached());
+    const SaltedCacheEntries loaded_signature_cache{sorted_entries(GetSignatureCacheEntries())};
+    BOOST_CHECK(loaded_signature_cache.salt == signature_cache.salt);
+    BOOST_CHECK(loaded_signature_cache.entries == signature_cache.entries);
+    const SaltedCacheEntries loaded_script_execution_cache{sorted_entries(WITH_LOCK(cs_main, return GetScriptExecutionCacheEntries()))};
+    BOOST_CHECK(loaded_script_execution_cache.salt == script_execution_cache.salt);
+    BOOST_CHECK(loaded_script_execution_cache.entries == script_execution_cache.entries);
+
+    // A file written by another client version is not loaded, even with a valid checksum
+    const auto read_file{[&] {
+        std::vector<unsigned char> contents(fs::file_size(path));
+        FILE* file{fsbridge::fopen(path, "rb")};
+        BOOST_REQUIRE(file);
+        BOOST_REQUIRE_EQUAL(std::fread(contents.data(), 1, contents.size(), file), contents.size());
+        std::fclose(file);
+        return contents;
+    }};
+    const auto write_file{[&](const std::vector<unsigned char>& contents) {
+        FILE* file{fsbridge::fopen(path, "wb")};
+        BOOST_REQUIRE(file);
+        BOOST_REQUIRE_EQUAL(std::fwrite(contents.data(), 1, contents.size(), file), contents.size());
+        std::fclose(file);
+    }};
+    const std::vector<unsigned char> dumped{read_file()};
+    std::vector<unsigned char> other_version{dumped};
+    // The client version follows the 8 byte file format version
+    WriteLE32(other_version.data() + 8, CLIENT_VERSION + 1);
+    const uint256 checksum{Hash(Span{other_version}.first(other_version.size() - uint256::size()))};
+    std::copy(checksum.begin(), checksum.end(), other_version.end() - uint256::size());
+    write_file(other_version);
+    BOOST_CHECK(InitScriptExecutionCache(DEFAULT_MAX_SIG_CACHE_BYTES / 2));
+    {
+        ASSERT_DEBUG_LOG("Validation cache file was written by client version");
+        BOOST_CHECK(!kernel::LoadValidationCaches(path));
+    }
+    BOOST_CHECK(!cached());
+    write_file(dumped);
+
+    // A damaged file is not loaded
+    {
+        FILE* file{fsbridge::fopen(path, "r+b")};
+        BOOST_REQUIRE(file);
+        BOOST_REQUIRE_EQUAL(std::fseek(file, 50, SEEK_SET), 0);
+        const int byte{std::fgetc(file)};
+        BOOST_REQUIRE_EQUAL(std::fseek(file, 50, SEEK_SET), 0);
+        std::fputc(byte ^ 1, file);
+        std::fclose(file);
+    }
+    BOOST_CHECK(InitScriptExecutionCache(DEFAULT_MAX_SIG_CACHE_BYTES / 2));
+    BOOST_CHECK(!kernel::LoadValidationCaches(path));
+    BOOST_CHECK(!cached());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
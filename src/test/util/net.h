@@ -40,6 +40,11 @@ struct ConnmanTestMsg : public CConnman {
         m_peer_connect_timeout = timeout;
     }
 
+    void SetRequestThreads(int request_threads)
+    {
+        m_request_threads = request_threads;
+    }
+
     std::vector<CNode*> TestNodes()
     {
         LOCK(m_nodes_mutex);
@@ -76,6 +81,11 @@ struct ConnmanTestMsg : public CConnman {
         return m_msgproc->ProcessMessages(&node, flagInterruptMsgProc);
     }
 
+    bool ProcessRequestsOnce(CNode& node)
+    {
+        return m_msgproc->ProcessRequests(&node, flagInterruptMsgProc);
+    }
+
     void NodeReceiveMsgBytes(CNode& node, Span<const uint8_t> msg_bytes, bool& complete) const;
 
     bool ReceiveMsgFrom(CNode& node, CSerializedNetMsg&& ser_msg) const;
@@ -191,6 +191,8 @@ ChainTestingSetup::ChainTestingSetup(const ChainType chainType, const std::vecto
         .check_block_index = true,
         .notifications = *m_node.notifications,
         .worker_threads_num = 2,
+        .partial_flush = m_node.args->GetBoolArg("-partialflush", DEFAULT_PARTIAL_FLUSH),
+        .pipelined_connect = m_node.args->GetBoolArg("-pipelinedconnect", DEFAULT_PIPELINED_CONNECT),
     };
     const BlockManager::Options blockman_opts{
         .chainparams = chainman_opts.chainparams,
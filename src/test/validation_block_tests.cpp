@@ -11,25 +11,34 @@
 #include <node/miner.h>
 #include <pow.h>
 #include <random.h>
+#include <test/util/logging.h>
 #include <test/util/random.h>
 #include <test/util/script.h>
 #include <test/util/setup_common.h>
 #include <util/time.h>
 #include <validation.h>
 #include <validationinterface.h>
+#include <versionbits.h>
 
 #include <thread>
 
 using node::BlockAssembler;
 
 namespace validation_block_tests {
-struct MinerTestingSetup : public RegTestingSetup {
+struct MinerTestingSetup : public TestingSetup {
+    explicit MinerTestingSetup(const std::vector<const char*>& extra_args = {})
+        : TestingSetup{ChainType::REGTEST, extra_args} {}
     std::shared_ptr<CBlock> Block(const uint256& prev_hash);
     std::shared_ptr<const CBlock> GoodBlock(const uint256& prev_hash);
     std::shared_ptr<const CBlock> BadBlock(const uint256& prev_hash);
     std::shared_ptr<CBlock> FinalizeBlock(std::shared_ptr<CBlock> pblock);
     void BuildChain(const uint256& root, int height, const unsigned int invalid_rate, const unsigned int branch_rate, const unsigned int max_size, std::vector<std::shared_ptr<const CBlock>>& blocks);
 };
+
+struct PipelinedConnectTestingSetup : public MinerTestingSetup {
+    PipelinedConnectTestingSetup()
+        : MinerTestingSetup{{"-pipelinedconnect"}} {}
+};
 } // namespace validation_block_tests
 
 BOOST_FIXTURE_TEST_SUITE(validation_block_tests, MinerTestingSetup)
@@ -326,6 +335,120 @@ BOOST_AUTO_TEST_CASE(mempool_locks_reorg)
     }
 }
 
+BOOST_FIXTURE_TEST_CASE(pipelined_connect, PipelinedConnectTestingSetup)
+{
+    ChainstateManager& chainman{*Assert(m_node.chainman)};
+    bool ignored;
+    auto ProcessBlock = [&](std::shared_ptr<const CBlock> block) -> bool {
+        return chainman.ProcessNewBlock(block, /*force_processing=*/true, /*min_pow_checked=*/true, /*new_block=*/&ignored);
+    };
+    auto Tip = [&] { return WITH_LOCK(::cs_main, return chainman.ActiveChain().Tip()->GetBlockHash()); };
+    auto Spend = [](const COutPoint& outpoint, CAmount value, bool valid) {
+        CMutableTransaction mtx;
+        mtx.vin.emplace_back(outpoint, CScript{});
+        // The wrong witness script is only caught by the script checks
+        mtx.vin[0].scriptWitness.stack.push_back(valid ? WITNESS_STACK_ELEM_OP_TRUE : std::vector<uint8_t>{OP_FALSE});
+        mtx.vout.emplace_back(value - 1000, P2WSH_OP_TRUE);
+        return MakeTransactionRef(mtx);
+    };
+
+    // Mine blocks whose rewards can be spent
+    std::vector<CTransactionRef> coinbases;
+    auto last_mined = GoodBlock(Params().GenesisBlock().GetHash());
+    BOOST_REQUIRE(ProcessBlock(last_mined));
+    for (int i = 0; i < COINBASE_MATURITY + 12; ++i) {
+        coinbases.push_back(last_mined->vtx[0]);
+        last_mined = GoodBlock(last_mined->GetHash());
+        BOOST_REQUIRE(ProcessBlock(last_mined));
+    }
+
+    // Build a chain whose blocks spend the rewards and the outputs of the
+    // previous block, and optionally an input with an invalid script or one
+    // that does not exist
+    size_t next_coinbase{0};
+    auto BuildSpendingChain = [&](int invalid_index, int missing_index = -1) {
+        std::vector<std::shared_ptr<const CBlock>> blocks;
+        CTransactionRef prev_spend;
+        uint256 prev_hash{Tip()};
+        for (int i = 0; i < 6; ++i) {
+            auto pblock = Block(prev_hash);
+            const CTransactionRef& coinbase{coinbases.at(next_coinbase++)};
+            pblock->vtx.push_back(Spend({coinbase->GetHash(), 1}, coinbase->vout[1].nValue, /*valid=*/i != invalid_index));
+            if (prev_spend) {
+                pblock->vtx.push_back(Spend({prev_spend->GetHash(), 0}, prev_spend->vout[0].nValue, /*valid=*/true));
+                if (i == missing_index) {
+                    // Added last, after the checks of the other inputs were queued
+                    pblock->vtx.push_back(Spend({prev_spend->GetHash(), 1}, prev_spend->vout[0].nValue, /*valid=*/true));
+                }
+            }
+            prev_spend = pblock->vtx[1];
+            blocks.push_back(FinalizeBlock(pblock));
+            prev_hash = blocks.back()->GetHash();
+        }
+        return blocks;
+    };
+    // Submitting the first block last makes them all connect in one step
+    auto SubmitChain = [&](const std::vector<std::shared_ptr<const CBlock>>& blocks) {
+        for (auto it = blocks.rbegin(); it != blocks.rend(); ++it) {
+            ProcessBlock(*it);
+        }
+    };
+
+    // A valid chain is connected
+    const auto good_chain{BuildSpendingChain(/*invalid_index=*/-1)};
+    {
+        ASSERT_DEBUG_LOG("Connect 6 blocks pipelined");
+        SubmitChain(good_chain);
+    }
+    BOOST_CHECK_EQUAL(Tip(), good_chain.back()->GetHash());
+    {
+        LOCK(::cs_main);
+        for (const auto& block : good_chain) {
+            BOOST_CHECK(chainman.m_blockman.LookupBlockIndex(block->GetHash())->IsValid(BLOCK_VALID_SCRIPTS));
+        }
+        BOOST_CHECK_EQUAL(chainman.ActiveChainstate().CoinsTip().GetBestBlock(), good_chain.back()->GetHash());
+    }
+
+    // A chain with an invalid script is rolled back to the block before it
+    const auto bad_chain{BuildSpendingChain(/*invalid_index=*/3)};
+    {
+        ASSERT_DEBUG_LOG(strprintf("script verification of blocks %s to %s failed",
+                                   bad_chain.front()->GetHash().ToString(), bad_chain.back()->GetHash().ToString()));
+        SubmitChain(bad_chain);
+    }
+    BOOST_CHECK_EQUAL(Tip(), bad_chain[2]->GetHash());
+    {
+        LOCK(::cs_main);
+        BOOST_CHECK(chainman.m_blockman.LookupBlockIndex(bad_chain[3]->GetHash())->nStatus & BLOCK_FAILED_VALID);
+        BOOST_CHECK(!chainman.m_blockman.LookupBlockIndex(bad_chain[4]->GetHash())->IsValid(BLOCK_VALID_SCRIPTS));
+        CCoinsViewCache& coins{chainman.ActiveChainstate().CoinsTip()};
+        BOOST_CHECK_EQUAL(coins.GetBestBlock(), bad_chain[2]->GetHash());
+        // Nothing of the invalid block and the ones after it was applied
+        BOOST_CHECK(coins.HaveCoin({bad_chain[2]->vtx[1]->GetHash(), 0}));
+        BOOST_CHECK(coins.HaveCoin({bad_chain[2]->vtx[2]->GetHash(), 0}));
+        BOOST_CHECK(!coins.HaveCoin({bad_chain[3]->vtx[2]->GetHash(), 0}));
+        BOOST_CHECK(!coins.HaveCoin({bad_chain[4]->vtx[2]->GetHash(), 0}));
+    }
+
+    // A chain with a block that fails in ConnectBlock() itself, while the
+    // script checks of it and the blocks before are still queued
+    const auto missing_chain{BuildSpendingChain(/*invalid_index=*/-1, /*missing_index=*/3)};
+    {
+        ASSERT_DEBUG_LOG(strprintf("ConnectTipsPipelined: ConnectBlock %s failed", missing_chain[3]->GetHash().ToString()));
+        SubmitChain(missing_chain);
+    }
+    BOOST_CHECK_EQUAL(Tip(), missing_chain[2]->GetHash());
+    {
+        LOCK(::cs_main);
+        BOOST_CHECK(chainman.m_blockman.LookupBlockIndex(missing_chain[2]->GetHash())->IsValid(BLOCK_VALID_SCRIPTS));
+        BOOST_CHECK(chainman.m_blockman.LookupBlockIndex(missing_chain[3]->GetHash())->nStatus & BLOCK_FAILED_VALID);
+        CCoinsViewCache& coins{chainman.ActiveChainstate().CoinsTip()};
+        BOOST_CHECK_EQUAL(coins.GetBestBlock(), missing_chain[2]->GetHash());
+        BOOST_CHECK(coins.HaveCoin({missing_chain[2]->vtx[2]->GetHash(), 0}));
+        BOOST_CHECK(!coins.HaveCoin({missing_chain[3]->vtx[2]->GetHash(), 0}));
+    }
+}
+
 BOOST_AUTO_TEST_CASE(witness_commitment_index)
 {
     LOCK(Assert(m_node.chainman)->GetMutex());
@@ -360,4 +483,57 @@ BOOST_AUTO_TEST_CASE(witness_commitment_index)
 
     BOOST_CHECK_EQUAL(GetWitnessCommitmentIndex(pblock), 2);
 }
+
+BOOST_AUTO_TEST_CASE(processnewblockheaders_batch_pow)
+{
+    ChainstateManager& chainman{*Assert(m_node.chainman)};
+    const CBlockIndex* tip{WITH_LOCK(::cs_main, return chainman.ActiveChain().Tip())};
+
+    // Build a chain of headers on top of the tip
+    std::vector<CBlockHeader> headers;
+    uint256 prev_hash{tip->GetBlockHash()};
+    for (int i = 1; i <= 8; ++i) {
+        CBlockHeader header;
+        header.nVersion = VERSIONBITS_TOP_BITS;
+        header.nHeight = tip->nHeight + i;
+        header.hashPrevBlock = prev_hash;
+        header.hashMerkleRoot = uint256{static_cast<uint8_t>(i)};
+        header.nTime = tip->GetBlockTime() + i;
+        header.nBits = tip->nBits;
+        uint256 hashMix;
+        while (!CheckProofOfWork(header.GetHash(hashMix), header.nBits, Params().GetConsensus())) {
+            ++header.nNonce;
+        }
+        header.hashMix = hashMix;
+        prev_hash = header.GetHash();
+        headers.push_back(header);
+    }
+
+    // A batch with an invalid last header fails the parallel check. The valid
+    // prefix is accepted and the invalid header is reported with the reason
+    // found by the worker.
+    std::vector<CBlockHeader> bad_headers{headers};
+    bad_headers.back().hashMix = uint256::ONE;
+    BlockValidationState state;
+    BOOST_CHECK(!chainman.ProcessNewBlockHeaders(bad_headers, /*min_pow_checked=*/true, state));
+    BOOST_CHECK(state.GetResult() == BlockValidationResult::BLOCK_INVALID_HEADER);
+    BOOST_CHECK(state.GetRejectReason() == "high-hash" || state.GetRejectReason() == "invalid-hash-mix");
+    BOOST_CHECK(WITH_LOCK(::cs_main, return chainman.m_blockman.LookupBlockIndex(headers[6].GetHash())) != nullptr);
+    BOOST_CHECK(WITH_LOCK(::cs_main, return chainman.m_blockman.LookupBlockIndex(bad_headers.back().GetHash())) == nullptr);
+
+    // The valid batch is accepted
+    state = BlockValidationState{};
+    const CBlockIndex* pindex{nullptr};
+    BOOST_CHECK(chainman.ProcessNewBlockHeaders(headers, /*min_pow_checked=*/true, state, &pindex));
+    BOOST_REQUIRE(pindex);
+    BOOST_CHECK_EQUAL(pindex->GetBlockHash(), headers.back().GetHash());
+
+    // Fully verified headers are marked so the mix is not recomputed later
+    LOCK(::cs_main);
+    for (const CBlockHeader& header : headers) {
+        const CBlockIndex* index{chainman.m_blockman.LookupBlockIndex(header.GetHash())};
+        BOOST_CHECK(index->nStatus & BLOCK_POW_VERIFIED);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
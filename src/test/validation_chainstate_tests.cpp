@@ -7,6 +7,8 @@
 #include <consensus/validation.h>
 #include <random.h>
 #include <rpc/blockchain.h>
+#include <script/script.h>
+#include <script/solver.h>
 #include <sync.h>
 #include <test/util/chainstate.h>
 #include <test/util/coins.h>
@@ -141,4 +143,80 @@ BOOST_FIXTURE_TEST_CASE(chainstate_update_tip, TestChain100Setup)
     BOOST_CHECK_EQUAL(curr_tip, ::g_best_block);
 }
 
+//! Test setup with partial flushes and no mempool space counted towards the coins cache
+struct PartialFlushSetup : public TestChain100Setup {
+    PartialFlushSetup() : TestChain100Setup{ChainType::REGTEST, {"-partialflush", "-maxmempool=0"}} {}
+};
+
+//! Replaying the blocks after a crash restores the coins written out by
+//! partial flushes of blocks that a reorg then disconnected.
+BOOST_FIXTURE_TEST_CASE(chainstate_partial_flush_reorg_replay, PartialFlushSetup)
+{
+    Chainstate& chainstate{m_node.chainman->ActiveChainstate()};
+    const CScript script_pub_key{GetScriptForRawPubKey(coinbaseKey.GetPubKey())};
+
+    // Make the coins cache count as large for one flush, so that it writes
+    // out its oldest coins instead of flushing them all
+    auto partial_flush = [&] {
+        LOCK(::cs_main);
+        const size_t cache_size{chainstate.m_coinstip_cache_size_bytes};
+        const size_t usage{chainstate.CoinsTip().DynamicMemoryUsage()};
+        const size_t overlay_usage{chainstate.CoinsOverlay().DynamicMemoryUsage()};
+        chainstate.m_coinstip_cache_size_bytes = usage + overlay_usage + usage / 20;
+        BlockValidationState state;
+        BOOST_REQUIRE(chainstate.FlushStateToDisk(state, FlushStateMode::IF_NEEDED));
+        chainstate.m_coinstip_cache_size_bytes = cache_size;
+        BOOST_REQUIRE(chainstate.CoinsDB().GetBestBlock().IsNull());
+    };
+
+    chainstate.ForceFlushStateToDisk();
+    const COutPoint spent_coin{m_coinbase_txns[0]->GetHash(), 0};
+    BOOST_REQUIRE(WITH_LOCK(::cs_main, return chainstate.CoinsDB().HaveCoin(spent_coin)));
+
+    // Branch A spends a coin in its first block. Enough blocks follow that
+    // the first block's coins are the ones written out.
+    const CMutableTransaction spend{CreateValidMempoolTransaction(m_coinbase_txns[0], 0, 1, coinbaseKey, script_pub_key, 1 * COIN, /*submit=*/false)};
+    const CBlock first_a{CreateAndProcessBlock({spend}, script_pub_key)};
+    for (int i = 0; i < 63; ++i) {
+        CreateAndProcessBlock({}, script_pub_key);
+    }
+    partial_flush();
+    {
+        LOCK(::cs_main);
+        BOOST_REQUIRE(!chainstate.CoinsDB().HaveCoin(spent_coin));
+        BOOST_REQUIRE(chainstate.CoinsDB().HaveCoin({first_a.vtx[0]->GetHash(), 0}));
+    }
+
+    // Reorg to branch B, which partially flushes too. The first disconnect
+    // writes the modified coins, but keeps the cache.
+    const COutPoint cached_coin{m_coinbase_txns[1]->GetHash(), 0};
+    const uint256 tip_a{WITH_LOCK(::cs_main, return chainstate.m_chain.Tip()->GetBlockHash())};
+    BOOST_REQUIRE(!WITH_LOCK(::cs_main, return chainstate.CoinsTip().AccessCoin(cached_coin).IsSpent()));
+    CBlockIndex* first_a_index{WITH_LOCK(::cs_main, return m_node.chainman->m_blockman.LookupBlockIndex(first_a.GetHash()))};
+    BlockValidationState state;
+    BOOST_REQUIRE(chainstate.InvalidateBlock(state, first_a_index));
+    {
+        LOCK(::cs_main);
+        BOOST_CHECK_EQUAL(chainstate.CoinsDB().GetBestBlock(), tip_a);
+        BOOST_CHECK(chainstate.CoinsTip().HaveCoinInCache(cached_coin));
+    }
+    std::vector<CBlock> branch_b;
+    for (int i = 0; i < 20; ++i) {
+        branch_b.push_back(CreateAndProcessBlock({}, script_pub_key));
+    }
+    partial_flush();
+
+    // Crash, leaving the rest of the cache unwritten, and replay
+    LOCK(::cs_main);
+    CCoinsViewDB& db{chainstate.CoinsDB()};
+    BOOST_REQUIRE(chainstate.ReplayBlocks());
+    BOOST_CHECK_EQUAL(db.GetBestBlock(), branch_b.back().GetHash());
+    BOOST_CHECK(db.HaveCoin(spent_coin));
+    BOOST_CHECK(!db.HaveCoin({first_a.vtx[0]->GetHash(), 0}));
+    BOOST_CHECK(!db.HaveCoin({first_a.vtx[1]->GetHash(), 0}));
+    for (const CBlock& block : branch_b) {
+        BOOST_CHECK(db.HaveCoin({block.vtx[0]->GetHash(), 0}));
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
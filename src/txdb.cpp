@@ -13,10 +13,12 @@
 #include <random.h>
 #include <serialize.h>
 #include <uint256.h>
+#include <util/thread.h>
 #include <util/vector.h>
 
 #include <cassert>
 #include <cstdlib>
+#include <exception>
 #include <iterator>
 #include <utility>
 
@@ -90,6 +92,14 @@ std::vector<uint256> CCoinsViewDB::GetHeadBlocks() const {
 }
 
 bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, bool erase) {
+    return WriteCoins(mapCoins, hashBlock, erase, /*partial=*/false);
+}
+
+bool CCoinsViewDB::BatchWritePartial(CCoinsMap& mapCoins, const uint256& hashBlock) {
+    return WriteCoins(mapCoins, hashBlock, /*erase=*/true, /*partial=*/true);
+}
+
+bool CCoinsViewDB::WriteCoins(CCoinsMap& mapCoins, const uint256& hashBlock, bool erase, bool partial) {
     CDBBatch batch(*m_db);
     size_t count = 0;
     size_t changed = 0;
@@ -100,10 +110,13 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, boo
         // We may be in the middle of replaying.
         std::vector<uint256> old_heads = GetHeadBlocks();
         if (old_heads.size() == 2) {
-            if (old_heads[0] != hashBlock) {
+            // Partial writes since the last full write move the transition
+            // along with the tip. The chainstate makes a full write before it
+            // disconnects a block, so the tip only moves forward from old_tip.
+            if (old_heads[0] != hashBlock && old_heads[0] != m_partial_head_block) {
                 LogPrintLevel(BCLog::COINDB, BCLog::Level::Error, "The coins database detected an inconsistent state, likely due to a previous crash or shutdown. You will need to restart griffiond with the -reindex-chainstate or -reindex configuration option.\n");
             }
-            assert(old_heads[0] == hashBlock);
+            assert(old_heads[0] == hashBlock || old_heads[0] == m_partial_head_block);
             old_tip = old_heads[1];
         }
     }
@@ -140,9 +153,16 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, boo
         }
     }
 
-    // In the last batch, mark the database as consistent with hashBlock again.
-    batch.Erase(DB_HEAD_BLOCKS);
-    batch.Write(DB_BEST_BLOCK, hashBlock);
+    if (partial) {
+        // Leave the database in the transition from old_tip, which replaying
+        // the blocks up to hashBlock completes after a crash.
+        m_partial_head_block = hashBlock;
+    } else {
+        // In the last batch, mark the database as consistent with hashBlock again.
+        batch.Erase(DB_HEAD_BLOCKS);
+        batch.Write(DB_BEST_BLOCK, hashBlock);
+        m_partial_head_block.SetNull();
+    }
 
     LogPrint(BCLog::COINDB, "Writing final batch of %.2f MiB\n", batch.SizeEstimate() * (1.0 / 1048576.0));
     bool ret = m_db->WriteBatch(batch);
@@ -150,6 +170,103 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, boo
     return ret;
 }
 
+CCoinsViewBackgroundFlush::~CCoinsViewBackgroundFlush()
+{
+    Wait();
+}
+
+bool CCoinsViewBackgroundFlush::GetCoin(const COutPoint& outpoint, Coin& coin) const
+{
+    {
+        LOCK(m_mutex);
+        if (m_batch) {
+            const CCoinsMap& coins{*m_batch->coins};
+            const auto it{coins.find(outpoint)};
+            if (it != coins.end()) {
+                coin = it->second.coin;
+                return !coin.IsSpent();
+            }
+        }
+    }
+    return base->GetCoin(outpoint, coin);
+}
+
+bool CCoinsViewBackgroundFlush::HaveCoin(const COutPoint& outpoint) const
+{
+    Coin coin;
+    return GetCoin(outpoint, coin);
+}
+
+uint256 CCoinsViewBackgroundFlush::GetBestBlock() const
+{
+    {
+        LOCK(m_mutex);
+        if (m_batch) return m_batch->best_block;
+    }
+    return base->GetBestBlock();
+}
+
+bool CCoinsViewBackgroundFlush::BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock, bool erase)
+{
+    if (!Wait()) return false;
+    ++m_write_count;
+    return base->BatchWrite(mapCoins, hashBlock, erase);
+}
+
+bool CCoinsViewBackgroundFlush::BatchWritePartial(CCoinsMap& mapCoins, const uint256& hashBlock)
+{
+    if (!Wait()) return false;
+    ++m_write_count;
+    return base->BatchWritePartial(mapCoins, hashBlock);
+}
+
+bool CCoinsViewBackgroundFlush::FlushInBackground(CCoinsViewCache& cache)
+{
+    if (!Wait()) return false;
+    ++m_write_count;
+    {
+        LOCK(m_mutex);
+        m_batch = std::make_unique<CCoinsBatch>(cache.TakeCoins());
+    }
+    m_writing = true;
+    m_thread = std::thread(&util::TraceThread, "coinsflush", [this] {
+        // The batch is not replaced or destroyed by another thread while this
+        // write is in progress, so it can be used without holding m_mutex.
+        CCoinsBatch* batch{WITH_LOCK(m_mutex, return m_batch.get())};
+        bool ok{false};
+        try {
+            ok = base->BatchWrite(*batch->coins, batch->best_block, /*erase=*/false);
+        } catch (const std::exception& e) {
+            LogPrintf("Error writing coins in the background: %s\n", e.what());
+        }
+        std::unique_ptr<CCoinsBatch> written;
+        {
+            LOCK(m_mutex);
+            if (ok) {
+                written = std::move(m_batch);
+            } else {
+                m_write_ok = false;
+            }
+        }
+        // Free the written coins without blocking lookups.
+        written.reset();
+        m_writing = false;
+    });
+    return true;
+}
+
+bool CCoinsViewBackgroundFlush::Wait()
+{
+    if (m_thread.joinable()) m_thread.join();
+    return WITH_LOCK(m_mutex, return m_write_ok);
+}
+
+size_t CCoinsViewBackgroundFlush::DynamicMemoryUsage() const
+{
+    LOCK(m_mutex);
+    return m_batch ? m_batch->memory_usage : 0;
+}
+
 size_t CCoinsViewDB::EstimateSize() const
 {
     return m_db->EstimateSize(DB_COIN, uint8_t(DB_COIN + 1));
@@ -13,10 +13,12 @@
 #include <sync.h>
 #include <util/fs.h>
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <optional>
+#include <thread>
 #include <vector>
 
 class COutPoint;
@@ -57,6 +59,10 @@ protected:
     DBParams m_db_params;
     CoinsViewOptions m_options;
     std::unique_ptr<CDBWrapper> m_db;
+    //! New head block of the transition left by the last partial write, if any.
+    uint256 m_partial_head_block;
+
+    bool WriteCoins(CCoinsMap& mapCoins, const uint256& hashBlock, bool erase, bool partial);
 public:
     explicit CCoinsViewDB(DBParams db_params, CoinsViewOptions options);
 
@@ -65,6 +71,7 @@ public:
     uint256 GetBestBlock() const override;
     std::vector<uint256> GetHeadBlocks() const override;
     bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, bool erase = true) override;
+    bool BatchWritePartial(CCoinsMap& mapCoins, const uint256& hashBlock) override;
     std::unique_ptr<CCoinsViewCursor> Cursor() const override;
 
     //! Whether an unsupported database format is used.
@@ -78,4 +85,62 @@ public:
     std::optional<fs::path> StoragePath() { return m_db->StoragePath(); }
 };
 
+/**
+ * CCoinsView that writes the coins of a CCoinsViewCache to its base from a
+ * background thread, so that the cache can be used again while the write is
+ * in progress.
+ *
+ * Until the write has completed, lookups of the coins being written are
+ * answered from memory. The base sees a single BatchWrite, so a database
+ * base stays crash consistent through its head blocks as with a synchronous
+ * flush.
+ */
+class CCoinsViewBackgroundFlush final : public CCoinsViewBacked
+{
+private:
+    mutable Mutex m_mutex;
+    //! Coins being written to the base, or whose write failed.
+    std::unique_ptr<CCoinsBatch> m_batch GUARDED_BY(m_mutex);
+    bool m_write_ok GUARDED_BY(m_mutex){true};
+    std::atomic_bool m_writing{false};
+    std::atomic<uint64_t> m_write_count{0};
+    std::thread m_thread;
+
+public:
+    explicit CCoinsViewBackgroundFlush(CCoinsView* view) : CCoinsViewBacked{view} {}
+    ~CCoinsViewBackgroundFlush() override;
+
+    bool GetCoin(const COutPoint& outpoint, Coin& coin) const override;
+    bool HaveCoin(const COutPoint& outpoint) const override;
+    uint256 GetBestBlock() const override;
+    //! Waits for a background write to complete before writing to the base.
+    bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock, bool erase = true) override;
+    bool BatchWritePartial(CCoinsMap& mapCoins, const uint256& hashBlock) override;
+
+    /**
+     * Take the coins out of cache, which must be backed by this view, and
+     * start writing them to the base. Waits for a previous write first.
+     *
+     * @returns false if the previous write failed.
+     */
+    bool FlushInBackground(CCoinsViewCache& cache);
+
+    /**
+     * Wait for a background write to complete.
+     *
+     * @returns false if a background write failed.
+     */
+    bool Wait();
+
+    //! Whether a background write is in progress.
+    bool IsWriting() const { return m_writing; }
+
+    //! Number of writes to the base started through this view. Coins read
+    //! from this view before a write may no longer match the cache above it.
+    uint64_t GetWriteCount() const { return m_write_count; }
+
+    //! Memory used by the coins not yet written to the base.
+    size_t DynamicMemoryUsage() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+};
+
 #endif // GRIFFION_TXDB_H
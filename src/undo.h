@@ -11,8 +11,11 @@
 #include <compressor.h>
 #include <consensus/consensus.h>
 #include <primitives/transaction.h>
+#include <script/script.h>
 #include <serialize.h>
 
+#include <ios>
+
 /** Formatter for undo information for a CTxIn
  *
  *  Contains the prevout's CTxOut being spent, and its metadata as well
@@ -68,4 +71,122 @@ public:
     SERIALIZE_METHODS(CBlockUndo, obj) { READWRITE(obj.vtxundo); }
 };
 
+/** Compact serializer for the scripts of spent coins in compact undo data.
+ *
+ *  The encoding of ScriptCompression is fixed by the chainstate database.
+ *  This one extends it with 3 more special cases:
+ *  * Pay to witness pubkey hash (encoded as 21 bytes)
+ *  * Pay to witness script hash (encoded as 33 bytes)
+ *  * Pay to taproot (encoded as 33 bytes)
+ */
+struct UndoScriptCompression
+{
+    static constexpr unsigned int SPECIAL_P2WPKH{ScriptCompression::nSpecialScripts};
+    static constexpr unsigned int SPECIAL_P2WSH{ScriptCompression::nSpecialScripts + 1};
+    static constexpr unsigned int SPECIAL_P2TR{ScriptCompression::nSpecialScripts + 2};
+    static constexpr unsigned int nSpecialScripts{ScriptCompression::nSpecialScripts + 3};
+
+    template<typename Stream>
+    void Ser(Stream &s, const CScript& script) {
+        CompressedScript compr;
+        if (CompressScript(script, compr)) {
+            s << Span{compr};
+            return;
+        }
+        if (script.size() == 22 && script[0] == OP_0 && script[1] == 20) {
+            s << VARINT(SPECIAL_P2WPKH) << Span{script}.subspan(2);
+            return;
+        }
+        if (script.size() == 34 && (script[0] == OP_0 || script[0] == OP_1) && script[1] == 32) {
+            s << VARINT(script[0] == OP_0 ? SPECIAL_P2WSH : SPECIAL_P2TR) << Span{script}.subspan(2);
+            return;
+        }
+        unsigned int nSize = script.size() + nSpecialScripts;
+        s << VARINT(nSize);
+        s << Span{script};
+    }
+
+    template<typename Stream>
+    void Unser(Stream &s, CScript& script) {
+        unsigned int nSize = 0;
+        s >> VARINT(nSize);
+        if (nSize < ScriptCompression::nSpecialScripts) {
+            CompressedScript vch(GetSpecialScriptSize(nSize), 0x00);
+            s >> Span{vch};
+            DecompressScript(script, nSize, vch);
+            return;
+        }
+        if (nSize < nSpecialScripts) {
+            const unsigned int program_size{nSize == SPECIAL_P2WPKH ? 20U : 32U};
+            script.resize(2 + program_size);
+            script[0] = nSize == SPECIAL_P2TR ? OP_1 : OP_0;
+            script[1] = program_size;
+            s >> Span{script}.subspan(2);
+            return;
+        }
+        nSize -= nSpecialScripts;
+        if (nSize > MAX_SCRIPT_SIZE) {
+            // Overly long script, replace with a short invalid one
+            script << OP_RETURN;
+            s.ignore(nSize);
+        } else {
+            script.resize(nSize);
+            s >> Span{script};
+        }
+    }
+};
+
+/** Compact serialization of the undo data of the block at a given height.
+ *
+ *  Compared to the serialization of CBlockUndo, it
+ *  * stores the height of each spent coin as its distance to the height of
+ *    the block, which is small for the many recently created coins,
+ *  * drops the dummy version of each spent coin, and
+ *  * also compresses the scripts of witness outputs, see UndoScriptCompression.
+ *
+ *  @tparam BlockUndo CBlockUndo to deserialize, const CBlockUndo to serialize
+ */
+template <typename BlockUndo>
+class CompactBlockUndo
+{
+private:
+    BlockUndo& m_undo;
+    const uint32_t m_height;
+
+public:
+    CompactBlockUndo(BlockUndo& undo, int height) : m_undo{undo}, m_height(height) {}
+
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        WriteCompactSize(s, m_undo.vtxundo.size());
+        for (const CTxUndo& txundo : m_undo.vtxundo) {
+            WriteCompactSize(s, txundo.vprevout.size());
+            for (const Coin& coin : txundo.vprevout) {
+                if (coin.nHeight > m_height) throw std::ios_base::failure("CompactBlockUndo: coin spent before its height");
+                s << VARINT((m_height - coin.nHeight) * uint32_t{2} + coin.fCoinBase);
+                s << Using<AmountCompression>(coin.out.nValue) << Using<UndoScriptCompression>(coin.out.scriptPubKey);
+            }
+        }
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        m_undo.vtxundo.clear();
+        for (uint64_t tx_count{ReadCompactSize(s)}; tx_count > 0; --tx_count) {
+            CTxUndo& txundo{m_undo.vtxundo.emplace_back()};
+            for (uint64_t coin_count{ReadCompactSize(s)}; coin_count > 0; --coin_count) {
+                Coin& coin{txundo.vprevout.emplace_back()};
+                uint32_t code{0};
+                s >> VARINT(code);
+                if ((code >> 1) > m_height) throw std::ios_base::failure("CompactBlockUndo: coin height out of range");
+                coin.nHeight = m_height - (code >> 1);
+                coin.fCoinBase = code & 1;
+                s >> Using<AmountCompression>(coin.out.nValue) >> Using<UndoScriptCompression>(coin.out.scriptPubKey);
+            }
+        }
+    }
+};
+
 #endif // GRIFFION_UNDO_H
@@ -12,6 +12,7 @@
 #include <util/threadinterrupt.h>
 #include <util/time.h>
 
+#include <array>
 #include <memory>
 #include <stdexcept>
 #include <string>
@@ -20,6 +21,10 @@
 #include <poll.h>
 #endif
 
+#ifdef USE_EPOLL
+#include <sys/epoll.h>
+#endif
+
 static inline bool IOErrorIsPermanent(int err)
 {
     return err != WSAEAGAIN && err != WSAEINTR && err != WSAEWOULDBLOCK && err != WSAEINPROGRESS;
@@ -243,6 +248,100 @@ bool Sock::WaitMany(std::chrono::milliseconds timeout, EventsPerSock& events_per
 #endif /* USE_POLL */
 }
 
+std::unique_ptr<SockEventRegistry> SockEventRegistry::Make()
+{
+#ifdef USE_EPOLL
+    const int fd{epoll_create1(EPOLL_CLOEXEC)};
+    if (fd == -1) {
+        LogPrintf("Unable to create epoll instance: %s\n", SysErrorString(errno));
+        return nullptr;
+    }
+    return std::unique_ptr<SockEventRegistry>{new SockEventRegistry{fd}};
+#else
+    return nullptr;
+#endif
+}
+
+SockEventRegistry::~SockEventRegistry()
+{
+#ifdef USE_EPOLL
+    close(m_fd);
+#endif
+}
+
+bool SockEventRegistry::Set(const std::shared_ptr<const Sock>& sock, Sock::Event requested)
+{
+#ifdef USE_EPOLL
+    const SOCKET s{sock->m_socket};
+    const auto it{m_registered.find(s)};
+    if (requested == 0) {
+        if (it == m_registered.end()) {
+            return true;
+        }
+        // Do this before dropping our reference, which may close the socket.
+        const bool ok{epoll_ctl(m_fd, EPOLL_CTL_DEL, s, nullptr) == 0};
+        m_registered.erase(it);
+        return ok;
+    }
+    if (it != m_registered.end() && it->second.second == requested) {
+        return true;
+    }
+
+    epoll_event ev{};
+    if (requested & Sock::RECV) {
+        ev.events |= EPOLLIN;
+    }
+    if (requested & Sock::SEND) {
+        ev.events |= EPOLLOUT;
+    }
+    ev.data.fd = s;
+    if (epoll_ctl(m_fd, it == m_registered.end() ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, s, &ev) == -1) {
+        return false;
+    }
+    if (it == m_registered.end()) {
+        m_registered.emplace(s, std::make_pair(sock, requested));
+    } else {
+        it->second.second = requested;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool SockEventRegistry::Wait(std::chrono::milliseconds timeout, Sock::EventsPerSock& events_per_sock)
+{
+    events_per_sock.clear();
+#ifdef USE_EPOLL
+    std::array<epoll_event, MAX_EVENTS_PER_WAIT> evs;
+    const int n{epoll_wait(m_fd, evs.data(), evs.size(), count_milliseconds(timeout))};
+    if (n == -1) {
+        return false;
+    }
+
+    for (int i = 0; i < n; ++i) {
+        const auto it{m_registered.find(evs[i].data.fd)};
+        if (it == m_registered.end()) {
+            continue;
+        }
+        auto& events = events_per_sock.emplace(it->second.first, Sock::Events{it->second.second}).first->second;
+        if (evs[i].events & EPOLLIN) {
+            events.occurred |= Sock::RECV;
+        }
+        if (evs[i].events & EPOLLOUT) {
+            events.occurred |= Sock::SEND;
+        }
+        if (evs[i].events & (EPOLLERR | EPOLLHUP)) {
+            events.occurred |= Sock::ERR;
+        }
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
+
 void Sock::SendComplete(Span<const unsigned char> data,
                         std::chrono::milliseconds timeout,
                         CThreadInterrupt& interrupt) const
@@ -270,6 +270,8 @@ public:
     bool operator==(SOCKET s) const;
 
 protected:
+    friend class SockEventRegistry;
+
     /**
      * Contained socket. `INVALID_SOCKET` designates the object is empty.
      */
@@ -282,6 +284,61 @@ private:
     void Close();
 };
 
+/**
+ * Sockets that are registered once and then waited on many times. Unlike with
+ * `Sock::WaitMany()`, which hands all sockets to the kernel on every call, only
+ * changes in what to wait for are passed on, so the cost of a wait does not grow
+ * with the number of idle sockets. Backed by epoll(7) where available (`USE_EPOLL`).
+ * Not thread safe.
+ */
+class SockEventRegistry
+{
+public:
+    /**
+     * Create an empty registry.
+     * @return nullptr if this is not supported on the platform or by the kernel
+     */
+    static std::unique_ptr<SockEventRegistry> Make();
+
+    ~SockEventRegistry();
+
+    SockEventRegistry(const SockEventRegistry&) = delete;
+    SockEventRegistry& operator=(const SockEventRegistry&) = delete;
+
+    /**
+     * Start, change or stop waiting for events on a socket. A reference to `sock` is
+     * kept while it is registered, for the same reason as in `Sock::EventsPerSock`.
+     * @param[in] sock Socket to register, change or unregister.
+     * @param[in] requested Bitwise-or of `Sock::RECV` and `Sock::SEND`, or 0 to unregister.
+     * @return true on success, false otherwise. A failed registration or change leaves
+     * things as they were, whereas a socket is always unregistered.
+     */
+    [[nodiscard]] bool Set(const std::shared_ptr<const Sock>& sock, Sock::Event requested);
+
+    /**
+     * Wait for the requested events to occur on any of the registered sockets.
+     * @param[in] timeout Wait this long for at least one of the requested events to occur.
+     * @param[out] events_per_sock Cleared, then set to the sockets on which events occurred.
+     * @return true on success (or timeout, if `events_per_sock` is empty), false otherwise
+     */
+    [[nodiscard]] bool Wait(std::chrono::milliseconds timeout, Sock::EventsPerSock& events_per_sock);
+
+    /** Number of registered sockets. */
+    size_t Size() const { return m_registered.size(); }
+
+private:
+    explicit SockEventRegistry(int fd) : m_fd{fd} {}
+
+    /** Maximum number of ready sockets reported by a single `Wait()`; others follow on the next one. */
+    static constexpr int MAX_EVENTS_PER_WAIT{256};
+
+    /** The epoll instance. */
+    const int m_fd;
+
+    /** Registered sockets and what is requested on them, by file descriptor. */
+    std::unordered_map<SOCKET, std::pair<std::shared_ptr<const Sock>, Sock::Event>> m_registered;
+};
+
 /** Return readable error string for a network error code */
 std::string NetworkErrorString(int err);
 
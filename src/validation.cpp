@@ -20,6 +20,7 @@
 #include <consensus/tx_check.h>
 #include <consensus/tx_verify.h>
 #include <consensus/validation.h>
+#include <crypto/ethash/include/ethash/ethash.hpp>
 #include <cuckoocache.h>
 #include <flatfile.h>
 #include <hash.h>
@@ -72,6 +73,7 @@
 #include <numeric>
 #include <optional>
 #include <string>
+#include <system_error>
 #include <tuple>
 #include <utility>
 
@@ -109,6 +111,13 @@ const std::vector<std::string> CHECKLEVEL_DOC {
  * */
 static constexpr int PRUNE_LOCK_BUFFER{10};
 
+/** Number of consecutive outpoints read by one coins fetch on a worker thread. */
+static constexpr size_t COINS_FETCH_BATCH_SIZE{16};
+/** Maximum number of modified coins a partial flush writes to the coins database. */
+static constexpr size_t PARTIAL_FLUSH_MAX_DIRTY_COINS{100000};
+/** Maximum number of blocks whose script checks are verified together by -pipelinedconnect. */
+static constexpr size_t PIPELINED_CONNECT_MAX_BLOCKS{16};
+
 GlobalMutex g_best_block_mutex;
 std::condition_variable g_best_block_cv;
 uint256 g_best_block;
@@ -1707,12 +1716,14 @@ CAmount GetBlockSubsidy(int nHeight, const Consensus::Params& consensusParams)
 
 CoinsViews::CoinsViews(DBParams db_params, CoinsViewOptions options)
     : m_dbview{std::move(db_params), std::move(options)},
-      m_catcherview(&m_dbview) {}
+      m_catcherview(&m_dbview),
+      m_flushview(&m_catcherview) {}
 
 void CoinsViews::InitCache()
 {
     AssertLockHeld(::cs_main);
-    m_cacheview = std::make_unique<CCoinsViewCache>(&m_catcherview);
+    m_cacheview = std::make_unique<CCoinsViewCache>(&m_flushview);
+    m_overlayview = std::make_unique<CCoinsViewCache>(m_cacheview.get());
 }
 
 Chainstate::Chainstate(
@@ -1759,6 +1770,7 @@ void Chainstate::InitCoinsCache(size_t cache_size_bytes)
     assert(m_coins_views != nullptr);
     m_coinstip_cache_size_bytes = cache_size_bytes;
     m_coins_views->InitCache();
+    if (m_chainman.m_options.partial_flush) CoinsTip().TrackUseOrder();
 }
 
 // Note that though this is marked const, we may end up modifying `m_cached_finished_ibd`, which
@@ -1868,18 +1880,31 @@ bool CScriptCheck::operator()() {
     return VerifyScript(scriptSig, m_tx_out.scriptPubKey, witness, nFlags, CachingTransactionSignatureChecker(ptxTo, nIn, m_tx_out.nValue, cacheStore, *txdata), &error);
 }
 
+bool CScriptCheck::operator()(SchnorrSignatureBatch& batch) {
+    const CScript &scriptSig = ptxTo->vin[nIn].scriptSig;
+    const CScriptWitness *witness = &ptxTo->vin[nIn].scriptWitness;
+    return VerifyScript(scriptSig, m_tx_out.scriptPubKey, witness, nFlags, CachingTransactionSignatureChecker(ptxTo, nIn, m_tx_out.nValue, cacheStore, *txdata, &batch), &error);
+}
+
 static CuckooCache::cache<uint256, SignatureCacheHasher> g_scriptExecutionCache;
+static uint256 g_scriptExecutionCacheNonce;
 static CSHA256 g_scriptExecutionCacheHasher;
 
-bool InitScriptExecutionCache(size_t max_size_bytes)
+static void SetScriptExecutionCacheNonce(const uint256& nonce)
 {
-    // Setup the salted hasher
-    uint256 nonce = GetRandHash();
     // We want the nonce to be 64 bytes long to force the hasher to process
     // this chunk, which makes later hash computations more efficient. We
     // just write our 32-byte entropy twice to fill the 64 bytes.
+    g_scriptExecutionCacheNonce = nonce;
+    g_scriptExecutionCacheHasher.Reset();
     g_scriptExecutionCacheHasher.Write(nonce.begin(), 32);
     g_scriptExecutionCacheHasher.Write(nonce.begin(), 32);
+}
+
+bool InitScriptExecutionCache(size_t max_size_bytes)
+{
+    // Setup the salted hasher
+    SetScriptExecutionCacheNonce(GetRandHash());
 
     auto setup_results = g_scriptExecutionCache.setup_bytes(max_size_bytes);
     if (!setup_results) return false;
@@ -1890,6 +1915,23 @@ bool InitScriptExecutionCache(size_t max_size_bytes)
     return true;
 }
 
+SaltedCacheEntries GetScriptExecutionCacheEntries()
+{
+    AssertLockHeld(cs_main);
+    SaltedCacheEntries cache{.salt = g_scriptExecutionCacheNonce, .entries = {}};
+    g_scriptExecutionCache.for_each([&](const uint256& entry) { cache.entries.push_back(entry); });
+    return cache;
+}
+
+void LoadScriptExecutionCacheEntries(const SaltedCacheEntries& cache)
+{
+    AssertLockHeld(cs_main);
+    SetScriptExecutionCacheNonce(cache.salt);
+    for (const uint256& entry : cache.entries) {
+        g_scriptExecutionCache.insert(entry);
+    }
+}
+
 /**
  * Check whether all of this transaction's input scripts succeed.
  *
@@ -2176,19 +2218,46 @@ static SteadyClock::duration time_index{};
 static SteadyClock::duration time_total{};
 static int64_t num_blocks_total = 0;
 
+/**
+ * The script checks of consecutive blocks connected by ConnectTipsPipelined().
+ * The worker threads verify the checks of the blocks connected so far while
+ * the next ones are being connected. Keeps the precomputed transaction data
+ * the checks point to alive until they have been verified.
+ */
+class ScriptCheckPipeline
+{
+private:
+    //! A deque, so that adding a block doesn't move the data of the previous ones.
+    //! Declared before m_control, whose destructor waits for the checks that use it.
+    std::deque<std::vector<PrecomputedTransactionData>> m_txsdata;
+    CCheckQueueControl<CScriptCheck> m_control;
+
+public:
+    explicit ScriptCheckPipeline(CCheckQueue<CScriptCheck>& queue) : m_control{&queue} {}
+
+    //! Return the precomputed data for the transactions of a new block.
+    std::vector<PrecomputedTransactionData>& AddBlock(size_t num_txs) { return m_txsdata.emplace_back(num_txs); }
+
+    void Add(std::vector<CScriptCheck>&& checks) { m_control.Add(std::move(checks)); }
+
+    //! Wait for the checks of all blocks, and return whether they were all successful.
+    bool Wait() { return m_control.Wait(); }
+};
+
 /** Apply the effects of this block (with given index) on the UTXO set represented by coins.
  *  Validity checks that depend on the UTXO set are also done; ConnectBlock()
  *  can fail if those validity checks fail (among other reasons). */
 bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state, CBlockIndex* pindex,
-                               CCoinsViewCache& view, bool fJustCheck)
+                               CCoinsViewCache& view, bool fJustCheck, ScriptCheckPipeline* pipeline,
+                               const CTxMemPool* verified_pool)
 {
     AssertLockHeld(cs_main);
     assert(pindex);
 
-    uint256 hashMix;
-    uint256 block_hash{block.GetHash(hashMix)};
+    uint256 block_hash{block.GetHash()};
     assert(*pindex->phashBlock == block_hash);
     const bool parallel_script_checks{m_chainman.GetCheckQueue().HasThreads()};
+    assert(!pipeline || (parallel_script_checks && !fJustCheck));
 
     const auto time_start{SteadyClock::now()};
     const CChainParams& params{m_chainman.GetParams()};
@@ -2206,7 +2275,10 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
     // is enforced in ContextualCheckBlockHeader(); we wouldn't want to
     // re-enforce that rule here (at least until we make it impossible for
     // the clock to go backward).
-    if (!CheckBlock(block, state, params.GetConsensus(), !fJustCheck, !fJustCheck)) {
+    // The ProgPoW mix of a block whose header was fully verified before does
+    // not need to be recomputed, e.g. when the block is read back from disk.
+    const bool check_pow{!fJustCheck && !(pindex->nStatus & BLOCK_POW_VERIFIED)};
+    if (!CheckBlock(block, state, params.GetConsensus(), check_pow, !fJustCheck)) {
         if (state.GetResult() == BlockValidationResult::BLOCK_MUTATED) {
             // We don't write down blocks to disk if they may have been
             // corrupted, so this should be impossible unless we're having hardware
@@ -2216,6 +2288,11 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
         return error("%s: Consensus::CheckBlock: %s", __func__, state.ToString());
     }
 
+    if (check_pow) {
+        pindex->nStatus |= BLOCK_POW_VERIFIED;
+        m_blockman.m_dirty_blockindex.insert(pindex);
+    }
+
     // verify that the view's current state corresponds to the previous block
     uint256 hashPrevBlock = pindex->pprev == nullptr ? uint256() : pindex->pprev->GetBlockHash();
     assert(hashPrevBlock == view.GetBestBlock());
@@ -2277,6 +2354,12 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
     // Get the script flags for this block
     unsigned int flags{GetBlockScriptFlags(*pindex, m_chainman)};
 
+    // Transactions in the mempool had their scripts checked with the flags of
+    // the tip, which the block builds on.
+    if (verified_pool && (!pindex->pprev || flags != GetBlockScriptFlags(*pindex->pprev, m_chainman))) {
+        verified_pool = nullptr;
+    }
+
     const auto time_2{SteadyClock::now()};
     time_forks += time_2 - time_1;
     LogPrint(BCLog::BENCH, "    - Fork checks: %.2fms [%.2fs (%.2fms/blk)]\n",
@@ -2290,9 +2373,11 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
     // until after `control` has run the script checks (potentially
     // in multiple threads). Preallocate the vector size so a new allocation
     // doesn't invalidate pointers into the vector, and keep txsdata in scope
-    // for as long as `control`.
-    CCheckQueueControl<CScriptCheck> control(fScriptChecks && parallel_script_checks ? &m_chainman.GetCheckQueue() : nullptr);
-    std::vector<PrecomputedTransactionData> txsdata(block.vtx.size());
+    // for as long as `control`. With a pipeline, the checks are waited for
+    // after the function returns, so the pipeline owns the data.
+    CCheckQueueControl<CScriptCheck> control(fScriptChecks && parallel_script_checks && !pipeline ? &m_chainman.GetCheckQueue() : nullptr);
+    std::vector<PrecomputedTransactionData> block_txsdata(pipeline ? 0 : block.vtx.size());
+    std::vector<PrecomputedTransactionData>& txsdata{pipeline ? pipeline->AddBlock(block.vtx.size()) : block_txsdata};
 
     std::vector<int> prevheights;
     CAmount nFees = 0;
@@ -2350,14 +2435,19 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
             std::vector<CScriptCheck> vChecks;
             bool fCacheResults = fJustCheck; /* Don't cache results if we're actually connecting blocks (still consult the cache, though) */
             TxValidationState tx_state;
-            if (fScriptChecks && !CheckInputScripts(tx, tx_state, view, flags, fCacheResults, fCacheResults, txsdata[i], parallel_script_checks ? &vChecks : nullptr)) {
+            const bool verified{verified_pool && verified_pool->exists(GenTxid::Wtxid(tx.GetWitnessHash()))};
+            if (fScriptChecks && !verified && !CheckInputScripts(tx, tx_state, view, flags, fCacheResults, fCacheResults, txsdata[i], parallel_script_checks ? &vChecks : nullptr)) {
                 // Any transaction validation failure in ConnectBlock is a block consensus failure
                 state.Invalid(BlockValidationResult::BLOCK_CONSENSUS,
                               tx_state.GetRejectReason(), tx_state.GetDebugMessage());
                 return error("ConnectBlock(): CheckInputScripts on %s failed with %s",
                     tx.GetHash().ToString(), state.ToString());
             }
-            control.Add(std::move(vChecks));
+            if (pipeline) {
+                pipeline->Add(std::move(vChecks));
+            } else {
+                control.Add(std::move(vChecks));
+            }
         }
 
         CTxUndo undoDummy;
@@ -2406,7 +2496,9 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
              Ticks<SecondsDouble>(time_undo),
              Ticks<MillisecondsDouble>(time_undo) / num_blocks_total);
 
-    if (!pindex->IsValid(BLOCK_VALID_SCRIPTS)) {
+    // The scripts of a pipelined block are only known to be valid once the
+    // pipeline has been waited for.
+    if (!pipeline && !pindex->IsValid(BLOCK_VALID_SCRIPTS)) {
         pindex->RaiseValidity(BLOCK_VALID_SCRIPTS);
         m_blockman.m_dirty_blockindex.insert(pindex);
     }
@@ -2433,6 +2525,140 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
     return true;
 }
 
+/**
+ * The coins spent by a block that were not created within it, in key order.
+ * Reading the coins in key order keeps the reads of a batch in nearby
+ * database blocks.
+ *
+ * @param[in] cache  If set, coins in this cache are left out.
+ */
+static std::vector<COutPoint> GetSpentOutpoints(const CBlock& block, const CCoinsViewCache* cache)
+{
+    std::unordered_set<Txid, SaltedTxidHasher> block_txids;
+    block_txids.reserve(block.vtx.size());
+    for (const auto& tx : block.vtx) {
+        block_txids.insert(tx->GetHash());
+    }
+    std::vector<COutPoint> outpoints;
+    for (const auto& tx : block.vtx) {
+        if (tx->IsCoinBase()) continue;
+        for (const CTxIn& txin : tx->vin) {
+            if (block_txids.count(txin.prevout.hash) == 0 && !(cache && cache->HaveCoinInCache(txin.prevout))) {
+                outpoints.push_back(txin.prevout);
+            }
+        }
+    }
+    std::sort(outpoints.begin(), outpoints.end());
+    return outpoints;
+}
+
+/** Read coins from a view on the worker threads of a queue. */
+static void FetchCoins(CCheckQueue<CCoinsFetch>& queue, const CCoinsView& view, Span<const COutPoint> outpoints, Span<Coin> coins)
+{
+    std::vector<CCoinsFetch> fetches;
+    fetches.reserve((outpoints.size() + COINS_FETCH_BATCH_SIZE - 1) / COINS_FETCH_BATCH_SIZE);
+    for (size_t begin = 0; begin < outpoints.size(); begin += COINS_FETCH_BATCH_SIZE) {
+        const size_t count{std::min(COINS_FETCH_BATCH_SIZE, outpoints.size() - begin)};
+        fetches.emplace_back(view, outpoints.subspan(begin, count), coins.subspan(begin, count));
+    }
+    CCheckQueueControl<CCoinsFetch> control(&queue);
+    control.Add(std::move(fetches));
+    control.Wait();
+}
+
+void Chainstate::PrefetchCoins(const CBlock& block)
+{
+    AssertLockHeld(cs_main);
+
+    CCheckQueue<CCoinsFetch>& queue{m_chainman.GetCoinsFetchQueue()};
+    if (!queue.HasThreads()) return;
+
+    CCoinsViewCache& cache{CoinsTip()};
+    std::vector<COutPoint> outpoints{GetSpentOutpoints(block, &cache)};
+    if (outpoints.empty()) return;
+
+    // The cache's base only changes when the cache is flushed, which needs
+    // cs_main, so the coins read here still match it. A background write
+    // changes the database, but not what the base returns.
+    std::vector<Coin> coins(outpoints.size());
+    FetchCoins(queue, CoinsFlushView(), outpoints, coins);
+
+    for (size_t i = 0; i < outpoints.size(); ++i) {
+        if (!coins[i].IsSpent()) {
+            cache.CacheCoin(outpoints[i], std::move(coins[i]));
+        }
+    }
+}
+
+void Chainstate::StartCoinsPrefetch(const CBlockIndex& index, std::shared_ptr<const CBlock> block)
+{
+    AssertLockHeld(cs_main);
+
+    if (m_coins_prefetch) {
+        if (m_coins_prefetch->index == &index) return;
+        m_coins_prefetch.reset();
+    }
+    CCheckQueue<CCoinsFetch>& queue{m_chainman.GetCoinsFetchQueue()};
+    if (!queue.HasThreads()) return;
+    if (!block && !(index.nStatus & BLOCK_HAVE_DATA)) return;
+
+    // Everything the reads need is looked up here, as they run without
+    // cs_main. The coins views outlive the reads, see m_coins_prefetch.
+    const FlatFilePos block_pos{index.GetBlockPos()};
+    const uint256 block_hash{index.GetBlockHash()};
+    const CCoinsViewBackgroundFlush& view{CoinsFlushView()};
+    const node::BlockManager& blockman{m_blockman};
+    const uint64_t write_count{view.GetWriteCount()};
+    try {
+        auto result{std::async(std::launch::async, [&queue, &view, &blockman, block_pos, block_hash, block = std::move(block)]() mutable {
+            PrefetchedCoins prefetched;
+            if (!block) {
+                auto block_read{std::make_shared<CBlock>()};
+                if (!blockman.ReadBlockFromDisk(*block_read, block_pos) || block_read->GetHash() != block_hash) {
+                    return prefetched;
+                }
+                block = std::move(block_read);
+            }
+            prefetched.outpoints = GetSpentOutpoints(*block, /*cache=*/nullptr);
+            prefetched.coins.resize(prefetched.outpoints.size());
+            FetchCoins(queue, view, prefetched.outpoints, prefetched.coins);
+            prefetched.block = std::move(block);
+            return prefetched;
+        })};
+        m_coins_prefetch.emplace(CoinsPrefetch{&index, write_count, std::move(result)});
+    } catch (const std::system_error& e) {
+        LogPrintf("Failed to start reading coins of block %s: %s\n", block_hash.ToString(), e.what());
+    }
+}
+
+std::shared_ptr<const CBlock> Chainstate::FinishCoinsPrefetch(const CBlockIndex& index)
+{
+    AssertLockHeld(cs_main);
+
+    if (!m_coins_prefetch) return nullptr;
+    std::optional<CoinsPrefetch> prefetch;
+    prefetch.swap(m_coins_prefetch);
+    if (prefetch->index != &index) return nullptr;
+    PrefetchedCoins prefetched{prefetch->result.get()};
+    if (!prefetched.block) return nullptr;
+
+    // A write to the coins database while the coins were read may have moved
+    // coins from the cache to the database, or spent them, so they are only
+    // used if there was none. Coins in the cache are newer and are kept.
+    if (CoinsFlushView().GetWriteCount() == prefetch->write_count) {
+        CCoinsViewCache& cache{CoinsTip()};
+        for (size_t i = 0; i < prefetched.outpoints.size(); ++i) {
+            if (!prefetched.coins[i].IsSpent()) {
+                cache.CacheCoin(prefetched.outpoints[i], std::move(prefetched.coins[i]));
+            }
+        }
+    } else {
+        LogPrint(BCLog::COINDB, "Coins read ahead for block %s were written since, reading them again\n", index.GetBlockHash().ToString());
+        PrefetchCoins(*prefetched.block);
+    }
+    return prefetched.block;
+}
+
 CoinsCacheSizeState Chainstate::GetCoinsCacheSizeState()
 {
     AssertLockHeld(::cs_main);
@@ -2447,7 +2673,10 @@ CoinsCacheSizeState Chainstate::GetCoinsCacheSizeState(
 {
     AssertLockHeld(::cs_main);
     const int64_t nMempoolUsage = m_mempool ? m_mempool->DynamicMemoryUsage() : 0;
-    int64_t cacheSize = CoinsTip().DynamicMemoryUsage();
+    // Coins still being written in the background count towards the cache, and
+    // so does the memory the overlay for block checks keeps between uses.
+    int64_t cacheSize = CoinsTip().DynamicMemoryUsage() + CoinsFlushView().DynamicMemoryUsage() +
+                        Assert(m_coins_views->m_overlayview)->DynamicMemoryUsage();
     int64_t nTotalSpace =
         max_coins_cache_size_bytes + std::max<int64_t>(int64_t(max_mempool_size_bytes) - nMempoolUsage, 0);
 
@@ -2542,10 +2771,31 @@ bool Chainstate::FlushStateToDisk(
         bool fPeriodicWrite = mode == FlushStateMode::PERIODIC && nNow > m_last_write + DATABASE_WRITE_INTERVAL;
         // It's been very long since we flushed the cache. Do this infrequently, to optimize cache usage.
         bool fPeriodicFlush = mode == FlushStateMode::PERIODIC && nNow > m_last_flush + DATABASE_FLUSH_INTERVAL;
+        // Instead of flushing a large cache, write out and evict its least
+        // recently used coins, so that the recently used ones stay cached.
+        // This leaves the coins database in a transition that is completed by
+        // replaying the blocks since the last full flush after a crash, so it
+        // is not done when those blocks could be pruned.
+        bool fPartialFlush = false;
+        if (m_chainman.m_options.partial_flush && !m_blockman.IsPruneMode() && !fCacheCritical && !fPeriodicFlush &&
+            (mode == FlushStateMode::IF_NEEDED || mode == FlushStateMode::PERIODIC) && cache_state >= CoinsCacheSizeState::LARGE) {
+            // Evicted coins free their memory for new ones rather than release
+            // it, so keep the number of coins the cache had when it got large.
+            if (!m_partial_flush_size) m_partial_flush_size = CoinsTip().GetCacheSize();
+            fPartialFlush = CoinsTip().GetCacheSize() >= *m_partial_flush_size;
+            fCacheLarge = false;
+        }
         // Combine all conditions that result in a full cache flush.
         fDoFullFlush = (mode == FlushStateMode::ALWAYS) || fCacheLarge || fCacheCritical || fPeriodicFlush || fFlushForPrune;
+        // A periodic flush can write the coins from a background thread, as
+        // nothing waits for them to be on disk.
+        const bool fBackgroundFlush = m_chainman.m_options.background_flush && mode == FlushStateMode::PERIODIC && !fFlushForPrune;
+        if (fBackgroundFlush && CoinsFlushView().IsWriting()) {
+            // The previous write is still in progress, try again next time.
+            fDoFullFlush = false;
+        }
         // Write blocks and block index to disk.
-        if (fDoFullFlush || fPeriodicWrite) {
+        if (fDoFullFlush || fPeriodicWrite || fPartialFlush) {
             // Ensure we can write block index
             if (!CheckDiskSpace(m_blockman.m_opts.blocks_dir)) {
                 return FatalError(m_chainman.GetNotifications(), state, "Disk space is too low!", _("Disk space is too low!"));
@@ -2577,6 +2827,11 @@ bool Chainstate::FlushStateToDisk(
             }
             m_last_write = nNow;
         }
+        // The overlay for block checks keeps its memory between uses, which
+        // counts towards the cache size, so give it back when making room.
+        if (fDoFullFlush || fPartialFlush) {
+            CoinsOverlay().ReallocateCache();
+        }
         // Flush best chain related state. This can only be done if the blocks / block index write was also done.
         if (fDoFullFlush && !CoinsTip().GetBestBlock().IsNull()) {
             LOG_TIME_MILLIS_WITH_CATEGORY(strprintf("write coins cache to disk (%d coins, %.2fkB)",
@@ -2591,10 +2846,19 @@ bool Chainstate::FlushStateToDisk(
                 return FatalError(m_chainman.GetNotifications(), state, "Disk space is too low!", _("Disk space is too low!"));
             }
             // Flush the chainstate (which may refer to block index entries).
-            if (!CoinsTip().Flush())
-                return FatalError(m_chainman.GetNotifications(), state, "Failed to write to coin database");
+            if (fBackgroundFlush) {
+                if (!CoinsFlushView().FlushInBackground(CoinsTip()))
+                    return FatalError(m_chainman.GetNotifications(), state, "Failed to write to coin database");
+                m_background_flush_locator = m_chain.GetLocator();
+            } else {
+                if (!CoinsTip().Flush())
+                    return FatalError(m_chainman.GetNotifications(), state, "Failed to write to coin database");
+                m_background_flush_locator.reset();
+                full_flush_completed = true;
+            }
             m_last_flush = nNow;
-            full_flush_completed = true;
+            m_partial_flush_size.reset();
+            m_coins_partially_flushed = false;
             TRACE5(utxocache, flush,
                    int64_t{Ticks<std::chrono::microseconds>(SteadyClock::now() - nNow)},
                    (uint32_t)mode,
@@ -2602,10 +2866,31 @@ bool Chainstate::FlushStateToDisk(
                    (uint64_t)coins_mem_usage,
                    (bool)fFlushForPrune);
         }
+        if (fPartialFlush && !CoinsTip().GetBestBlock().IsNull()) {
+            LOG_TIME_MILLIS_WITH_CATEGORY(strprintf("write oldest coins to disk (%d coins, %.2fkB)",
+                coins_count, coins_mem_usage / 1000), BCLog::BENCH);
+
+            if (!CheckDiskSpace(m_chainman.m_options.datadir, 48 * 2 * 2 * PARTIAL_FLUSH_MAX_DIRTY_COINS)) {
+                return FatalError(m_chainman.GetNotifications(), state, "Disk space is too low!", _("Disk space is too low!"));
+            }
+            // Evict a sixteenth more than needed, so that the next few blocks
+            // fit into the freed memory without writing again.
+            const size_t target_size{*m_partial_flush_size - *m_partial_flush_size / 16};
+            if (!CoinsTip().FlushOldest(target_size, PARTIAL_FLUSH_MAX_DIRTY_COINS))
+                return FatalError(m_chainman.GetNotifications(), state, "Failed to write to coin database");
+            m_coins_partially_flushed = true;
+        }
     }
     if (full_flush_completed) {
         // Update best block in wallet (so we can detect restored wallets).
         GetMainSignals().ChainStateFlushed(this->GetRole(), m_chain.GetLocator());
+    } else if (m_background_flush_locator && !CoinsFlushView().IsWriting()) {
+        // A background write has completed since the last call.
+        if (!CoinsFlushView().Wait()) {
+            return FatalError(m_chainman.GetNotifications(), state, "Failed to write to coin database");
+        }
+        GetMainSignals().ChainStateFlushed(this->GetRole(), *m_background_flush_locator);
+        m_background_flush_locator.reset();
     }
     } catch (const std::runtime_error& e) {
         return FatalError(m_chainman.GetNotifications(), state, std::string("System error while flushing: ") + e.what());
@@ -2721,6 +3006,30 @@ bool Chainstate::DisconnectTip(BlockValidationState& state, DisconnectedBlockTra
     AssertLockHeld(cs_main);
     if (m_mempool) AssertLockHeld(m_mempool->cs);
 
+    // Partial flushes leave the coins database in a transition from the last
+    // full flush, which is completed after a crash by replaying the blocks
+    // from there to the new head. That only rolls back to the fork of the
+    // two, so coins written out for blocks disconnected here would be left
+    // behind. End the transition by writing the modified coins, but keep
+    // the cache, as a full flush would wipe it on every reorg.
+    if (m_coins_partially_flushed) {
+        LOG_TIME_MILLIS_WITH_CATEGORY("write modified coins to disk before disconnecting", BCLog::BENCH);
+        if (!CheckDiskSpace(m_chainman.m_options.datadir, 48 * 2 * 2 * CoinsTip().GetCacheSize())) {
+            return FatalError(m_chainman.GetNotifications(), state, "Disk space is too low!", _("Disk space is too low!"));
+        }
+        // The coins database may refer to block index entries.
+        if (!m_blockman.FlushChainstateBlockFile(m_chain.Height())) {
+            LogPrintLevel(BCLog::VALIDATION, BCLog::Level::Warning, "%s: Failed to flush block file.\n", __func__);
+        }
+        if (!m_blockman.WriteBlockIndexDB()) {
+            return FatalError(m_chainman.GetNotifications(), state, "Failed to write to block index database");
+        }
+        if (!CoinsTip().Sync()) {
+            return FatalError(m_chainman.GetNotifications(), state, "Failed to write to coin database");
+        }
+        m_coins_partially_flushed = false;
+    }
+
     CBlockIndex *pindexDelete = m_chain.Tip();
     assert(pindexDelete);
     assert(pindexDelete->pprev);
@@ -2827,26 +3136,33 @@ public:
  *
  * The block is added to connectTrace if connection succeeds.
  */
-bool Chainstate::ConnectTip(BlockValidationState& state, CBlockIndex* pindexNew, const std::shared_ptr<const CBlock>& pblock, ConnectTrace& connectTrace, DisconnectedBlockTransactions& disconnectpool)
+bool Chainstate::ConnectTip(BlockValidationState& state, CBlockIndex* pindexNew, const std::shared_ptr<const CBlock>& pblock, ConnectTrace& connectTrace, DisconnectedBlockTransactions& disconnectpool, const CBlockIndex* pindex_next)
 {
     AssertLockHeld(cs_main);
     if (m_mempool) AssertLockHeld(m_mempool->cs);
 
     assert(pindexNew->pprev == m_chain.Tip());
-    // Read block from disk.
+    // Read block from disk, unless it was read while the previous block was
+    // connected.
     const auto time_1{SteadyClock::now()};
-    std::shared_ptr<const CBlock> pthisBlock;
-    if (!pblock) {
+    std::shared_ptr<const CBlock> pthisBlock{FinishCoinsPrefetch(*pindexNew)};
+    if (pthisBlock) {
+        LogPrint(BCLog::BENCH, "  - Using block read ahead\n");
+        if (pblock) pthisBlock = pblock;
+    } else if (!pblock) {
         std::shared_ptr<CBlock> pblockNew = std::make_shared<CBlock>();
         if (!m_blockman.ReadBlockFromDisk(*pblockNew, *pindexNew)) {
             return FatalError(m_chainman.GetNotifications(), state, "Failed to read block");
         }
         pthisBlock = pblockNew;
+        PrefetchCoins(*pthisBlock);
     } else {
         LogPrint(BCLog::BENCH, "  - Using cached block\n");
         pthisBlock = pblock;
+        PrefetchCoins(*pthisBlock);
     }
     const CBlock& blockConnecting = *pthisBlock;
+    if (pindex_next) StartCoinsPrefetch(*pindex_next, /*block=*/nullptr);
     // Apply the block atomically to the chain state.
     const auto time_2{SteadyClock::now()};
     SteadyClock::time_point time_3;
@@ -2922,6 +3238,100 @@ bool Chainstate::ConnectTip(BlockValidationState& state, CBlockIndex* pindexNew,
     return true;
 }
 
+bool Chainstate::ConnectTipsPipelined(BlockValidationState& state, const std::vector<CBlockIndex*>& blocks, CBlockIndex* pindexMostWork, const std::shared_ptr<const CBlock>& pblock, ConnectTrace& connectTrace, DisconnectedBlockTransactions& disconnectpool, bool& connected)
+{
+    AssertLockHeld(cs_main);
+    if (m_mempool) AssertLockHeld(m_mempool->cs);
+
+    assert(!blocks.empty() && blocks.front()->pprev == m_chain.Tip());
+    connected = false;
+    const auto time_1{SteadyClock::now()};
+    std::vector<std::shared_ptr<const CBlock>> connecting;
+    connecting.reserve(blocks.size());
+    {
+        // Nothing is written to the coins tip before all scripts were
+        // verified, so discarding this view undoes the blocks.
+        CCoinsViewCache pipeline_view(&CoinsTip());
+        ScriptCheckPipeline pipeline{m_chainman.GetCheckQueue()};
+        for (CBlockIndex* pindex : blocks) {
+            assert(connecting.empty() || pindex->pprev == blocks[connecting.size() - 1]);
+            std::shared_ptr<const CBlock> pthisBlock{FinishCoinsPrefetch(*pindex)};
+            if (!pthisBlock) {
+                if (pindex == pindexMostWork && pblock) {
+                    pthisBlock = pblock;
+                } else {
+                    std::shared_ptr<CBlock> pblockNew = std::make_shared<CBlock>();
+                    if (!m_blockman.ReadBlockFromDisk(*pblockNew, *pindex)) {
+                        pipeline.Wait();
+                        return FatalError(m_chainman.GetNotifications(), state, "Failed to read block");
+                    }
+                    pthisBlock = pblockNew;
+                }
+                PrefetchCoins(*pthisBlock);
+            }
+            // The coins the next block spends are read while this one is
+            // connected. Coins it spends that this block creates or spends
+            // are in the pipeline view, which is looked at first.
+            if (connecting.size() + 1 < blocks.size()) {
+                const CBlockIndex* pindex_next{blocks[connecting.size() + 1]};
+                StartCoinsPrefetch(*pindex_next, pindex_next == pindexMostWork ? pblock : nullptr);
+            }
+            CCoinsViewCache view(&pipeline_view);
+            if (!ConnectBlock(*pthisBlock, state, pindex, view, /*fJustCheck=*/false, &pipeline)) {
+                // Checks of this block may have been queued before it failed,
+                // and they point into it, so wait for them before it is freed.
+                pipeline.Wait();
+                if (!state.IsInvalid()) {
+                    return error("%s: ConnectBlock %s failed, %s", __func__, pindex->GetBlockHash().ToString(), state.ToString());
+                }
+                // The blocks connected before may have invalid scripts as
+                // well, so leave it to ConnectTip() to find the first
+                // invalid block.
+                LogPrint(BCLog::VALIDATION, "%s: ConnectBlock %s failed, %s\n", __func__, pindex->GetBlockHash().ToString(), state.ToString());
+                state = BlockValidationState();
+                return true;
+            }
+            bool flushed = view.Flush();
+            assert(flushed);
+            connecting.push_back(std::move(pthisBlock));
+        }
+        if (!pipeline.Wait()) {
+            LogPrint(BCLog::VALIDATION, "%s: script verification of blocks %s to %s failed\n", __func__,
+                     blocks.front()->GetBlockHash().ToString(), blocks.back()->GetBlockHash().ToString());
+            return true;
+        }
+        bool flushed = pipeline_view.Flush();
+        assert(flushed);
+    }
+    const auto time_2{SteadyClock::now()};
+    LogPrint(BCLog::BENCH, "  - Connect %u blocks pipelined: %.2fms (%.2fms/blk)\n", (unsigned)blocks.size(),
+             Ticks<MillisecondsDouble>(time_2 - time_1),
+             Ticks<MillisecondsDouble>(time_2 - time_1) / blocks.size());
+
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        CBlockIndex* pindexNew{blocks[i]};
+        const CBlock& blockConnecting{*connecting[i]};
+        if (!pindexNew->IsValid(BLOCK_VALID_SCRIPTS)) {
+            pindexNew->RaiseValidity(BLOCK_VALID_SCRIPTS);
+            m_blockman.m_dirty_blockindex.insert(pindexNew);
+        }
+        GetMainSignals().BlockChecked(blockConnecting, state);
+        // Remove conflicting transactions from the mempool.
+        if (m_mempool) {
+            m_mempool->removeForBlock(blockConnecting.vtx, pindexNew->nHeight);
+            disconnectpool.removeForBlock(blockConnecting.vtx);
+        }
+        // Update m_chain & related variables.
+        m_chain.SetTip(*pindexNew);
+        UpdateTip(pindexNew);
+        connectTrace.BlockConnected(pindexNew, std::move(connecting[i]));
+    }
+    connected = true;
+
+    // Write the chain state to disk, if necessary.
+    return FlushStateToDisk(state, FlushStateMode::IF_NEEDED);
+}
+
 /**
  * Return the tip of the chain with the most work in it, that isn't
  * known to be invalid (it's however far from certain to be valid).
@@ -3029,6 +3439,12 @@ bool Chainstate::ActivateBestChainStep(BlockValidationState& state, CBlockIndex*
         fBlocksDisconnected = true;
     }
 
+    // The script checks of a background chainstate are not pipelined, as it
+    // has to stop at the snapshot base block.
+    const bool pipelined_connect{m_chainman.m_options.pipelined_connect &&
+                                 m_chainman.GetCheckQueue().HasThreads() &&
+                                 this == &m_chainman.ActiveChainstate()};
+
     // Build list of new blocks to connect (in descending height order).
     std::vector<CBlockIndex*> vpindexToConnect;
     bool fContinue = true;
@@ -3046,9 +3462,34 @@ bool Chainstate::ActivateBestChainStep(BlockValidationState& state, CBlockIndex*
         }
         nHeight = nTargetHeight;
 
+        // Blocks that were connected together and failed are connected one by
+        // one before returning, so that the invalid block is found.
+        size_t reconnect_count{0};
+        if (pipelined_connect && vpindexToConnect.size() > 1) {
+            const size_t count{std::min(vpindexToConnect.size(), PIPELINED_CONNECT_MAX_BLOCKS)};
+            const std::vector<CBlockIndex*> blocks(vpindexToConnect.rbegin(), vpindexToConnect.rbegin() + count);
+            bool connected;
+            if (!ConnectTipsPipelined(state, blocks, pindexMostWork, pblock, connectTrace, disconnectpool, connected)) {
+                // A system error occurred (disk space, database error, ...).
+                MaybeUpdateMempoolForReorg(disconnectpool, false);
+                return false;
+            }
+            if (connected) {
+                PruneBlockIndexCandidates();
+                if (!pindexOldTip || m_chain.Tip()->nChainWork > pindexOldTip->nChainWork) {
+                    // We're in a better position than we were. Return temporarily to release the lock.
+                    fContinue = false;
+                }
+                nHeight = m_chain.Height();
+                continue;
+            }
+            reconnect_count = count;
+        }
+
         // Connect new blocks.
         for (CBlockIndex* pindexConnect : reverse_iterate(vpindexToConnect)) {
-            if (!ConnectTip(state, pindexConnect, pindexConnect == pindexMostWork ? pblock : std::shared_ptr<const CBlock>(), connectTrace, disconnectpool)) {
+            const CBlockIndex* pindex_next{pindexConnect != pindexMostWork ? pindexMostWork->GetAncestor(pindexConnect->nHeight + 1) : nullptr};
+            if (!ConnectTip(state, pindexConnect, pindexConnect == pindexMostWork ? pblock : std::shared_ptr<const CBlock>(), connectTrace, disconnectpool, pindex_next)) {
                 if (state.IsInvalid()) {
                     // The block violates a consensus rule.
                     if (state.GetResult() != BlockValidationResult::BLOCK_MUTATED) {
@@ -3067,7 +3508,8 @@ bool Chainstate::ActivateBestChainStep(BlockValidationState& state, CBlockIndex*
                 }
             } else {
                 PruneBlockIndexCandidates();
-                if (!pindexOldTip || m_chain.Tip()->nChainWork > pindexOldTip->nChainWork) {
+                if (reconnect_count > 0) --reconnect_count;
+                if (reconnect_count == 0 && (!pindexOldTip || m_chain.Tip()->nChainWork > pindexOldTip->nChainWork)) {
                     // We're in a better position than we were. Return temporarily to release the lock.
                     fContinue = false;
                     break;
@@ -3563,16 +4005,31 @@ void ChainstateManager::ReceivedBlockTransactions(const CBlock& block, CBlockInd
 
 static bool CheckBlockHeader(const CBlockHeader& block, BlockValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW = true)
 {
-    uint256 hashMix;
-    if (fCheckPOW && !CheckProofOfWork(block.GetHash(hashMix), block.nBits, consensusParams))
+    // The block hash is the final hash computed from the claimed hashMix, so
+    // checking it against the target is cheap and rejects low-work headers
+    // without computing the ProgPoW mix.
+    if (fCheckPOW && !CheckProofOfWork(block.GetHash(), block.nBits, consensusParams))
         return state.Invalid(BlockValidationResult::BLOCK_INVALID_HEADER, "high-hash", "proof of work failed");
-        
-    if (fCheckPOW && hashMix != block.hashMix)
+
+    if (fCheckPOW && !CheckProofOfWorkMix(block, consensusParams))
         return state.Invalid(BlockValidationResult::BLOCK_INVALID_HEADER, "invalid-hash-mix", "hashMix validity failed");
 
     return true;
 }
 
+bool CPowCheck::operator()()
+{
+    return CheckBlockHeader(*m_header, m_result->emplace(), *m_consensus_params);
+}
+
+bool CCoinsFetch::operator()()
+{
+    for (size_t i = 0; i < m_outpoints.size(); ++i) {
+        m_view->GetCoin(m_outpoints[i], m_coins[i]);
+    }
+    return true;
+}
+
 static bool CheckMerkleRoot(const CBlock& block, BlockValidationState& state)
 {
     if (block.m_checked_merkle_root) return true;
@@ -3755,8 +4212,11 @@ std::vector<unsigned char> ChainstateManager::GenerateCoinbaseCommitment(CBlock&
 
 bool HasValidProofOfWork(const std::vector<CBlockHeader>& headers, const Consensus::Params& consensusParams)
 {
-    return std::all_of(headers.cbegin(), headers.cend(),
-            [&](const auto& header) { return CheckProofOfWork(header.GetHash(), header.nBits, consensusParams);});
+    const std::vector<uint256> hashes{ETHash(headers)};
+    for (size_t i = 0; i < headers.size(); ++i) {
+        if (!CheckProofOfWork(hashes[i], headers[i].nBits, consensusParams)) return false;
+    }
+    return true;
 }
 
 bool IsBlockMutated(const CBlock& block, bool check_witness_root)
@@ -3916,7 +4376,7 @@ static bool ContextualCheckBlock(const CBlock& block, BlockValidationState& stat
     return true;
 }
 
-bool ChainstateManager::AcceptBlockHeader(const CBlockHeader& block, BlockValidationState& state, CBlockIndex** ppindex, bool min_pow_checked)
+bool ChainstateManager::AcceptBlockHeader(const CBlockHeader& block, BlockValidationState& state, CBlockIndex** ppindex, bool min_pow_checked, const BlockValidationState* pow_result)
 {
     AssertLockHeld(cs_main);
 
@@ -3936,7 +4396,13 @@ bool ChainstateManager::AcceptBlockHeader(const CBlockHeader& block, BlockValida
             return true;
         }
 
-        if (!CheckBlockHeader(block, state, GetConsensus())) {
+        if (pow_result) {
+            if (!pow_result->IsValid()) {
+                state = *pow_result;
+                LogPrint(BCLog::VALIDATION, "%s: Consensus::CheckBlockHeader: %s, %s\n", __func__, hash.ToString(), state.ToString());
+                return false;
+            }
+        } else if (!CheckBlockHeader(block, state, GetConsensus())) {
             LogPrint(BCLog::VALIDATION, "%s: Consensus::CheckBlockHeader: %s, %s\n", __func__, hash.ToString(), state.ToString());
             return false;
         }
@@ -4003,6 +4469,15 @@ bool ChainstateManager::AcceptBlockHeader(const CBlockHeader& block, BlockValida
     }
     CBlockIndex* pindex{m_blockman.AddToBlockIndex(block, m_best_header)};
 
+    // Remember that the full proof of work was checked, so it does not have
+    // to be recomputed when the block is connected or after a restart.
+    if (hash != GetConsensus().hashGenesisBlock) {
+        pindex->nStatus |= BLOCK_POW_VERIFIED;
+        m_blockman.m_dirty_blockindex.insert(pindex);
+    }
+
+    PrepareNextEpoch(pindex->nHeight);
+
     if (ppindex)
         *ppindex = pindex;
 
@@ -4026,15 +4501,57 @@ bool ChainstateManager::AcceptBlockHeader(const CBlockHeader& block, BlockValida
     return true;
 }
 
+void ChainstateManager::PrepareNextEpoch(int height) const
+{
+    const int blocks_left{KAWPOW_EPOCH_LENGTH - height % KAWPOW_EPOCH_LENGTH};
+    if (blocks_left <= m_options.epoch_prefetch_blocks) {
+        ethash::prepare_global_epoch_context(ethash::get_epoch_number(height) + 1);
+    }
+}
+
+std::vector<std::optional<BlockValidationState>> ChainstateManager::CheckHeadersProofOfWork(const std::vector<CBlockHeader>& headers)
+{
+    AssertLockNotHeld(cs_main);
+
+    std::vector<std::optional<BlockValidationState>> results(headers.size());
+    std::vector<CPowCheck> checks;
+    {
+        LOCK(cs_main);
+        checks.reserve(headers.size());
+        for (size_t i = 0; i < headers.size(); ++i) {
+            if (m_blockman.m_block_index.count(headers[i].GetHash()) == 0) {
+                checks.emplace_back(headers[i], GetConsensus(), results[i]);
+            }
+        }
+    }
+
+    // Run the checks on the script verification threads rather than on a
+    // pool of their own. A block being connected meanwhile is waited for.
+    CCheckQueueControl<CScriptCheck> control(&m_script_check_queue);
+    control.AddTasks(checks.size(), [&checks](size_t i) { return checks[i](); });
+    control.Wait();
+    return results;
+}
+
 // Exposed wrapper for AcceptBlockHeader
 bool ChainstateManager::ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, bool min_pow_checked, BlockValidationState& state, const CBlockIndex** ppindex)
 {
     AssertLockNotHeld(cs_main);
+
+    // Computing the ProgPoW mix dominates header validation. Do it for the
+    // whole batch on the worker threads before taking cs_main, and hand each
+    // header's result to AcceptBlockHeader so that an invalid header is
+    // reported without verifying the batch a second time.
+    std::vector<std::optional<BlockValidationState>> pow_results;
+    if (headers.size() > 1 && m_script_check_queue.HasThreads()) {
+        pow_results = CheckHeadersProofOfWork(headers);
+    }
     {
         LOCK(cs_main);
-        for (const CBlockHeader& header : headers) {
+        for (size_t i = 0; i < headers.size(); ++i) {
+            const BlockValidationState* pow_result{i < pow_results.size() && pow_results[i] ? &*pow_results[i] : nullptr};
             CBlockIndex *pindex = nullptr; // Use a temp pindex instead of ppindex to avoid a const_cast
-            bool accepted{AcceptBlockHeader(header, state, &pindex, min_pow_checked)};
+            bool accepted{AcceptBlockHeader(headers[i], state, &pindex, min_pow_checked, pow_result)};
             CheckBlockIndex();
 
             if (!accepted) {
@@ -4239,14 +4756,14 @@ bool TestBlockValidity(BlockValidationState& state,
                        const CBlock& block,
                        CBlockIndex* pindexPrev,
                        bool fCheckPOW,
-                       bool fCheckMerkleRoot)
+                       bool fCheckMerkleRoot,
+                       const CTxMemPool* verified_pool)
 {
     AssertLockHeld(cs_main);
     assert(pindexPrev && pindexPrev == chainstate.m_chain.Tip());
-    CCoinsViewCache viewNew(&chainstate.CoinsTip());
-    
-    uint256 hashMix;
-    uint256 block_hash(block.GetHash(hashMix));
+    CCoinsViewCache& viewNew{chainstate.CoinsOverlay()};
+
+    uint256 block_hash(block.GetHash());
     CBlockIndex indexDummy(block);
     indexDummy.pprev = pindexPrev;
     indexDummy.nHeight = pindexPrev->nHeight + 1;
@@ -4259,7 +4776,7 @@ bool TestBlockValidity(BlockValidationState& state,
         return error("%s: Consensus::CheckBlock: %s", __func__, state.ToString());
     if (!ContextualCheckBlock(block, state, chainstate.m_chainman, pindexPrev))
         return error("%s: Consensus::ContextualCheckBlock: %s", __func__, state.ToString());
-    if (!chainstate.ConnectBlock(block, state, &indexDummy, viewNew, true)) {
+    if (!chainstate.ConnectBlock(block, state, &indexDummy, viewNew, /*fJustCheck=*/true, /*pipeline=*/nullptr, verified_pool)) {
         return false;
     }
     assert(state.IsValid());
@@ -5099,7 +5616,12 @@ bool Chainstate::ResizeCoinsCaches(size_t coinstip_size, size_t coinsdb_size)
     size_t old_coinstip_size = m_coinstip_cache_size_bytes;
     m_coinstip_cache_size_bytes = coinstip_size;
     m_coinsdb_cache_size_bytes = coinsdb_size;
+    // Resizing reopens the database, so background reads and writes have to
+    // complete first. A failed write is reported by the next flush.
+    m_coins_prefetch.reset();
+    (void)CoinsFlushView().Wait();
     CoinsDB().ResizeCache(coinsdb_size);
+    m_partial_flush_size.reset();
 
     LogPrintf("[%s] resized coinsdb cache to %.1f MiB\n",
         this->ToString(), coinsdb_size * (1.0 / 1024 / 1024));
@@ -5794,6 +6316,7 @@ static ChainstateManager::Options&& Flatten(ChainstateManager::Options&& opts)
 
 ChainstateManager::ChainstateManager(const util::SignalInterrupt& interrupt, Options options, node::BlockManager::Options blockman_options)
     : m_script_check_queue{/*batch_size=*/128, options.worker_threads_num},
+      m_coins_fetch_queue{/*batch_size=*/1, options.worker_threads_num, /*thread_name=*/"coinsfetch"},
       m_interrupt{interrupt},
       m_options{Flatten(std::move(options))},
       m_blockman{interrupt, std::move(blockman_options)}
@@ -5804,6 +6327,12 @@ ChainstateManager::~ChainstateManager()
 {
     LOCK(::cs_main);
 
+    // Coins read ahead use the coins fetch queue and the block manager, which
+    // are destroyed before the chainstates.
+    for (Chainstate* chainstate : {m_ibd_chainstate.get(), m_snapshot_chainstate.get()}) {
+        if (chainstate) chainstate->m_coins_prefetch.reset();
+    }
+
     m_versionbitscache.Clear();
 }
 
@@ -5857,6 +6386,7 @@ util::Result<void> Chainstate::InvalidateCoinsDBOnDisk()
     fs::path snapshot_datadir = GetSnapshotCoinsDBPath(*this);
 
     // Coins views no longer usable.
+    m_coins_prefetch.reset();
     m_coins_views.reset();
 
     auto invalid_path = snapshot_datadir + "_INVALID";
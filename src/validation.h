@@ -21,7 +21,9 @@
 #include <policy/feerate.h>
 #include <policy/packages.h>
 #include <policy/policy.h>
+#include <pubkey.h>
 #include <script/script_error.h>
+#include <span.h>
 #include <sync.h>
 #include <txdb.h>
 #include <txmempool.h> // For CTxMemPool::cs
@@ -34,6 +36,7 @@
 #include <versionbits.h>
 
 #include <atomic>
+#include <future>
 #include <map>
 #include <memory>
 #include <optional>
@@ -51,6 +54,8 @@ class ChainstateManager;
 struct ChainTxData;
 class DisconnectedBlockTransactions;
 struct PrecomputedTransactionData;
+struct SaltedCacheEntries;
+class ScriptCheckPipeline;
 struct LockPoints;
 struct AssumeutxoData;
 namespace node {
@@ -352,6 +357,16 @@ public:
 
     bool operator()();
 
+    //! Schnorr signatures of checks run on a CCheckQueue are verified in batches.
+    using Batch = SchnorrSignatureBatch;
+
+    /**
+     * Run the check, adding Schnorr signatures missing from the signature
+     * cache to batch instead of verifying them. The check only passes if the
+     * batch verifies as well.
+     */
+    bool operator()(SchnorrSignatureBatch& batch);
+
     ScriptError GetScriptError() const { return error; }
 };
 
@@ -360,22 +375,78 @@ static_assert(std::is_nothrow_move_assignable_v<CScriptCheck>);
 static_assert(std::is_nothrow_move_constructible_v<CScriptCheck>);
 static_assert(std::is_nothrow_destructible_v<CScriptCheck>);
 
+/**
+ * Closure representing the context-free proof-of-work check of one block
+ * header. Computing the ProgPoW mix is expensive, so the checks for a batch of
+ * headers are run in parallel before the headers are accepted one by one.
+ * The outcome is stored in the given result, which stays empty if the check
+ * is skipped because an earlier one failed.
+ */
+class CPowCheck
+{
+private:
+    const CBlockHeader* m_header;
+    const Consensus::Params* m_consensus_params;
+    std::optional<BlockValidationState>* m_result;
+
+public:
+    CPowCheck(const CBlockHeader& header, const Consensus::Params& consensus_params, std::optional<BlockValidationState>& result) :
+        m_header(&header), m_consensus_params(&consensus_params), m_result(&result) { }
+
+    bool operator()();
+};
+
+/**
+ * Closure reading a run of coins from the coins database, so that the coins
+ * spent by a block are loaded in parallel instead of one at a time while the
+ * block is connected. Outpoints that are not found leave their coin spent.
+ */
+class CCoinsFetch
+{
+private:
+    const CCoinsView* m_view;
+    Span<const COutPoint> m_outpoints;
+    Span<Coin> m_coins;
+
+public:
+    CCoinsFetch(const CCoinsView& view, Span<const COutPoint> outpoints, Span<Coin> coins) :
+        m_view(&view), m_outpoints(outpoints), m_coins(coins) { }
+
+    bool operator()();
+};
+
 /** Initializes the script-execution cache */
 [[nodiscard]] bool InitScriptExecutionCache(size_t max_size_bytes);
 
+/** Get the salt and the entries of the script-execution cache, to save them. */
+SaltedCacheEntries GetScriptExecutionCacheEntries() EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+/**
+ * Switch the script-execution cache to the salt of saved entries and add them
+ * to it. Entries computed with the previous salt can no longer be found.
+ */
+void LoadScriptExecutionCacheEntries(const SaltedCacheEntries& cache) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
 /** Functions for validating blocks and updating the block tree */
 
 /** Context-independent validity checks */
 bool CheckBlock(const CBlock& block, BlockValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW = true, bool fCheckMerkleRoot = true);
 
-/** Check a block is completely valid from start to finish (only works on top of our current best block) */
+/**
+ * Check a block is completely valid from start to finish (only works on top of our current best block)
+ *
+ * @param[in] verified_pool  If set, the scripts of the block's transactions that are in this
+ *                           mempool are trusted, as they were checked when the transactions
+ *                           were accepted. Used for block templates built from the mempool.
+ */
 bool TestBlockValidity(BlockValidationState& state,
                        const CChainParams& chainparams,
                        Chainstate& chainstate,
                        const CBlock& block,
                        CBlockIndex* pindexPrev,
                        bool fCheckPOW = true,
-                       bool fCheckMerkleRoot = true) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+                       bool fCheckMerkleRoot = true,
+                       const CTxMemPool* verified_pool = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
 /** Check with the proof of work on each blockheader matches the value in nBits */
 bool HasValidProofOfWork(const std::vector<CBlockHeader>& headers, const Consensus::Params& consensusParams);
@@ -447,11 +518,19 @@ public:
     //! This view wraps access to the leveldb instance and handles read errors gracefully.
     CCoinsViewErrorCatcher m_catcherview GUARDED_BY(cs_main);
 
+    //! This view writes the cache to the database in the background if -backgroundflush is set.
+    CCoinsViewBackgroundFlush m_flushview GUARDED_BY(cs_main);
+
     //! This is the top layer of the cache hierarchy - it keeps as many coins in memory as
     //! can fit per the dbcache setting.
     std::unique_ptr<CCoinsViewCache> m_cacheview GUARDED_BY(cs_main);
 
-    //! This constructor initializes CCoinsViewDB and CCoinsViewErrorCatcher instances, but it
+    //! Scratch layer on top of m_cacheview that blocks are checked against
+    //! without being connected. Its changes are never written to m_cacheview.
+    std::unique_ptr<CCoinsViewCache> m_overlayview GUARDED_BY(cs_main);
+
+    //! This constructor initializes the CCoinsViewDB, CCoinsViewErrorCatcher and
+    //! CCoinsViewBackgroundFlush instances, but it
     //! *does not* create a CCoinsViewCache instance by default. This is done separately because the
     //! presence of the cache has implications on whether or not we're allowed to flush the cache's
     //! state to disk, which should not be done until the health of the database is verified.
@@ -459,7 +538,7 @@ public:
     //! All arguments forwarded onto CCoinsViewDB.
     CoinsViews(DBParams db_params, CoinsViewOptions options);
 
-    //! Initialize the CCoinsViewCache member.
+    //! Initialize the CCoinsViewCache members.
     void InitCache() EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
 };
 
@@ -599,6 +678,21 @@ public:
         return *Assert(m_coins_views->m_cacheview);
     }
 
+    /**
+     * @returns A reference to an empty overlay of the in-memory UTXO set
+     *     cache, for checking a block on top of the tip. Coins are copied into
+     *     the overlay when they are first looked up or changed, and changes
+     *     are discarded by the next call. The overlay keeps its memory between
+     *     uses, so repeated checks do not allocate it again.
+     */
+    CCoinsViewCache& CoinsOverlay() EXCLUSIVE_LOCKS_REQUIRED(::cs_main)
+    {
+        AssertLockHeld(::cs_main);
+        CCoinsViewCache& overlay{*Assert(Assert(m_coins_views)->m_overlayview)};
+        overlay.Reset();
+        return overlay;
+    }
+
     //! @returns A reference to the on-disk UTXO set database.
     CCoinsViewDB& CoinsDB() EXCLUSIVE_LOCKS_REQUIRED(::cs_main)
     {
@@ -620,8 +714,20 @@ public:
         return Assert(m_coins_views)->m_catcherview;
     }
 
+    //! @returns A reference to the view between the in-memory cache and the
+    //!     database, which holds the coins being written in the background.
+    CCoinsViewBackgroundFlush& CoinsFlushView() EXCLUSIVE_LOCKS_REQUIRED(::cs_main)
+    {
+        AssertLockHeld(::cs_main);
+        return Assert(m_coins_views)->m_flushview;
+    }
+
     //! Destructs all objects related to accessing the UTXO set.
-    void ResetCoinsViews() { m_coins_views.reset(); }
+    void ResetCoinsViews() EXCLUSIVE_LOCKS_REQUIRED(::cs_main)
+    {
+        m_coins_prefetch.reset();
+        m_coins_views.reset();
+    }
 
     //! Does this chainstate have a UTXO set attached?
     bool HasCoinsViews() const { return (bool)m_coins_views; }
@@ -690,8 +796,49 @@ public:
     // Block (dis)connection on a given view:
     DisconnectResult DisconnectBlock(const CBlock& block, const CBlockIndex* pindex, CCoinsViewCache& view)
         EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+    /**
+     * If pipeline is set, the block's script checks are added to it instead of
+     * being waited for, and the block is not marked as having valid scripts.
+     *
+     * If verified_pool is set, the scripts of transactions that are in it are
+     * not checked again, as long as the block uses the script flags of the
+     * tip they were checked with when they were accepted. Only for blocks on
+     * top of the tip the pool is consistent with.
+     */
     bool ConnectBlock(const CBlock& block, BlockValidationState& state, CBlockIndex* pindex,
-                      CCoinsViewCache& view, bool fJustCheck = false) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+                      CCoinsViewCache& view, bool fJustCheck = false,
+                      ScriptCheckPipeline* pipeline = nullptr,
+                      const CTxMemPool* verified_pool = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+    /**
+     * Load the coins spent by a block into the coins tip cache before
+     * ConnectBlock() looks them up. Coins missing from the cache are read
+     * from the database on the worker threads, in key order. Outpoints created
+     * within the block itself are skipped.
+     */
+    void PrefetchCoins(const CBlock& block) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+    /**
+     * Start reading a block and the coins it spends, as PrefetchCoins() does,
+     * on a background thread that does not hold cs_main, so that the reads
+     * overlap with connecting the block before it. The cache can not be
+     * looked at from there, so cached coins are read as well. Only one block
+     * is read ahead at a time; one read ahead before is waited for and
+     * dropped.
+     *
+     * @param[in] block  The block, if it is in memory already.
+     */
+    void StartCoinsPrefetch(const CBlockIndex& index, std::shared_ptr<const CBlock> block) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+    /**
+     * Wait for the reads StartCoinsPrefetch() started for a block, and add
+     * the coins read to the coins tip cache. If the coins database was
+     * written since the reads started, the coins may be stale, so they are
+     * dropped and PrefetchCoins() reads them again.
+     *
+     * @returns the block, or nullptr if it was not read ahead.
+     */
+    std::shared_ptr<const CBlock> FinishCoinsPrefetch(const CBlockIndex& index) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
     // Apply the effects of a block disconnection on the UTXO set.
     bool DisconnectTip(BlockValidationState& state, DisconnectedBlockTransactions* disconnectpool) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_mempool->cs);
@@ -752,7 +899,26 @@ public:
 
 private:
     bool ActivateBestChainStep(BlockValidationState& state, CBlockIndex* pindexMostWork, const std::shared_ptr<const CBlock>& pblock, bool& fInvalidFound, ConnectTrace& connectTrace) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_mempool->cs);
-    bool ConnectTip(BlockValidationState& state, CBlockIndex* pindexNew, const std::shared_ptr<const CBlock>& pblock, ConnectTrace& connectTrace, DisconnectedBlockTransactions& disconnectpool) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_mempool->cs);
+    /**
+     * Connect a block on top of the tip.
+     *
+     * @param[in] pindex_next  The block that is connected next, if known.
+     *                         It is read ahead while this one is connected.
+     */
+    bool ConnectTip(BlockValidationState& state, CBlockIndex* pindexNew, const std::shared_ptr<const CBlock>& pblock, ConnectTrace& connectTrace, DisconnectedBlockTransactions& disconnectpool, const CBlockIndex* pindex_next = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_mempool->cs);
+    /**
+     * Connect consecutive blocks, starting at the child of the tip, on top of
+     * each other before any of their scripts have been verified, so that the
+     * coins of a block are looked up while the worker threads verify the
+     * previous ones (see -pipelinedconnect). The blocks are only applied to the
+     * chain state, in order, once all their scripts are found valid.
+     *
+     * @param[out] connected  Whether the blocks were applied. If not, none of
+     *                        them was, and they have to be connected one by
+     *                        one to find out which is invalid.
+     * @returns true unless a system error occurred
+     */
+    bool ConnectTipsPipelined(BlockValidationState& state, const std::vector<CBlockIndex*>& blocks, CBlockIndex* pindexMostWork, const std::shared_ptr<const CBlock>& pblock, ConnectTrace& connectTrace, DisconnectedBlockTransactions& disconnectpool, bool& connected) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_mempool->cs);
 
     void InvalidBlockFound(CBlockIndex* pindex, const BlockValidationState& state) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
     CBlockIndex* FindMostWorkChain() EXCLUSIVE_LOCKS_REQUIRED(cs_main);
@@ -785,6 +951,27 @@ private:
 
     SteadyClock::time_point m_last_write{};
     SteadyClock::time_point m_last_flush{};
+    //! Chain tip of a background coins write whose completion has not been signalled yet.
+    std::optional<CBlockLocator> m_background_flush_locator GUARDED_BY(::cs_main);
+    //! Number of coins at which partial flushes keep the coins cache, set when it first gets large.
+    std::optional<size_t> m_partial_flush_size GUARDED_BY(::cs_main);
+    //! Whether coins were written out by a partial flush since the last full flush.
+    bool m_coins_partially_flushed GUARDED_BY(::cs_main){false};
+
+    //! A block and the coins it spends, read by StartCoinsPrefetch().
+    struct PrefetchedCoins {
+        std::shared_ptr<const CBlock> block;
+        std::vector<COutPoint> outpoints;
+        std::vector<Coin> coins;
+    };
+    struct CoinsPrefetch {
+        const CBlockIndex* index;
+        //! CoinsFlushView()'s write count when the reads started.
+        uint64_t write_count;
+        std::future<PrefetchedCoins> result;
+    };
+    //! Destroyed before m_coins_views, as the reads use the coins views.
+    std::optional<CoinsPrefetch> m_coins_prefetch GUARDED_BY(::cs_main);
 
     /**
      * In case of an invalid snapshot, rename the coins leveldb directory so
@@ -895,12 +1082,15 @@ private:
      * Caller must set min_pow_checked=true in order to add a new header to the
      * block index (permanent memory storage), indicating that the header is
      * known to be part of a sufficiently high-work chain (anti-dos check).
+     * If pow_result is set, it is the outcome of CheckBlockHeader computed
+     * earlier by CheckHeadersProofOfWork, and is used instead of checking again.
      */
     bool AcceptBlockHeader(
         const CBlockHeader& block,
         BlockValidationState& state,
         CBlockIndex** ppindex,
-        bool min_pow_checked) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+        bool min_pow_checked,
+        const BlockValidationState* pow_result = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
     friend Chainstate;
 
     /** Most recent headers presync progress update, for rate-limiting. */
@@ -920,6 +1110,27 @@ private:
     //! A queue for script verifications that have to be performed by worker threads.
     CCheckQueue<CScriptCheck> m_script_check_queue;
 
+    //! A queue for coins database reads that warm the coins cache before a block is connected.
+    CCheckQueue<CCoinsFetch> m_coins_fetch_queue;
+
+    /**
+     * Verify the proof-of-work of a batch of headers on the worker threads.
+     *
+     * @returns the outcome of CheckBlockHeader for each header, in the same
+     *          order. Results are left empty for headers that are already in
+     *          the block index, and for those skipped after another header
+     *          failed; these are checked again when they are accepted.
+     */
+    std::vector<std::optional<BlockValidationState>> CheckHeadersProofOfWork(const std::vector<CBlockHeader>& headers) EXCLUSIVE_LOCKS_REQUIRED(!cs_main);
+
+    /**
+     * Start building the ProgPoW light cache of the next epoch in the
+     * background once a header at the given height is within
+     * epoch_prefetch_blocks of it, so that the first header of the epoch
+     * does not wait for it.
+     */
+    void PrepareNextEpoch(int height) const;
+
 public:
     using Options = kernel::ChainstateManagerOpts;
 
@@ -1271,6 +1482,7 @@ public:
     std::optional<int> GetSnapshotBaseHeight() const EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
 
     CCheckQueue<CScriptCheck>& GetCheckQueue() { return m_script_check_queue; }
+    CCheckQueue<CCoinsFetch>& GetCoinsFetchQueue() { return m_coins_fetch_queue; }
 
     ~ChainstateManager();
 };
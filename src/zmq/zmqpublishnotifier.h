@@ -11,8 +11,9 @@
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <memory>
+#include <vector>
 
-class CBlock;
 class CBlockIndex;
 class CTransaction;
 
@@ -50,11 +51,11 @@ public:
 class CZMQPublishRawBlockNotifier : public CZMQAbstractPublishNotifier
 {
 private:
-    const std::function<bool(CBlock&, const CBlockIndex&)> m_get_block_by_index;
+    const std::function<std::shared_ptr<const std::vector<uint8_t>>(const CBlockIndex&)> m_get_raw_block_by_index;
 
 public:
-    CZMQPublishRawBlockNotifier(std::function<bool(CBlock&, const CBlockIndex&)> get_block_by_index)
-        : m_get_block_by_index{std::move(get_block_by_index)} {}
+    CZMQPublishRawBlockNotifier(std::function<std::shared_ptr<const std::vector<uint8_t>>(const CBlockIndex&)> get_raw_block_by_index)
+        : m_get_raw_block_by_index{std::move(get_raw_block_by_index)} {}
     bool NotifyBlock(const CBlockIndex *pindex) override;
 };
 
@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+# Copyright (c) 2024 The Griffion Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test the cache of recently served blocks (-blockcachesize).
+
+Blocks served through getblock and REST are read through the cache, and its
+statistics are reported by getnettotals. Blocks served through getdata are
+covered by the getdata_block_cache unit test.
+"""
+import http.client
+import urllib.parse
+
+from test_framework.test_framework import GriffionTestFramework
+from test_framework.util import (
+    assert_equal,
+    assert_greater_than,
+)
+from test_framework.wallet import (
+    MiniWallet,
+    MiniWalletMode,
+)
+
+
+class BlockCacheTest(GriffionTestFramework):
+    def set_test_params(self):
+        self.setup_clean_chain = True
+        self.num_nodes = 2
+        self.extra_args = [
+            ["-rest"],
+            ["-rest", "-blockcachesize=0"],
+        ]
+
+    def setup_network(self):
+        # Unconnected, so that only the requests of the test use the caches
+        self.setup_nodes()
+
+    def rest_block(self, node, blockhash, ext):
+        url = urllib.parse.urlparse(node.url)
+        conn = http.client.HTTPConnection(url.hostname, url.port)
+        conn.request('GET', f'/rest/block/{blockhash}.{ext}')
+        resp = conn.getresponse()
+        assert_equal(resp.status, 200)
+        return resp.read()
+
+    def assert_stats_delta(self, node, before, *, hits, misses):
+        stats = node.getnettotals()["blockcache"]
+        assert_equal(stats["hits"] - before["hits"], hits)
+        assert_equal(stats["misses"] - before["misses"], misses)
+        return stats
+
+    def run_test(self):
+        for node in self.nodes:
+            wallet = MiniWallet(node, mode=MiniWalletMode.RAW_P2PK)
+            # Mined in batches, as mining is slow enough to hit the RPC timeout
+            for _ in range(11):
+                self.generate(wallet, 10, sync_fun=self.no_op)
+        self.test_cache()
+        self.test_disabled()
+
+    def test_cache(self):
+        node = self.nodes[0]
+        stats = node.getnettotals()["blockcache"]
+        assert_equal(stats["max_bytes"], 64 << 20)
+
+        self.log.info("Test that getblock reads through the cache")
+        blockhash = node.getblockhash(100)
+        raw_block = node.getblock(blockhash, 0)
+        blocks = stats["blocks"]
+        stats = self.assert_stats_delta(node, stats, hits=0, misses=1)
+        assert_equal(stats["blocks"], blocks + 1)
+        assert_greater_than(stats["bytes"], len(raw_block) // 2)
+        assert_equal(node.getblock(blockhash, 0), raw_block)
+        stats = self.assert_stats_delta(node, stats, hits=1, misses=0)
+
+        self.log.info("Test that the deserialized block is cached separately in the same entry")
+        assert_equal(node.getblock(blockhash, 1)["hash"], blockhash)
+        stats = self.assert_stats_delta(node, stats, hits=0, misses=1)
+        assert_equal(stats["blocks"], blocks + 1)
+        node.getblock(blockhash, 2)
+        stats = self.assert_stats_delta(node, stats, hits=1, misses=0)
+
+        self.log.info("Test that REST reads through the cache")
+        assert_equal(self.rest_block(node, blockhash, "bin").hex(), raw_block)
+        stats = self.assert_stats_delta(node, stats, hits=1, misses=0)
+        assert_equal(self.rest_block(node, blockhash, "hex").decode().strip(), raw_block)
+        stats = self.assert_stats_delta(node, stats, hits=1, misses=0)
+        other_hash = node.getblockhash(101)
+        other_raw_block = self.rest_block(node, other_hash, "bin").hex()
+        stats = self.assert_stats_delta(node, stats, hits=0, misses=1)
+        assert_equal(node.getblock(other_hash, 0), other_raw_block)
+        stats = self.assert_stats_delta(node, stats, hits=1, misses=0)
+        self.rest_block(node, other_hash, "json")
+        self.assert_stats_delta(node, stats, hits=0, misses=1)
+
+    def test_disabled(self):
+        self.log.info("Test that -blockcachesize=0 disables the cache")
+        node = self.nodes[1]
+        blockhash = node.getblockhash(100)
+        raw_block = node.getblock(blockhash, 0)
+        assert_equal(node.getblock(blockhash, 0), raw_block)
+        assert_equal(node.getblock(blockhash, 1)["hash"], blockhash)
+        assert_equal(self.rest_block(node, blockhash, "bin").hex(), raw_block)
+        assert_equal(node.getnettotals()["blockcache"], {
+            "hits": 0,
+            "misses": 0,
+            "blocks": 0,
+            "bytes": 0,
+            "max_bytes": 0,
+        })
+
+
+if __name__ == '__main__':
+    BlockCacheTest().main()
@@ -206,6 +206,8 @@ class ZMQTest (GriffionTestFramework):
             # Should receive the generated raw block.
             block = rawblock.receive()
             assert_equal(genhashes[x], hash256_reversed(block[:80]).hex())
+            # Published through the block cache, it matches the stored block.
+            assert_equal(block.hex(), self.nodes[0].getblock(genhashes[x], 0))
 
             # Should receive the generated block hash.
             hash = hashblock.receive().hex()